@@ -15,6 +15,7 @@
 #include "../../morphoTreeAdjust/include/AdjacencyRelation.hpp"
 #include "../../morphoTreeAdjust/include/AttributeComputer.hpp"
 #include "../../morphoTreeAdjust/include/Common.hpp"
+#include "../../morphoTreeAdjust/include/ComponentTreeCasf.hpp"
 #include "../../morphoTreeAdjust/include/DynamicComponentTree.hpp"
 #include "../../morphoTreeAdjust/include/DualMinMaxTreeIncrementalFilterInstrumented.hpp"
 
@@ -540,6 +541,35 @@ static void BM_component_tree_casf_naive_area(benchmark::State &state, Benchmark
     }
 }
 
+static void BM_component_tree_casf_lazy_ownership(benchmark::State &state, BenchmarkImageModel model) {
+    const int size = static_cast<int>(state.range(0));
+    const int numThresholds = static_cast<int>(state.range(1));
+    const bool lazyOwnership = state.range(2) != 0;
+    const auto image = make_benchmark_image(model, size, size);
+    const auto thresholds = make_area_thresholds(size * size, numThresholds);
+
+    ComponentTreeCasf<uint8_t> eager(image, 1.0);
+    ComponentTreeCasf<uint8_t> lazy(image, 1.0);
+    lazy.setLazyProperPartOwnership(true);
+    if (!eager.filter(thresholds)->isEqual(lazy.filter(thresholds))) {
+        state.SkipWithError("Lazy and eager ownership must give the same CASF output.");
+        return;
+    }
+
+    state.SetLabel(benchmark_case_label(model, numThresholds));
+    state.counters["lazy_ownership"] = benchmark::Counter(lazyOwnership ? 1.0 : 0.0);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        ComponentTreeCasf<uint8_t> runner(image, 1.0);
+        runner.setLazyProperPartOwnership(lazyOwnership);
+        state.ResumeTiming();
+        const auto output = runner.filter(thresholds);
+        benchmark::DoNotOptimize(output->rawData());
+        benchmark::ClobberMemory();
+    }
+}
+
 // Threshold rounds span a short sequence, a moderate CASF stack, and deeper
 // runs where the incremental strategy tends to amortize its setup cost.
 BENCHMARK_CAPTURE(BM_component_tree_casf_area, structured, BenchmarkImageModel::structured)->ArgsProduct(make_benchmark_argument_product());
@@ -550,4 +580,11 @@ BENCHMARK_CAPTURE(BM_component_tree_casf_naive_area, structured, BenchmarkImageM
 BENCHMARK_CAPTURE(BM_component_tree_casf_naive_area, natural_like, BenchmarkImageModel::natural_like)->ArgsProduct(make_benchmark_argument_product());
 BENCHMARK_CAPTURE(BM_component_tree_casf_naive_area, piecewise_scene, BenchmarkImageModel::piecewise_scene)->ArgsProduct(make_benchmark_argument_product());
 
+// Lazy ownership against eager ownership on the same updating sequences;
+// the tree builds are left out of the timing.
+BENCHMARK_CAPTURE(BM_component_tree_casf_lazy_ownership, structured, BenchmarkImageModel::structured)
+    ->ArgsProduct({benchmark::CreateRange(128, 1024, 2), {32}, {0, 1}});
+BENCHMARK_CAPTURE(BM_component_tree_casf_lazy_ownership, piecewise_scene, BenchmarkImageModel::piecewise_scene)
+    ->ArgsProduct({benchmark::CreateRange(128, 1024, 2), {32}, {0, 1}});
+
 } // namespace
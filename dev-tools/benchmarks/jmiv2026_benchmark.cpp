@@ -658,7 +658,7 @@ static FlatzonePartition computeFlatzonePartition(ImageUInt8Ptr image, const Adj
         queue.push(p);
         while (!queue.empty()) {
             const int q = queue.pop();
-            for (int n : adj->getNeighborPixels(q)) {
+            for (int n : adj->getNeighborRange(q)) {
                 if (partition.labelByPixel[static_cast<std::size_t>(n)] < 0 && data[n] == data[q]) {
                     partition.labelByPixel[static_cast<std::size_t>(n)] = nextLabel;
                     queue.push(n);
@@ -680,7 +680,7 @@ static long long computePixelBordersFromMask(ImageUInt8Ptr image,
     long long count = 0;
     for (PixelId p : pixels) {
         bool isBorder = false;
-        for (PixelId q : adj->getNeighborPixels(p)) {
+        for (PixelId q : adj->getNeighborRange(p)) {
             if (mask[static_cast<std::size_t>(q)] == 0 || data[q] != data[p]) {
                 isBorder = true;
                 break;
@@ -0,0 +1,11 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/dev-tools
+# Build directory: /root/repo/dev-tools/build/MorphoTreeAdjust/dev-tools/benchmark_component_tree_casf_smoke
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(benchmark_component_tree_casf_smoke "/usr/bin/cmake" "-DMTA_ROOT_DIR=/root/repo/dev-tools/.." "-P" "/root/repo/dev-tools/cmake/run_benchmark_component_tree_casf_smoke.cmake")
+set_tests_properties(benchmark_component_tree_casf_smoke PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/dev-tools/CMakeLists.txt;99;add_test;/root/repo/dev-tools/CMakeLists.txt;0;")
+subdirs("unit-tests")
+subdirs("tools")
+subdirs("benchmarks")
@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/dev-tools/external/stb/stb_image.cpp" "benchmarks/CMakeFiles/benchmark_component_tree_casf.dir/__/external/stb/stb_image.cpp.o" "gcc" "benchmarks/CMakeFiles/benchmark_component_tree_casf.dir/__/external/stb/stb_image.cpp.o.d"
+  "/root/repo/dev-tools/benchmarks/benchmark_component_tree_casf.cpp" "benchmarks/CMakeFiles/benchmark_component_tree_casf.dir/benchmark_component_tree_casf.cpp.o" "gcc" "benchmarks/CMakeFiles/benchmark_component_tree_casf.dir/benchmark_component_tree_casf.cpp.o.d"
+  "/root/repo/dev-tools/benchmarks/google_benchmark_main.cpp" "benchmarks/CMakeFiles/benchmark_component_tree_casf.dir/google_benchmark_main.cpp.o" "gcc" "benchmarks/CMakeFiles/benchmark_component_tree_casf.dir/google_benchmark_main.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/benchmark_component_tree_casf.dir/__/external/stb/stb_image.cpp.o"
+  "CMakeFiles/benchmark_component_tree_casf.dir/__/external/stb/stb_image.cpp.o.d"
+  "CMakeFiles/benchmark_component_tree_casf.dir/benchmark_component_tree_casf.cpp.o"
+  "CMakeFiles/benchmark_component_tree_casf.dir/benchmark_component_tree_casf.cpp.o.d"
+  "CMakeFiles/benchmark_component_tree_casf.dir/google_benchmark_main.cpp.o"
+  "CMakeFiles/benchmark_component_tree_casf.dir/google_benchmark_main.cpp.o.d"
+  "benchmark_component_tree_casf"
+  "benchmark_component_tree_casf.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/benchmark_component_tree_casf.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
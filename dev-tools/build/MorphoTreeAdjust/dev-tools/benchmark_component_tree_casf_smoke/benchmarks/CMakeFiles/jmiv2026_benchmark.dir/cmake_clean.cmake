@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/jmiv2026_benchmark.dir/__/external/stb/stb_image.cpp.o"
+  "CMakeFiles/jmiv2026_benchmark.dir/__/external/stb/stb_image.cpp.o.d"
+  "CMakeFiles/jmiv2026_benchmark.dir/jmiv2026_benchmark.cpp.o"
+  "CMakeFiles/jmiv2026_benchmark.dir/jmiv2026_benchmark.cpp.o.d"
+  "jmiv2026_benchmark"
+  "jmiv2026_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/jmiv2026_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
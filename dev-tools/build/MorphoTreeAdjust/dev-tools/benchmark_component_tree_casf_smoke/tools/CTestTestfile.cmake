@@ -0,0 +1,6 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/dev-tools/tools
+# Build directory: /root/repo/dev-tools/build/MorphoTreeAdjust/dev-tools/benchmark_component_tree_casf_smoke/tools
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
@@ -2,7 +2,11 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
 #include <cmath>
+#include <cstdlib>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -14,6 +18,10 @@
 class AdjacencyRelation;  // forward declaration
 using AdjacencyRelationPtr = std::shared_ptr<AdjacencyRelation>;
 
+struct Adjacency4;
+struct Adjacency8;
+struct GenericAdjacency;
+
 /**
  * @brief 2D grid adjacency relation with a symmetric stencil and efficient iteration.
  *
@@ -24,11 +32,27 @@ using AdjacencyRelationPtr = std::shared_ptr<AdjacencyRelation>;
  * adjacency. It also offers a "forward" variant that emits only half of the
  * neighbors, which is useful for asymmetric scans and unique-edge
  * construction.
+ *
+ * Two iteration styles are available. The `get*Pixels` methods configure a
+ * cursor stored inside the relation and return the relation itself as the
+ * range; they are kept for the existing API but are not reentrant. The const
+ * `get*Range` methods return a `NeighborRange` value that carries the queried
+ * position, so a single relation can be shared by tree builds, adjusters,
+ * and attribute passes running on different threads.
  */
 class AdjacencyRelation {
 public:
     using Offset = std::pair<int, int>; // (deltaRow, deltaCol)
 
+    /**
+     * @brief Stencils that have a compile-time specialization.
+     */
+    enum class Connectivity {
+        Generic,
+        Four,
+        Eight,
+    };
+
 private:
     using OffsetKey = std::int64_t;
 
@@ -46,6 +70,13 @@ private:
     std::vector<int> offsetRow;
     std::vector<int> offsetCol;
     std::vector<uint8_t> forwardMask; // "forward" mask per offset i: true if (dy>0) || (dy==0 && dx>0)
+    std::vector<int> neighborOffsets;        // linear offsets of the non-origin entries, in stencil order
+    std::vector<int> forwardNeighborOffsets; // linear offsets of the forward entries, in stencil order
+    int interiorRowBegin = 0; // pixels with row/col in [begin, end) have every offset in bounds
+    int interiorRowEnd = 0;
+    int interiorColBegin = 0;
+    int interiorColEnd = 0;
+    Connectivity connectivity = Connectivity::Generic;
     std::unordered_set<OffsetKey> offsetLookup;
 
     static OffsetKey encodeOffset(int dy, int dx) noexcept;
@@ -54,6 +85,9 @@ private:
     static std::vector<Offset> buildRectangularOffsets(int halfHeight, int halfWidth);
     static std::vector<Offset> normalizeOffsets(const std::vector<Offset> &offsets);
     void initialize(int numRows, int numCols, const std::vector<Offset> &offsets, double radiusValue);
+    inline int nextValidFrom(int row, int col, int index, bool forwardOnly) const noexcept;
+    inline bool isInteriorAt(int row, int col) const noexcept;
+    inline std::pair<int, int> split(int index) const noexcept;
 
 
 public:
@@ -84,7 +118,7 @@ public:
     /**
      * @brief Returns the number of offsets in the current stencil.
      */
-    int getSize();
+    int getSize() const;
     /**
      * @brief Configures (row,col) and prepares adjacency iteration without a forward filter. This method includes the origin.
      */
@@ -111,6 +145,64 @@ public:
      */
     AdjacencyRelation& getNeighborPixelsForward(int index);
 
+    class NeighborRange;
+
+    /**
+     * @brief Returns the in-bounds neighbors of (row,col), excluding the origin.
+     * @details Unlike `getNeighborPixels`, this method does not touch the
+     * relation: the returned range carries its own position, so one relation
+     * can be shared by concurrent readers.
+     */
+    inline NeighborRange getNeighborRange(int row, int col) const noexcept;
+    /**
+     * @brief Linear-index version of `getNeighborRange`.
+     */
+    inline NeighborRange getNeighborRange(int index) const noexcept;
+    /**
+     * @brief Const, stateless counterpart of `getNeighborPixelsForward`.
+     */
+    inline NeighborRange getNeighborRangeForward(int index) const noexcept;
+    /**
+     * @brief Const, stateless counterpart of `getAdjPixels`. Includes the origin.
+     */
+    inline NeighborRange getAdjRange(int index) const noexcept;
+
+    /**
+     * @brief Indicates whether every offset of the stencil stays inside the image at `index`.
+     * @details Interior pixels are the ones for which neighbor iteration uses
+     * the precomputed linear offsets without bounds checks.
+     */
+    inline bool isInterior(int index) const noexcept;
+
+    /**
+     * @brief Reports whether the stencil matches one of the compile-time stencils.
+     * @details Detection compares the normalized offsets, so `rectangular(r, c, 1, 1)`
+     * is recognized as 8-connectivity just like radius 1.5.
+     */
+    Connectivity getConnectivity() const noexcept {
+        return connectivity;
+    }
+
+    /**
+     * @brief Calls `fn(stencil)` with `Adjacency4`, `Adjacency8`, or `GenericAdjacency`.
+     * @details Lets a whole neighbor loop be instantiated once per stencil
+     * type and selected at runtime, so 4- and 8-connectivity loops are fully
+     * unrolled while arbitrary offsets keep the generic path. All stencil
+     * types expose `static void forEachNeighbor(const AdjacencyRelation &, int, Visitor &&)`
+     * and visit neighbors in the same order.
+     */
+    template<typename Fn>
+    decltype(auto) withStencil(Fn &&fn) const;
+
+    /**
+     * @brief Calls `visitor(q)` for every in-bounds neighbor `q` of `index`, excluding the origin.
+     * @details Visits the neighbors in the same order as `getNeighborRange`.
+     * Interior pixels take a branch-free loop over the precomputed linear
+     * offsets; only border pixels pay for the per-offset bounds checks.
+     */
+    template<typename Visitor>
+    void forEachNeighbor(int index, Visitor &&visitor) const;
+
     /**
      * @brief Checks adjacency by linear indices (p,q).
      */
@@ -122,18 +214,24 @@ public:
     /**
      * @brief Returns the radius in use. For non-circular adjacencies, returns a negative value.
      */
-    double getRadius();
+    double getRadius() const;
     /**
      * @brief Indicates whether the adjacency was built from a circular radius.
      */
     bool hasRadius() const noexcept;
 
-    int getOffsetRow(int index){
+    int getOffsetRow(int index) const {
         return offsetRow[index];
     }
-    int getOffsetCol(int index){
+    int getOffsetCol(int index) const {
         return offsetCol[index];
     }
+    int getNumRows() const noexcept {
+        return numRows;
+    }
+    int getNumCols() const noexcept {
+        return numCols;
+    }
     
     /**
      * @brief Lightweight iterator for traversing neighbors already configured via `get*`.
@@ -178,6 +276,97 @@ public:
      * @brief End marker for neighbor iteration.
      */
    IteratorAdjacency end();	 
+
+    /**
+     * @brief Value-type range over the neighbors of one pixel.
+     *
+     * Holds a const pointer to the relation plus the queried position, so
+     * several ranges over the same relation can be iterated at the same time.
+     * For interior pixels the range walks a precomputed list of linear
+     * offsets; border pixels fall back to the bounds-checked stencil scan.
+     */
+    class NeighborRange {
+    public:
+        class Iterator {
+        private:
+            const AdjacencyRelation *relation_;
+            const int *interiorOffsets_; // null on the checked (border) path
+            int pixel_;
+            int row_;
+            int col_;
+            int index_;
+            bool forwardOnly_;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = int;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator(const AdjacencyRelation *relation, const int *interiorOffsets, int pixel, int row, int col, int index, bool forwardOnly) noexcept
+                : relation_(relation), interiorOffsets_(interiorOffsets), pixel_(pixel), row_(row), col_(col), index_(index), forwardOnly_(forwardOnly) {}
+
+            Iterator &operator++() noexcept {
+                if (interiorOffsets_ != nullptr) {
+                    ++index_;
+                } else {
+                    index_ = relation_->nextValidFrom(row_, col_, index_ + 1, forwardOnly_);
+                }
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const noexcept { return index_ == other.index_; }
+            bool operator!=(const Iterator &other) const noexcept { return index_ != other.index_; }
+
+            int operator*() const noexcept {
+                if (interiorOffsets_ != nullptr) {
+                    return pixel_ + interiorOffsets_[index_];
+                }
+                return (row_ + relation_->offsetRow[index_]) * relation_->numCols + (col_ + relation_->offsetCol[index_]);
+            }
+        };
+
+    private:
+        const AdjacencyRelation *relation_;
+        const int *interiorOffsets_;
+        int numInteriorOffsets_;
+        int pixel_;
+        int row_;
+        int col_;
+        int firstIndex_;
+        bool forwardOnly_;
+
+    public:
+        NeighborRange(const AdjacencyRelation *relation, int row, int col, int firstIndex, bool forwardOnly) noexcept
+            : relation_(relation),
+              interiorOffsets_(nullptr),
+              numInteriorOffsets_(0),
+              pixel_(row * relation->numCols + col),
+              row_(row),
+              col_(col),
+              firstIndex_(firstIndex),
+              forwardOnly_(forwardOnly) {
+            // The origin-including range keeps the checked path; it is not used on hot loops.
+            if (firstIndex == 1 && relation->isInteriorAt(row, col)) {
+                const auto &offsets = forwardOnly ? relation->forwardNeighborOffsets : relation->neighborOffsets;
+                interiorOffsets_ = offsets.data();
+                numInteriorOffsets_ = static_cast<int>(offsets.size());
+            }
+        }
+
+        Iterator begin() const noexcept {
+            if (interiorOffsets_ != nullptr) {
+                return Iterator(relation_, interiorOffsets_, pixel_, row_, col_, 0, forwardOnly_);
+            }
+            return Iterator(relation_, nullptr, pixel_, row_, col_, relation_->nextValidFrom(row_, col_, firstIndex_, forwardOnly_), forwardOnly_);
+        }
+
+        Iterator end() const noexcept {
+            if (interiorOffsets_ != nullptr) {
+                return Iterator(relation_, interiorOffsets_, pixel_, row_, col_, numInteriorOffsets_, forwardOnly_);
+            }
+            return Iterator(relation_, nullptr, pixel_, row_, col_, relation_->n, forwardOnly_);
+        }
+    };
 };
 
 inline AdjacencyRelation::OffsetKey AdjacencyRelation::encodeOffset(int dy, int dx) noexcept {
@@ -316,10 +505,16 @@ inline void AdjacencyRelation::initialize(int numRows, int numCols, const std::v
     this->offsetLookup.clear();
     this->offsetLookup.reserve(normalizedOffsets.size());
 
+    this->neighborOffsets.clear();
+    this->forwardNeighborOffsets.clear();
+    int reachRow = 0;
+    int reachCol = 0;
     for (int i = 0; i < this->n; ++i) {
         this->offsetRow[i] = normalizedOffsets[static_cast<size_t>(i)].first;
         this->offsetCol[i] = normalizedOffsets[static_cast<size_t>(i)].second;
         this->offsetLookup.insert(encodeOffset(this->offsetRow[i], this->offsetCol[i]));
+        reachRow = std::max(reachRow, std::abs(this->offsetRow[i]));
+        reachCol = std::max(reachCol, std::abs(this->offsetCol[i]));
 
         if (i == 0) {
             continue;
@@ -328,7 +523,29 @@ inline void AdjacencyRelation::initialize(int numRows, int numCols, const std::v
         const int offsetDx = this->offsetCol[i];
         const int offsetDy = this->offsetRow[i];
         this->forwardMask[i] = (offsetDy > 0 || (offsetDy == 0 && offsetDx > 0)) ? 1 : 0;
+
+        const int linearOffset = offsetDy * numCols + offsetDx;
+        this->neighborOffsets.push_back(linearOffset);
+        if (this->forwardMask[i]) {
+            this->forwardNeighborOffsets.push_back(linearOffset);
+        }
     }
+
+    if (this->neighborOffsets.size() == 4 || this->neighborOffsets.size() == 8) {
+        static constexpr Offset fourOffsets[] = {{0, -1}, {-1, 0}, {0, 1}, {1, 0}};
+        static constexpr Offset eightOffsets[] = {{0, -1}, {-1, -1}, {-1, 0}, {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}};
+        const bool isFour = this->n == 5 && std::equal(normalizedOffsets.begin() + 1, normalizedOffsets.end(), std::begin(fourOffsets));
+        const bool isEight = this->n == 9 && std::equal(normalizedOffsets.begin() + 1, normalizedOffsets.end(), std::begin(eightOffsets));
+        this->connectivity = isFour ? Connectivity::Four : (isEight ? Connectivity::Eight : Connectivity::Generic);
+    } else {
+        this->connectivity = Connectivity::Generic;
+    }
+
+    // The interior may be empty when the stencil is wider than the image.
+    this->interiorRowBegin = reachRow;
+    this->interiorRowEnd = std::max(reachRow, numRows - reachRow);
+    this->interiorColBegin = reachCol;
+    this->interiorColEnd = std::max(reachCol, numCols - reachCol);
 }
 
 inline AdjacencyRelation::AdjacencyRelation(int numRows, int numCols, double radius) {
@@ -343,11 +560,11 @@ inline AdjacencyRelation AdjacencyRelation::rectangular(int numRows, int numCols
     return AdjacencyRelation(numRows, numCols, buildRectangularOffsets(halfHeight, halfWidth));
 }
 
-inline int AdjacencyRelation::getSize() {
+inline int AdjacencyRelation::getSize() const {
     return this->n;
 }
 
-inline double AdjacencyRelation::getRadius() {
+inline double AdjacencyRelation::getRadius() const {
     return this->radius;
 }
 
@@ -358,37 +575,77 @@ inline bool AdjacencyRelation::hasRadius() const noexcept {
 inline bool AdjacencyRelation::isAdjacent(int px, int py, int qx, int qy) const noexcept {
     const int dx = px - qx;
     const int dy = py - qy;
+    switch (connectivity) {
+        case Connectivity::Four:
+            return std::abs(dx) + std::abs(dy) <= 1;
+        case Connectivity::Eight:
+            return std::abs(dx) <= 1 && std::abs(dy) <= 1;
+        case Connectivity::Generic:
+            break;
+    }
     return offsetLookup.find(encodeOffset(dy, dx)) != offsetLookup.end();
 }
 
 inline bool AdjacencyRelation::isAdjacent(int p, int q) const noexcept {
-    const int py = p / numCols;
-    const int px = p % numCols;
-    const int qy = q / numCols;
-    const int qx = q % numCols;
-
+    const auto [py, px] = split(p);
+    const auto [qy, qx] = split(q);
     return isAdjacent(px, py, qx, qy);
 }
 
-inline int AdjacencyRelation::nextValid() {
-    id += 1;
-    while (id < n) {
-        if (forwardOnly && !forwardMask[id]) {
-            id += 1;
+inline std::pair<int, int> AdjacencyRelation::split(int index) const noexcept {
+    const int row = index / numCols;
+    return {row, index - row * numCols};
+}
+
+inline bool AdjacencyRelation::isInteriorAt(int row, int col) const noexcept {
+    return static_cast<unsigned>(row - interiorRowBegin) < static_cast<unsigned>(interiorRowEnd - interiorRowBegin) &&
+           static_cast<unsigned>(col - interiorColBegin) < static_cast<unsigned>(interiorColEnd - interiorColBegin);
+}
+
+inline bool AdjacencyRelation::isInterior(int index) const noexcept {
+    const auto [row, col] = split(index);
+    return isInteriorAt(row, col);
+}
+
+template<typename Visitor>
+inline void AdjacencyRelation::forEachNeighbor(int index, Visitor &&visitor) const {
+    const auto [row, col] = split(index);
+    if (isInteriorAt(row, col)) {
+        const int *offsets = neighborOffsets.data();
+        const int count = static_cast<int>(neighborOffsets.size());
+        for (int i = 0; i < count; ++i) {
+            visitor(index + offsets[i]);
+        }
+        return;
+    }
+    for (int i = nextValidFrom(row, col, 1, false); i < n; i = nextValidFrom(row, col, i + 1, false)) {
+        visitor((row + offsetRow[i]) * numCols + (col + offsetCol[i]));
+    }
+}
+
+inline int AdjacencyRelation::nextValidFrom(int row, int col, int index, bool forwardOnly) const noexcept {
+    while (index < n) {
+        if (forwardOnly && !forwardMask[index]) {
+            index += 1;
             continue;
         }
 
-        const int newRow = row + offsetRow[id];
-        const int newCol = col + offsetCol[id];
+        const int newRow = row + offsetRow[index];
+        const int newCol = col + offsetCol[index];
 
         if (newRow >= 0 && newRow < numRows && newCol >= 0 && newCol < numCols) {
-            return id;
+            return index;
         }
-        id += 1;
+        index += 1;
     }
     return n;
 }
 
+inline int AdjacencyRelation::nextValid() {
+    id = nextValidFrom(row, col, id + 1, forwardOnly);
+    return id;
+}
+
 inline AdjacencyRelation::IteratorAdjacency AdjacencyRelation::begin() {
     return IteratorAdjacency(this, nextValid());
 }
@@ -410,7 +667,8 @@ inline AdjacencyRelation& AdjacencyRelation::getAdjPixels(int row, int col) {
 }
 
 inline AdjacencyRelation& AdjacencyRelation::getAdjPixels(int indexVector) {
-    return getAdjPixels(indexVector / this->numCols, indexVector % this->numCols);
+    const auto [row, col] = split(indexVector);
+    return getAdjPixels(row, col);
 }
 
 inline AdjacencyRelation& AdjacencyRelation::getNeighborPixels(int row, int col) {
@@ -425,7 +683,8 @@ inline AdjacencyRelation& AdjacencyRelation::getNeighborPixels(int row, int col)
 }
 
 inline AdjacencyRelation& AdjacencyRelation::getNeighborPixels(int indexVector) {
-    return getNeighborPixels(indexVector / this->numCols, indexVector % this->numCols);
+    const auto [row, col] = split(indexVector);
+    return getNeighborPixels(row, col);
 }
 
 inline AdjacencyRelation& AdjacencyRelation::getNeighborPixelsForward(int row, int col) {
@@ -440,5 +699,108 @@ inline AdjacencyRelation& AdjacencyRelation::getNeighborPixelsForward(int row, i
 }
 
 inline AdjacencyRelation& AdjacencyRelation::getNeighborPixelsForward(int indexVector) {
-    return getNeighborPixelsForward(indexVector / this->numCols, indexVector % this->numCols);
+    const auto [row, col] = split(indexVector);
+    return getNeighborPixelsForward(row, col);
+}
+
+inline AdjacencyRelation::NeighborRange AdjacencyRelation::getNeighborRange(int row, int col) const noexcept {
+    assert(row >= 0 && row < this->numRows && col >= 0 && col < this->numCols);
+    return NeighborRange(this, row, col, 1, false);
+}
+
+inline AdjacencyRelation::NeighborRange AdjacencyRelation::getNeighborRange(int indexVector) const noexcept {
+    const auto [row, col] = split(indexVector);
+    return getNeighborRange(row, col);
+}
+
+inline AdjacencyRelation::NeighborRange AdjacencyRelation::getNeighborRangeForward(int indexVector) const noexcept {
+    assert(indexVector >= 0 && indexVector < this->numRows * this->numCols);
+    const auto [row, col] = split(indexVector);
+    return NeighborRange(this, row, col, 1, true);
+}
+
+inline AdjacencyRelation::NeighborRange AdjacencyRelation::getAdjRange(int indexVector) const noexcept {
+    assert(indexVector >= 0 && indexVector < this->numRows * this->numCols);
+    const auto [row, col] = split(indexVector);
+    return NeighborRange(this, row, col, 0, false);
+}
+
+/**
+ * @brief Shared implementation of the compile-time stencils.
+ * @details `Derived` provides `NumNeighbors`, `OffsetRows`, and `OffsetCols`
+ * in the order produced by the normalized runtime stencil. Every offset has
+ * reach one, so the interior test is a fixed one-pixel margin and the
+ * interior loop is a fold over a constant-size index sequence.
+ */
+template<class Derived>
+struct FixedAdjacency {
+    template<typename Visitor>
+    static void forEachNeighbor(const AdjacencyRelation &adj, int index, Visitor &&visitor) {
+        const int numRows = adj.getNumRows();
+        const int numCols = adj.getNumCols();
+        const int row = index / numCols;
+        const int col = index - row * numCols;
+        if (row > 0 && row + 1 < numRows && col > 0 && col + 1 < numCols) {
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                (visitor(index + Derived::OffsetRows[I] * numCols + Derived::OffsetCols[I]), ...);
+            }(std::make_index_sequence<Derived::NumNeighbors>{});
+            return;
+        }
+        for (int i = 0; i < Derived::NumNeighbors; ++i) {
+            const int newRow = row + Derived::OffsetRows[(std::size_t) i];
+            const int newCol = col + Derived::OffsetCols[(std::size_t) i];
+            if (newRow >= 0 && newRow < numRows && newCol >= 0 && newCol < numCols) {
+                visitor(newRow * numCols + newCol);
+            }
+        }
+    }
+};
+
+/**
+ * @brief Compile-time 4-connectivity (radius 1.0).
+ */
+struct Adjacency4 : FixedAdjacency<Adjacency4> {
+    static constexpr int NumNeighbors = 4;
+    static constexpr std::array<int, 4> OffsetRows = {0, -1, 0, 1};
+    static constexpr std::array<int, 4> OffsetCols = {-1, 0, 1, 0};
+
+    static constexpr bool isAdjacent(int dy, int dx) noexcept {
+        return (dy < 0 ? -dy : dy) + (dx < 0 ? -dx : dx) <= 1;
+    }
+};
+
+/**
+ * @brief Compile-time 8-connectivity (radius 1.5 or a 1x1 rectangle).
+ */
+struct Adjacency8 : FixedAdjacency<Adjacency8> {
+    static constexpr int NumNeighbors = 8;
+    static constexpr std::array<int, 8> OffsetRows = {0, -1, -1, -1, 0, 1, 1, 1};
+    static constexpr std::array<int, 8> OffsetCols = {-1, -1, 0, 1, 1, 1, 0, -1};
+
+    static constexpr bool isAdjacent(int dy, int dx) noexcept {
+        return dy >= -1 && dy <= 1 && dx >= -1 && dx <= 1;
+    }
+};
+
+/**
+ * @brief Fallback stencil that iterates the runtime offsets of the relation.
+ */
+struct GenericAdjacency {
+    template<typename Visitor>
+    static void forEachNeighbor(const AdjacencyRelation &adj, int index, Visitor &&visitor) {
+        adj.forEachNeighbor(index, std::forward<Visitor>(visitor));
+    }
+};
+
+template<typename Fn>
+inline decltype(auto) AdjacencyRelation::withStencil(Fn &&fn) const {
+    switch (connectivity) {
+        case Connectivity::Four:
+            return std::forward<Fn>(fn)(Adjacency4{});
+        case Connectivity::Eight:
+            return std::forward<Fn>(fn)(Adjacency8{});
+        case Connectivity::Generic:
+            break;
+    }
+    return std::forward<Fn>(fn)(GenericAdjacency{});
 }
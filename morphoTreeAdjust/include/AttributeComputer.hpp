@@ -99,6 +99,49 @@ public:
         /* no-op */
     }
 
+    /**
+     * @brief Notifies that the observed tree was rebuilt in place from a new image.
+     * @details The default implementation does nothing. Attributes with
+     * persistent summaries must resize and re-bootstrap them, since the node-id
+     * space of the rebuilt tree is unrelated to the previous one.
+     */
+    virtual void onTreeRebuilt() {
+        /* no-op */
+    }
+
+    /**
+     * @brief Recomputes the full tree attribute over a caller-provided `buffer`.
+     */
+    virtual void compute(std::span<float> buffer) const = 0;
+
+protected:
+    /**
+     * @brief Breadth-first node order reused by the full-tree passes.
+     */
+    mutable std::vector<NodeId> traversalOrder_;
+
+    /**
+     * @brief Runs the pre/merge/post protocol over the whole tree without recursion.
+     * @details Nodes are initialized in breadth-first order and then closed in
+     * reverse, so every child is finished and merged into its parent before the
+     * parent is finished. The hooks are called through `Computer`, which lets
+     * the compiler bind and inline them instead of dispatching per node.
+     */
+    template<class Computer>
+    static void computeTreeBottomUp(const Computer &computer, const DynamicComponentTree &tree, std::span<float> buffer) {
+        std::vector<NodeId> &order = computer.traversalOrder_;
+        tree.collectBreadthFirstOrder(tree.getRoot(), order);
+        for (NodeId nodeId : order) {
+            computer.Computer::preProcessing(nodeId, buffer);
+        }
+        for (std::size_t i = order.size(); i-- > 0;) {
+            const NodeId nodeId = order[i];
+            computer.Computer::postProcessing(nodeId, buffer);
+            if (i > 0) {
+                computer.Computer::mergeProcessing(tree.getNodeParent(nodeId), nodeId, buffer);
+            }
+        }
+    }
 };
 
 /**
@@ -126,48 +169,36 @@ private:
     mutable std::vector<SubtreeSummary> subtree_;
 
     /**
-     * @brief Recursively recomputes the subtree of `nodeId` and writes the result into `buffer`.
-     * @details This helper is used for full computations outside the adjuster's
-     * incremental flow, for example when creating reference buffers or
-     * explicitly bootstrapping the attribute.
+     * @brief Initializes the summaries of every node reachable from the root.
+     * @details Local summaries are ensured and copied into the subtree
+     * summaries in breadth-first order; the subtree summaries are then merged
+     * into their parents in reverse order, so each child is complete before
+     * it is merged.
      */
-    void computeNode(NodeId nodeId, std::span<float> buffer) const {
-        preProcessing(nodeId, buffer);
-        for (NodeId childId : tree_->getChildren(nodeId)) {
-            computeNode(childId, buffer);
-            mergeProcessing(nodeId, childId, buffer);
+    void initializeSummariesBottomUp() const {
+        tree_->collectBreadthFirstOrder(tree_->getRoot(), traversalOrder_);
+        for (NodeId nodeId : traversalOrder_) {
+            policy_.ensureLocal(tree_, nodeId, local_[(size_t) nodeId]);
+            policy_.copyLocalToSubtree(local_[(size_t) nodeId], subtree_[(size_t) nodeId]);
         }
-        postProcessing(nodeId, buffer);
-    }
-
-    /**
-     * @brief Initializes the summaries of `nodeId` and of its entire subtree.
-     * @details The routine first ensures the local summary of the current node
-     * and then propagates that state into the subtree summary. It then visits
-     * the children and incorporates their already initialized summaries into
-     * the parent node.
-     */
-    void initializeSummariesFromNode(NodeId nodeId) const {
-        policy_.ensureLocal(tree_, nodeId, local_[(size_t) nodeId]);
-        policy_.copyLocalToSubtree(local_[(size_t) nodeId], subtree_[(size_t) nodeId]);
-        for (NodeId childId : tree_->getChildren(nodeId)) {
-            initializeSummariesFromNode(childId);
-            policy_.mergeSubtree(subtree_[(size_t) nodeId], subtree_[(size_t) childId]);
+        for (std::size_t i = traversalOrder_.size(); i-- > 1;) {
+            const NodeId nodeId = traversalOrder_[i];
+            policy_.mergeSubtree(subtree_[(size_t) tree_->getNodeParent(nodeId)], subtree_[(size_t) nodeId]);
         }
     }
 
     /**
      * @brief Bootstraps the persistent summaries from the current tree root.
-     * @details The method is called only once in the constructor. The premise
-     * is that the tree already represents a consistent state and that the
-     * computer only needs to build its internal runtime to track future
-     * updates.
+     * @details The method is called in the constructor and after each in-place
+     * rebuild of the tree. The premise is that the tree already represents a
+     * consistent state and that the computer only needs to build its internal
+     * runtime to track future updates.
      */
     void initializeSummaries() const {
         if (tree_ == nullptr || tree_->getRoot() == InvalidNode) {
             return;
         }
-        initializeSummariesFromNode(tree_->getRoot());
+        initializeSummariesBottomUp();
     }
 
 protected:
@@ -273,6 +304,18 @@ public:
                           local_[(size_t) sourceId]);
     }
 
+    /**
+     * @brief Resizes and re-bootstraps the summaries for the rebuilt tree.
+     * @details The summary vectors are refilled in place, so their capacity is
+     * kept across rebuilds of same-shaped images.
+     */
+    void onTreeRebuilt() override {
+        const std::size_t numSlots = (std::size_t) (tree_ ? tree_->getNumInternalNodeSlots() : 0);
+        local_.assign(numSlots, LocalSummary{});
+        subtree_.assign(numSlots, SubtreeSummary{});
+        initializeSummaries();
+    }
+
     /**
      * @brief Computes the full attribute and returns a new buffer with the values.
      * @details Convenience method used in benchmarks, tools, and tests when the
@@ -290,11 +333,11 @@ public:
      * @details Unlike the adjuster's incremental flow, this routine visits the
      * entire tree starting from the current root.
      */
-    void compute(std::span<float> buffer) const {
+    void compute(std::span<float> buffer) const override {
         if (tree_ == nullptr || tree_->getRoot() == InvalidNode) {
             return;
         }
-        computeNode(tree_->getRoot(), buffer);
+        computeTreeBottomUp(*this, *tree_, buffer);
     }
 };
 
@@ -318,20 +361,6 @@ class DynamicAreaComputer : public DynamicAttributeComputer {
 private:
     DynamicComponentTree *tree_ = nullptr;
 
-    /**
-     * @brief Recursively recomputes the accumulated area of the subtree of `nodeId`.
-     * @details This helper provides the full version of the area computation,
-     * independent of the adjuster's incremental flow.
-     */
-    void computeNodeArea(NodeId nodeId, std::span<float> buffer) {
-        preProcessing(nodeId, buffer);
-        for (NodeId childId : tree_->getChildren(nodeId)) {
-            computeNodeArea(childId, buffer);
-            mergeProcessing(nodeId, childId, buffer);
-        }
-        postProcessing(nodeId, buffer);
-    }
-
 public:
     /**
      * @brief Builds the incremental area computer for a dynamic tree.
@@ -369,7 +398,7 @@ public:
     /**
      * @brief Computes the full tree area and returns a new buffer.
      */
-    std::vector<float> compute() {
+    std::vector<float> compute() const {
         std::vector<float> buffer((size_t) tree_->getNumInternalNodeSlots(), 0.0f);
         compute(std::span<float>(buffer));
         return buffer;
@@ -378,11 +407,11 @@ public:
     /**
      * @brief Computes the full tree area on a caller-provided buffer.
      */
-    void compute(std::span<float> buffer) {
+    void compute(std::span<float> buffer) const override {
         if (tree_ == nullptr || tree_->getRoot() == InvalidNode) {
             return;
         }
-        computeNodeArea(tree_->getRoot(), buffer);
+        computeTreeBottomUp(*this, *tree_, buffer);
     }
 };
 
@@ -1,13 +1,33 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <istream>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+/**
+ * @brief Keeps a rarely taken slow path out of its callers so that their fast path can inline.
+ */
+#if defined(_MSC_VER)
+#define MTA_NOINLINE __declspec(noinline)
+#else
+#define MTA_NOINLINE __attribute__((noinline))
+#endif
+
 using NodeId = int;
 using PixelId = int;
 constexpr NodeId InvalidNode = -1;
@@ -35,6 +55,11 @@ private:
     std::shared_ptr<PixelType[]> data;
     using Ptr = std::shared_ptr<Image<PixelType>>;
 
+    Image(int rows, int cols, std::shared_ptr<PixelType[]> buffer)
+        : numRows(rows),
+          numCols(cols),
+          data(std::move(buffer)) {}
+
 public:
     /**
      * @brief Creates an owning image with contiguous storage.
@@ -60,6 +85,20 @@ public:
         return img;
     }
 
+    /**
+     * @brief Wraps an external row-major buffer without copying it.
+     * @details The view shares ownership with `owner`, which must keep
+     * `pixels` alive; when `owner` is null the caller guarantees that the
+     * buffer outlives every use of the view. Trees only read the image while
+     * they are built, so a view may borrow a buffer for one build.
+     */
+    static Ptr view(int rows, int cols, PixelType *pixels, std::shared_ptr<void> owner = nullptr) {
+        if (pixels == nullptr && rows * cols > 0) {
+            throw std::runtime_error("Image::view requires a valid pixel buffer.");
+        }
+        return Ptr(new Image(rows, cols, std::shared_ptr<PixelType[]>(std::move(owner), pixels)));
+    }
+
     /**
      * @brief Fills every image pixel with a constant value.
      */
@@ -119,6 +158,8 @@ public:
 using ImageUInt8 = Image<uint8_t>;
 using AltitudeType = uint8_t;
 using ImageUInt8Ptr = std::shared_ptr<ImageUInt8>;
+using ImageUInt16 = Image<uint16_t>;
+using ImageUInt16Ptr = std::shared_ptr<ImageUInt16>;
 
 template <typename T>
 using ImagePtr = std::shared_ptr<Image<T>>;
@@ -185,6 +226,156 @@ struct GenerationStampSet {
     }
 };
 
+/**
+ * @brief Node buckets indexed by gray level, stored in one pooled array.
+ * @details The structure has two phases. While collecting, `push()` appends
+ * `(level, node)` to a flat log and sets the level in a two-level bitmap
+ * (one bit per level, one summary bit per 64-level word). `seal()` then
+ * enumerates the active levels in increasing order with count-trailing-zeros
+ * scans and scatters the log into a single node array grouped by level,
+ * preserving the insertion order inside each level. After sealing, the nodes
+ * of a level are a contiguous span located by a popcount rank, and the
+ * active levels are walked by index.
+ *
+ * Memory is proportional to the collected nodes plus one bit per possible
+ * level (8 KiB for 16-bit data), and `clear()` only touches the levels used.
+ */
+template <typename PixelType>
+class LevelBuckets {
+private:
+    static_assert(std::numeric_limits<PixelType>::is_integer, "LevelBuckets requires integral levels");
+    static_assert(std::numeric_limits<PixelType>::lowest() == 0, "LevelBuckets expects non-negative contiguous levels");
+    static constexpr std::size_t NumLevels = static_cast<std::size_t>(std::numeric_limits<PixelType>::max()) + 1;
+    static constexpr std::size_t NumWords = (NumLevels + 63) / 64;
+    static constexpr std::size_t NumSummaryWords = (NumWords + 63) / 64;
+
+    struct Entry {
+        PixelType level;
+        NodeId nodeId;
+    };
+
+    std::vector<uint64_t> levelBits_ = std::vector<uint64_t>(NumWords, 0);
+    std::vector<uint64_t> summaryBits_ = std::vector<uint64_t>(NumSummaryWords, 0);
+    std::vector<uint32_t> wordRank_ = std::vector<uint32_t>(NumWords, 0);
+    std::vector<Entry> entries_;
+    std::vector<NodeId> nodes_;
+    std::vector<PixelType> levels_;
+    std::vector<uint32_t> levelBegin_;
+    std::vector<uint32_t> levelCursor_;
+    std::size_t maxBucketSize_ = 0;
+    bool sealed_ = false;
+
+    bool hasLevel(PixelType level) const {
+        const std::size_t index = static_cast<std::size_t>(level);
+        return (levelBits_[index >> 6] >> (index & 63)) & 1u;
+    }
+
+    std::size_t rankOf(PixelType level) const {
+        const std::size_t index = static_cast<std::size_t>(level);
+        const uint64_t below = levelBits_[index >> 6] & ((uint64_t{1} << (index & 63)) - 1);
+        return wordRank_[index >> 6] + static_cast<std::size_t>(std::popcount(below));
+    }
+
+public:
+    /**
+     * @brief Appends `nodeId` to the bucket of `level`; only valid before `seal()`.
+     */
+    void push(PixelType level, NodeId nodeId) {
+        assert(!sealed_);
+        const std::size_t index = static_cast<std::size_t>(level);
+        levelBits_[index >> 6] |= uint64_t{1} << (index & 63);
+        summaryBits_[index >> 12] |= uint64_t{1} << ((index >> 6) & 63);
+        entries_.push_back({level, nodeId});
+    }
+
+    /**
+     * @brief Groups the collected nodes by level; calling it again is a no-op.
+     */
+    void seal() {
+        if (sealed_) {
+            return;
+        }
+        sealed_ = true;
+        levels_.clear();
+        for (std::size_t summaryIndex = 0; summaryIndex < NumSummaryWords; ++summaryIndex) {
+            for (uint64_t summary = summaryBits_[summaryIndex]; summary != 0; summary &= summary - 1) {
+                const std::size_t word = (summaryIndex << 6) + static_cast<std::size_t>(std::countr_zero(summary));
+                wordRank_[word] = static_cast<uint32_t>(levels_.size());
+                for (uint64_t bits = levelBits_[word]; bits != 0; bits &= bits - 1) {
+                    levels_.push_back(static_cast<PixelType>((word << 6) + static_cast<std::size_t>(std::countr_zero(bits))));
+                }
+            }
+        }
+
+        levelBegin_.assign(levels_.size() + 1, 0);
+        for (const Entry& entry : entries_) {
+            levelBegin_[rankOf(entry.level) + 1]++;
+        }
+        maxBucketSize_ = 0;
+        for (std::size_t rank = 0; rank < levels_.size(); ++rank) {
+            maxBucketSize_ = std::max<std::size_t>(maxBucketSize_, levelBegin_[rank + 1]);
+            levelBegin_[rank + 1] += levelBegin_[rank];
+        }
+        levelCursor_.assign(levelBegin_.begin(), levelBegin_.end() - 1);
+        nodes_.resize(entries_.size());
+        for (const Entry& entry : entries_) {
+            nodes_[levelCursor_[rankOf(entry.level)]++] = entry.nodeId;
+        }
+    }
+
+    /**
+     * @brief Active levels in increasing order; requires `seal()`.
+     */
+    const std::vector<PixelType>& levels() const {
+        assert(sealed_);
+        return levels_;
+    }
+
+    /**
+     * @brief Nodes of the `rank`-th active level, in insertion order; requires `seal()`.
+     */
+    std::span<const NodeId> nodesAtRank(std::size_t rank) const {
+        assert(sealed_ && rank < levels_.size());
+        return std::span<const NodeId>(nodes_.data() + levelBegin_[rank], levelBegin_[rank + 1] - levelBegin_[rank]);
+    }
+
+    /**
+     * @brief Nodes pushed at `level`, in insertion order; seals the buckets if needed.
+     */
+    std::span<const NodeId> nodesAt(PixelType level) {
+        seal();
+        if (!hasLevel(level)) {
+            return {};
+        }
+        return nodesAtRank(rankOf(level));
+    }
+
+    /**
+     * @brief Size of the largest bucket; requires `seal()`.
+     */
+    std::size_t maxBucketSize() const {
+        assert(sealed_);
+        return maxBucketSize_;
+    }
+
+    /**
+     * @brief Empties every bucket, clearing only the bitmap words in use.
+     */
+    void clear() {
+        for (const Entry& entry : entries_) {
+            const std::size_t index = static_cast<std::size_t>(entry.level);
+            levelBits_[index >> 6] = 0;
+            summaryBits_[index >> 12] = 0;
+        }
+        entries_.clear();
+        nodes_.clear();
+        levels_.clear();
+        levelBegin_.clear();
+        maxBucketSize_ = 0;
+        sealed_ = false;
+    }
+};
+
 /**
  * @brief Lightweight FIFO queue based on `std::vector` and a head index.
  */
@@ -275,6 +466,295 @@ public:
     const T& top() const { return data_.back(); }
 };
 
+/**
+ * @brief Array split into shared fixed-size chunks with copy-on-write semantics.
+ * @details Values live in chunks of `ChunkSize` elements, each held by a
+ * `std::shared_ptr`. Copying a column only copies the chunk pointers, so a
+ * copy costs `O(size / ChunkSize)` and both columns keep reading the same
+ * memory. `set()` gives a column its own copy of a chunk the first time it
+ * writes to a chunk that another column still holds, so diverging copies
+ * only pay for the chunks they modify. Reads go through a raw pointer per
+ * chunk and never touch the reference counts; a per-chunk flag remembers
+ * the chunks a column already owns, so only its first write to a chunk
+ * after a copy looks at the reference count.
+ *
+ * Copies may be taken concurrently from one column, and copies may be
+ * written from different threads; a column itself is not synchronized.
+ */
+template <typename T>
+class ChunkedColumn {
+public:
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    using value_type = T;
+
+    static constexpr std::size_t ChunkBits = 12;
+    static constexpr std::size_t ChunkSize = std::size_t{1} << ChunkBits;
+    static constexpr std::size_t ChunkMask = ChunkSize - 1;
+
+private:
+    // Read pointer of a chunk and whether it is known to be held by this
+    // column only. Copying clears the flags of both columns; concurrent
+    // copies of one column store the same value through `std::atomic_ref`.
+    struct Slot {
+        T *data = nullptr;
+        mutable uint8_t owned = 0;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<std::shared_ptr<T[]>> chunks_;
+    std::size_t size_ = 0;
+
+    static std::shared_ptr<T[]> allocateChunk() {
+        return std::make_shared_for_overwrite<T[]>(ChunkSize);
+    }
+
+    void disownChunks() const {
+        for (const Slot &slot : slots_) {
+            std::atomic_ref<uint8_t>(slot.owned).store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Tests whether this column is the only holder of chunk `chunkIndex`.
+     * @details The acquire fence pairs with the release of the last other
+     * holder, so its reads of the chunk happen before the in-place writes that follow.
+     */
+    bool ownsChunk(std::size_t chunkIndex) const {
+        if (chunks_[chunkIndex].use_count() != 1) {
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    /**
+     * @brief Takes ownership of chunk `chunkIndex`, copying its values first if it is shared.
+     * @details Kept out of line so that the owned-chunk path of `set()` stays
+     * small enough to inline.
+     */
+    MTA_NOINLINE T *detachChunk(std::size_t chunkIndex, bool keepValues) {
+        Slot &slot = slots_[chunkIndex];
+        if (!ownsChunk(chunkIndex)) {
+            std::shared_ptr<T[]> copy = allocateChunk();
+            if (keepValues) {
+                std::copy_n(slot.data, ChunkSize, copy.get());
+            }
+            slot.data = copy.get();
+            chunks_[chunkIndex] = std::move(copy);
+        }
+        slot.owned = 1;
+        return slot.data;
+    }
+
+    /**
+     * @brief Writable storage of chunk `chunkIndex`, detaching it if it is shared.
+     */
+    T *writableChunk(std::size_t chunkIndex, bool keepValues = true) {
+        const Slot &slot = slots_[chunkIndex];
+        return slot.owned != 0 ? slot.data : detachChunk(chunkIndex, keepValues);
+    }
+
+public:
+    class const_iterator {
+    private:
+        const ChunkedColumn *column_ = nullptr;
+        std::size_t index_ = 0;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+        const_iterator(const ChunkedColumn *column, std::size_t index) : column_(column), index_(index) {}
+
+        reference operator*() const { return (*column_)[index_]; }
+        const_iterator &operator++() {
+            ++index_;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++index_;
+            return previous;
+        }
+        bool operator==(const const_iterator &other) const { return index_ == other.index_; }
+    };
+
+    ChunkedColumn() = default;
+
+    /**
+     * @brief Builds a column of `size` copies of `value`.
+     */
+    ChunkedColumn(std::size_t size, const T &value) { assign(size, value); }
+
+    /**
+     * @brief Shares every chunk of `other`; costs one pointer copy per chunk.
+     */
+    ChunkedColumn(const ChunkedColumn &other) : chunks_(other.chunks_), size_(other.size_) {
+        other.disownChunks();
+        slots_.resize(other.slots_.size());
+        for (std::size_t chunkIndex = 0; chunkIndex < slots_.size(); ++chunkIndex) {
+            slots_[chunkIndex].data = other.slots_[chunkIndex].data;
+        }
+    }
+
+    ChunkedColumn(ChunkedColumn &&other) noexcept = default;
+
+    ChunkedColumn &operator=(const ChunkedColumn &other) {
+        if (this != &other) {
+            *this = ChunkedColumn(other);
+        }
+        return *this;
+    }
+
+    ChunkedColumn &operator=(ChunkedColumn &&other) noexcept = default;
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::size_t numChunks() const noexcept { return chunks_.size(); }
+
+    const T &operator[](std::size_t index) const {
+        assert(index < size_);
+        return slots_[index >> ChunkBits].data[index & ChunkMask];
+    }
+
+    /**
+     * @brief Writes `value` at `index`, detaching the chunk if it is shared.
+     */
+    void set(std::size_t index, const T &value) {
+        assert(index < size_);
+        writableChunk(index >> ChunkBits)[index & ChunkMask] = value;
+    }
+
+    /**
+     * @brief Writable reference to the value at `index`, detaching its chunk if it is shared.
+     * @details The reference is invalidated by the next copy or resize of the column.
+     */
+    T &mutableAt(std::size_t index) {
+        assert(index < size_);
+        return writableChunk(index >> ChunkBits)[index & ChunkMask];
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    /**
+     * @brief Changes the size, keeping the leading values; new values are unspecified.
+     * @details Chunks already held are kept, so shrinking and growing back
+     * within the same chunks does not allocate.
+     */
+    void resize(std::size_t size) {
+        const std::size_t numChunks = (size + ChunkMask) >> ChunkBits;
+        slots_.resize(numChunks);
+        chunks_.resize(numChunks);
+        for (std::size_t chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex) {
+            if (chunks_[chunkIndex] == nullptr) {
+                chunks_[chunkIndex] = allocateChunk();
+                slots_[chunkIndex] = {chunks_[chunkIndex].get(), 1};
+            }
+        }
+        size_ = size;
+    }
+
+    /**
+     * @brief Resizes to `size` and fills every value with `value`.
+     * @details Shared chunks are replaced by fresh ones rather than copied.
+     */
+    void assign(std::size_t size, const T &value) {
+        resize(size);
+        for (std::size_t chunkIndex = 0; chunkIndex < chunks_.size(); ++chunkIndex) {
+            std::fill_n(writableChunk(chunkIndex, false), ChunkSize, value);
+        }
+    }
+
+    void push_back(const T &value) {
+        resize(size_ + 1);
+        set(size_ - 1, value);
+    }
+
+    /**
+     * @brief Drops every value and releases the chunks and the chunk tables.
+     */
+    void clear() {
+        std::vector<Slot>().swap(slots_);
+        std::vector<std::shared_ptr<T[]>>().swap(chunks_);
+        size_ = 0;
+    }
+
+    /**
+     * @brief Copies the values into the contiguous array `out` of at least `size()` elements.
+     */
+    void copyTo(T *out) const {
+        forEachChunk([&out](const T *chunk, std::size_t count) {
+            out = std::copy_n(chunk, count, out);
+        });
+    }
+
+    /**
+     * @brief Calls `visit(chunk, count)` on the contiguous runs of the values, in order.
+     */
+    template <typename Visit>
+    void forEachChunk(Visit &&visit) const {
+        for (std::size_t begin = 0; begin < size_; begin += ChunkSize) {
+            visit(static_cast<const T *>(slots_[begin >> ChunkBits].data), std::min(ChunkSize, size_ - begin));
+        }
+    }
+
+    /**
+     * @brief Calls `fill(chunk, count)` on writable contiguous runs covering every value, in order.
+     * @details Shared chunks are replaced by fresh ones rather than copied, so
+     * `fill` must write every value of its run.
+     */
+    template <typename Fill>
+    void overwriteChunks(Fill &&fill) {
+        for (std::size_t begin = 0; begin < size_; begin += ChunkSize) {
+            fill(writableChunk(begin >> ChunkBits, false), std::min(ChunkSize, size_ - begin));
+        }
+    }
+
+    /**
+     * @brief Calls `visit(chunk, count)` on writable contiguous runs of the values, in order.
+     * @details Shared chunks are detached with their values, so `visit` may
+     * update only some fields of each value.
+     */
+    template <typename Visit>
+    void forEachMutableChunk(Visit &&visit) {
+        for (std::size_t begin = 0; begin < size_; begin += ChunkSize) {
+            visit(writableChunk(begin >> ChunkBits), std::min(ChunkSize, size_ - begin));
+        }
+    }
+
+    /**
+     * @brief Number of chunks also held by another column.
+     */
+    std::size_t numSharedChunks() const {
+        std::size_t numShared = 0;
+        for (const std::shared_ptr<T[]> &chunk : chunks_) {
+            numShared += chunk.use_count() > 1 ? 1 : 0;
+        }
+        return numShared;
+    }
+
+    /**
+     * @brief Bytes held by this column, counting shared chunks in full.
+     */
+    std::size_t getMemoryUsage() const {
+        return slots_.capacity() * sizeof(Slot) + chunks_.capacity() * sizeof(std::shared_ptr<T[]>) +
+               chunks_.size() * ChunkSize * sizeof(T);
+    }
+
+    /**
+     * @brief Bytes of the chunks held only by this column.
+     */
+    std::size_t getOwnedMemoryUsage() const {
+        return (chunks_.size() - numSharedChunks()) * ChunkSize * sizeof(T);
+    }
+};
+
 class Stopwatch {
 public:
     using clock = std::chrono::steady_clock;
@@ -321,3 +801,134 @@ private:
     clock::duration accumulated_{clock::duration::zero()};
     bool running_{false};
 };
+
+/**
+ * @brief Raw binary reads and writes shared by the snapshot formats.
+ * @details Values are stored in native byte order and layout; every snapshot
+ * header records a byte-order mark so that a file written on a machine of the
+ * other endianness is rejected instead of misread. Vectors are stored as a
+ * 64-bit element count followed by their contiguous storage, so loading one is
+ * a single bulk read.
+ */
+struct SnapshotIO {
+    static constexpr uint32_t ByteOrderMark = 0x01020304u;
+
+    template<typename T>
+    static void write(std::ostream &out, const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    static void read(std::istream &in, T &value, const char *what) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (!in.read(reinterpret_cast<char *>(&value), sizeof(T))) {
+            throw std::runtime_error(std::string(what) + " snapshot is truncated.");
+        }
+    }
+
+    template<typename T>
+    static void writeVector(std::ostream &out, const std::vector<T> &values) {
+        write(out, (uint64_t) values.size());
+        out.write(reinterpret_cast<const char *>(values.data()), (std::streamsize) (values.size() * sizeof(T)));
+    }
+
+    /**
+     * @brief Reads a vector written by `writeVector`, checking its length against `expectedSize`.
+     */
+    template<typename T>
+    static void readVector(std::istream &in, std::vector<T> &values, std::size_t expectedSize, const char *what) {
+        uint64_t size = 0;
+        read(in, size, what);
+        if (size != expectedSize) {
+            throw std::runtime_error(std::string(what) + " snapshot has a column of unexpected length.");
+        }
+        values.resize((std::size_t) size);
+        if (!in.read(reinterpret_cast<char *>(values.data()), (std::streamsize) (values.size() * sizeof(T)))) {
+            throw std::runtime_error(std::string(what) + " snapshot is truncated.");
+        }
+    }
+
+    /**
+     * @brief Writes `project(value)` as a `Stored` for every value of a column, in the layout of `writeVector`.
+     * @details Values are converted through a small stack buffer, so a record
+     * field or a narrower id column is stored in its fixed on-disk type
+     * without a full-size copy.
+     */
+    template<typename Stored, typename T, typename Project>
+    static void writeColumn(std::ostream &out, const ChunkedColumn<T> &values, Project &&project) {
+        static_assert(std::is_trivially_copyable_v<Stored>);
+        constexpr std::size_t BlockSize = 1024;
+        Stored block[BlockSize];
+        write(out, (uint64_t) values.size());
+        values.forEachChunk([&](const T *chunk, std::size_t count) {
+            for (std::size_t begin = 0; begin < count; begin += BlockSize) {
+                const std::size_t blockCount = std::min(BlockSize, count - begin);
+                for (std::size_t i = 0; i < blockCount; ++i) {
+                    block[i] = static_cast<Stored>(project(chunk[begin + i]));
+                }
+                out.write(reinterpret_cast<const char *>(block), (std::streamsize) (blockCount * sizeof(Stored)));
+            }
+        });
+    }
+
+    /**
+     * @brief Reads a column written by `writeColumn` or `writeVector` into the already sized `values`.
+     * @details Each stored value is handed to `store(stored, value)`, which
+     * returns `false` when the stored value does not fit its target; the
+     * stored length must equal `values.size()`.
+     */
+    template<typename Stored, typename T, typename Store>
+    static void readColumn(std::istream &in, ChunkedColumn<T> &values, const char *what, Store &&store) {
+        static_assert(std::is_trivially_copyable_v<Stored>);
+        constexpr std::size_t BlockSize = 1024;
+        Stored block[BlockSize];
+        uint64_t size = 0;
+        read(in, size, what);
+        if (size != values.size()) {
+            throw std::runtime_error(std::string(what) + " snapshot has a column of unexpected length.");
+        }
+        values.forEachMutableChunk([&](T *chunk, std::size_t count) {
+            for (std::size_t begin = 0; begin < count; begin += BlockSize) {
+                const std::size_t blockCount = std::min(BlockSize, count - begin);
+                if (!in.read(reinterpret_cast<char *>(block), (std::streamsize) (blockCount * sizeof(Stored)))) {
+                    throw std::runtime_error(std::string(what) + " snapshot is truncated.");
+                }
+                for (std::size_t i = 0; i < blockCount; ++i) {
+                    if (!store(block[i], chunk[begin + i])) {
+                        throw std::runtime_error(std::string(what) + " snapshot has a value out of range.");
+                    }
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Writes the 8-byte magic tag, the format version, and the byte-order mark.
+     */
+    static void writeHeader(std::ostream &out, const char (&magic)[9], uint32_t version) {
+        out.write(magic, 8);
+        write(out, version);
+        write(out, ByteOrderMark);
+    }
+
+    /**
+     * @brief Reads and validates a header written by `writeHeader`.
+     */
+    static void readHeader(std::istream &in, const char (&magic)[9], uint32_t version, const char *what) {
+        char tag[8] = {};
+        if (!in.read(tag, 8) || !std::equal(tag, tag + 8, magic)) {
+            throw std::runtime_error(std::string(what) + " snapshot has an unknown format.");
+        }
+        uint32_t fileVersion = 0;
+        uint32_t byteOrder = 0;
+        read(in, fileVersion, what);
+        read(in, byteOrder, what);
+        if (fileVersion != version) {
+            throw std::runtime_error(std::string(what) + " snapshot has an unsupported version.");
+        }
+        if (byteOrder != ByteOrderMark) {
+            throw std::runtime_error(std::string(what) + " snapshot was written with another byte order.");
+        }
+    }
+};
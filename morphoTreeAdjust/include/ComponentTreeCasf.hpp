@@ -1,11 +1,19 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <exception>
+#include <functional>
+#include <istream>
 #include <memory>
+#include <ostream>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 #include "AdjacencyRelation.hpp"
@@ -21,8 +29,28 @@ public:
         Updating,
         Naive,
         Hybrid,
+        Adaptive,
     };
 
+    /**
+     * @brief Work of one adaptive step, counted before its strategy is chosen.
+     */
+    struct AdaptiveStepCounts {
+        double prunedPixels = 0.0;  ///< Pixels the incremental update moves, over both trees.
+        std::size_t numPixels = 0;  ///< Pixels of the image, which a naive step rebuilds four times.
+        std::size_t numNodes = 0;   ///< Live nodes of both trees.
+    };
+
+    /**
+     * @brief Predicted costs of both strategies for one adaptive step, in any common unit.
+     */
+    struct AdaptiveCostEstimate {
+        double updateCost = 0.0;
+        double naiveCost = 0.0;
+    };
+
+    using AdaptiveCostEstimator = std::function<AdaptiveCostEstimate(const AdaptiveStepCounts &)>;
+
 private:
     AdjacencyRelationPtr adjacency_;
     Attribute attribute_ = AREA;
@@ -33,6 +61,30 @@ private:
     std::vector<float> maxAttribute_;
     std::vector<float> minAttribute_;
     std::unique_ptr<DualMinMaxTreeIncrementalFilter<PixelType>> adjust_;
+    DynamicComponentTree::BuildWorkspace maxWorkspace_;
+    DynamicComponentTree::BuildWorkspace minWorkspace_;
+    ImagePtr<PixelType> scratchImage_;
+    ImagePtr<PixelType> output_;
+    std::vector<NodeId> nodesToPrune_;
+    FastQueue<NodeId> pruneQueue_;
+    bool concurrentTreeBuild_ = false;
+    double compactionRatio_ = 0.0;
+    bool lazyOwnership_ = false;
+    std::size_t numCompactions_ = 0;
+
+    // Cost model of the adaptive mode: running averages of the measured time
+    // per image pixel of a naive step and per pruned pixel of an update, zero
+    // until the strategy has been timed, unless a caller estimator replaces it.
+    AdaptiveCostEstimator costEstimator_;
+    double naiveSecondsPerPixel_ = 0.0;
+    double updateSecondsPerPixel_ = 0.0;
+    std::size_t adaptiveExplorationPeriod_ = 8;
+    Mode lastAdaptiveMode_ = Mode::Updating;
+    std::size_t numConsecutiveAdaptiveSteps_ = 0;
+    std::size_t numAdaptiveNaiveSteps_ = 0;
+
+    static constexpr char SnapshotMagic[9] = "MTACASF1";
+    static constexpr uint32_t SnapshotVersion = 1;
 
     static std::string normalizeToken(std::string_view token) {
         std::string normalized(token.begin(), token.end());
@@ -42,31 +94,20 @@ private:
         return normalized;
     }
 
-    static std::vector<NodeId> getNodesToPrune(const DynamicComponentTree &tree, const std::vector<float> &attribute, int threshold) {
-        std::vector<NodeId> out;
-        FastQueue<NodeId> queue;
-        queue.push(tree.getRoot());
-        while (!queue.empty()) {
-            const NodeId nodeId = queue.pop();
+    void collectNodesToPrune(const DynamicComponentTree &tree, const std::vector<float> &attribute, int threshold) {
+        nodesToPrune_.clear();
+        pruneQueue_.clear();
+        pruneQueue_.push(tree.getRoot());
+        while (!pruneQueue_.empty()) {
+            const NodeId nodeId = pruneQueue_.pop();
             if (attribute[static_cast<std::size_t>(nodeId)] > threshold) {
                 for (NodeId childId : tree.getChildren(nodeId)) {
-                    queue.push(childId);
+                    pruneQueue_.push(childId);
                 }
             } else {
-                out.push_back(nodeId);
+                nodesToPrune_.push_back(nodeId);
             }
         }
-        return out;
-    }
-
-    static std::vector<float> computeAttribute(DynamicComponentTree &tree, Attribute attribute) {
-        if (attribute == AREA) {
-            DynamicAreaComputer computer(&tree);
-            return computer.compute();
-        }
-
-        DynamicBoundingBoxComputer computer(&tree, attribute);
-        return computer.compute();
     }
 
     static std::unique_ptr<DynamicAttributeComputer> makeAttributeComputer(DynamicComponentTree *tree, Attribute attribute) {
@@ -77,63 +118,278 @@ private:
         return std::make_unique<DynamicBoundingBoxComputer>(tree, attribute);
     }
 
-    void rebuildFromImage(const ImageUInt8Ptr &image) {
+    static void computeAttribute(const DynamicAttributeComputer &computer, const DynamicComponentTree &tree, std::vector<float> &attribute) {
+        attribute.assign(static_cast<std::size_t>(tree.getNumInternalNodeSlots()), 0.0f);
+        computer.compute(std::span<float>(attribute));
+    }
+
+    bool hasSameShape(const ImagePtr<PixelType> &image) const {
+        return maxtree_ != nullptr &&
+               maxtree_->getNumRowsOfImage() == image->getNumRows() &&
+               maxtree_->getNumColsOfImage() == image->getNumCols();
+    }
+
+    /**
+     * @brief Rebuilds both trees from `image` and resynchronizes the incremental state.
+     * @details When the image has the shape of the previous one, the trees,
+     * attribute computers, adjuster, and build workspaces are recycled in
+     * place, so steady-state rebuilds reuse all their storage.
+     */
+    void rebuildFromImage(const ImagePtr<PixelType> &image) {
         if (image == nullptr) {
             throw std::runtime_error("ComponentTreeCasf requires a valid image.");
         }
-
-        maxtree_ = std::make_unique<DynamicComponentTree>(image->clone(), true, adjacency_);
-        mintree_ = std::make_unique<DynamicComponentTree>(image->clone(), false, adjacency_);
-        maxAttributeComputer_ = makeAttributeComputer(maxtree_.get(), attribute_);
-        minAttributeComputer_ = makeAttributeComputer(mintree_.get(), attribute_);
-        adjust_ = std::make_unique<DualMinMaxTreeIncrementalFilter<PixelType>>(mintree_.get(), maxtree_.get(), *adjacency_);
+        if (!hasSameShape(image)) {
+            maxtree_ = std::make_unique<DynamicComponentTree>();
+            mintree_ = std::make_unique<DynamicComponentTree>();
+            DynamicComponentTree::buildMinMaxTrees(*maxtree_, *mintree_, image, adjacency_, maxWorkspace_, minWorkspace_, concurrentTreeBuild_);
+            maxAttributeComputer_ = makeAttributeComputer(maxtree_.get(), attribute_);
+            minAttributeComputer_ = makeAttributeComputer(mintree_.get(), attribute_);
+            adjust_ = std::make_unique<DualMinMaxTreeIncrementalFilter<PixelType>>(mintree_.get(), maxtree_.get(), *adjacency_);
+            scratchImage_ = Image<PixelType>::create(image->getNumRows(), image->getNumCols());
+            output_ = Image<PixelType>::create(image->getNumRows(), image->getNumCols());
+            mintree_->setTrackPixelChanges(true);
+            maxtree_->setLazyProperPartOwnership(lazyOwnership_);
+            mintree_->setLazyProperPartOwnership(lazyOwnership_);
+        } else {
+            DynamicComponentTree::buildMinMaxTrees(*maxtree_, *mintree_, image, adjacency_, maxWorkspace_, minWorkspace_, concurrentTreeBuild_);
+            maxAttributeComputer_->onTreeRebuilt();
+            minAttributeComputer_->onTreeRebuilt();
+            adjust_->onTreesRebuilt();
+        }
         refreshAttributeBuffers();
     }
 
     void refreshAttributeBuffers() {
-        maxAttribute_ = computeAttribute(*maxtree_, attribute_);
-        minAttribute_ = computeAttribute(*mintree_, attribute_);
+        computeAttribute(*maxAttributeComputer_, *maxtree_, maxAttribute_);
+        computeAttribute(*minAttributeComputer_, *mintree_, minAttribute_);
         adjust_->setAttributeComputer(*minAttributeComputer_, *maxAttributeComputer_, std::span<float>(minAttribute_), std::span<float>(maxAttribute_));
     }
 
+    /**
+     * @brief Compacts `tree` when its share of free node slots exceeds the compaction ratio.
+     * @return Whether the tree was compacted.
+     * @details The proper-part lists are relinked in pixel order at the same
+     * time: both are scrambled by the moves and merges of the steps since the
+     * last compaction.
+     */
+    bool compactIfFragmented(DynamicComponentTree &tree, DynamicAttributeComputer &computer, std::vector<float> &attribute) {
+        const int numSlots = tree.getNumInternalNodeSlots();
+        if (compactionRatio_ <= 0.0 || numSlots == 0 || tree.getNumFreeNodeSlots() <= compactionRatio_ * numSlots) {
+            return false;
+        }
+        DynamicComponentTree::applyNodeRemap(tree.compact(), attribute);
+        tree.relayoutProperParts();
+        computer.onTreeRebuilt();
+        numCompactions_++;
+        return true;
+    }
+
+    void compactFragmentedTrees() {
+        const bool compactedMax = compactIfFragmented(*maxtree_, *maxAttributeComputer_, maxAttribute_);
+        const bool compactedMin = compactIfFragmented(*mintree_, *minAttributeComputer_, minAttribute_);
+        if (compactedMax || compactedMin) {
+            adjust_->onTreesRebuilt();
+            adjust_->setAttributeComputer(*minAttributeComputer_, *maxAttributeComputer_, std::span<float>(minAttribute_), std::span<float>(maxAttribute_));
+        }
+    }
+
     void applyUpdatingThreshold(int threshold) {
-        auto maxNodes = getNodesToPrune(*maxtree_, maxAttribute_, threshold);
-        adjust_->pruneMaxTreeAndUpdateMinTree(maxNodes);
+        collectNodesToPrune(*maxtree_, maxAttribute_, threshold);
+        applyCollectedUpdatingThreshold(threshold);
+    }
+
+    /**
+     * @brief Finishes an updating step whose max-tree nodes are already in `nodesToPrune_`.
+     */
+    void applyCollectedUpdatingThreshold(int threshold) {
+        adjust_->pruneMaxTreeAndUpdateMinTree(nodesToPrune_);
+
+        collectNodesToPrune(*mintree_, minAttribute_, threshold);
+        adjust_->pruneMinTreeAndUpdateMaxTree(nodesToPrune_);
+    }
+
+    /**
+     * @brief Estimates the pixels covered by the max-tree nodes in `nodesToPrune_`.
+     * @details Exact for the area attribute; for box attributes each pruned
+     * subtree is assumed to hold the mean number of pixels per node.
+     */
+    double estimatePrunedPixels() const {
+        if (attribute_ == AREA) {
+            double prunedPixels = 0.0;
+            for (NodeId nodeId : nodesToPrune_) {
+                prunedPixels += maxAttribute_[static_cast<std::size_t>(nodeId)];
+            }
+            return prunedPixels;
+        }
+        const double pixelsPerNode = static_cast<double>(maxtree_->getNumTotalProperParts()) / std::max(1, maxtree_->getNumNodes());
+        return pixelsPerNode * static_cast<double>(nodesToPrune_.size());
+    }
+
+    /**
+     * @brief Prices both strategies of an adaptive step from its counts.
+     * @details Without a caller estimator, the counts are priced with the
+     * measured time per pixel of each strategy. A strategy not timed yet is
+     * priced from the other one, or from unit costs when neither has run, as
+     * if a naive step built the whole image four times and an update moved
+     * each pruned pixel once.
+     */
+    AdaptiveCostEstimate estimateAdaptiveCosts(const AdaptiveStepCounts &counts) const {
+        if (costEstimator_) {
+            return costEstimator_(counts);
+        }
+        constexpr double naivePerUpdatePixel = 4.0;
+        double updateWeight = updateSecondsPerPixel_;
+        double naiveWeight = naiveSecondsPerPixel_;
+        if (updateWeight == 0.0 && naiveWeight == 0.0) {
+            updateWeight = 1.0;
+            naiveWeight = naivePerUpdatePixel;
+        } else if (updateWeight == 0.0) {
+            updateWeight = naiveWeight / naivePerUpdatePixel;
+        } else if (naiveWeight == 0.0) {
+            naiveWeight = naivePerUpdatePixel * updateWeight;
+        }
+        return {updateWeight * counts.prunedPixels, naiveWeight * static_cast<double>(counts.numPixels)};
+    }
+
+    /**
+     * @brief Applies one threshold with the strategy the cost model predicts to be cheaper.
+     * @details The max-tree side of the pruned region, doubled to account for
+     * the min-tree, is compared with the size of the image. Once one strategy
+     * has run for the exploration period in a row, the other one runs for a
+     * step, so a model that once mispriced it can recover. The built-in model
+     * refines the time per pixel of the strategy each step executes.
+     */
+    void applyAdaptiveThreshold(int threshold) {
+        constexpr double smoothing = 0.5;
+        Stopwatch stopwatch;
+        stopwatch.start();
+        collectNodesToPrune(*maxtree_, maxAttribute_, threshold);
+        AdaptiveStepCounts counts;
+        counts.prunedPixels = 2.0 * estimatePrunedPixels();
+        counts.numPixels = static_cast<std::size_t>(maxtree_->getNumTotalProperParts());
+        counts.numNodes = static_cast<std::size_t>(maxtree_->getNumNodes()) + static_cast<std::size_t>(mintree_->getNumNodes());
+        const AdaptiveCostEstimate costs = estimateAdaptiveCosts(counts);
 
-        auto minNodes = getNodesToPrune(*mintree_, minAttribute_, threshold);
-        adjust_->pruneMinTreeAndUpdateMaxTree(minNodes);
+        Mode mode = costs.naiveCost < costs.updateCost ? Mode::Naive : Mode::Updating;
+        if (mode == lastAdaptiveMode_ && adaptiveExplorationPeriod_ > 0 && numConsecutiveAdaptiveSteps_ >= adaptiveExplorationPeriod_) {
+            mode = mode == Mode::Naive ? Mode::Updating : Mode::Naive;
+        }
+        numConsecutiveAdaptiveSteps_ = mode == lastAdaptiveMode_ ? numConsecutiveAdaptiveSteps_ + 1 : 1;
+        lastAdaptiveMode_ = mode;
+
+        if (mode == Mode::Naive) {
+            applyNaiveThreshold(threshold);
+            numAdaptiveNaiveSteps_++;
+            if (!costEstimator_ && counts.numPixels > 0) {
+                const double seconds = std::chrono::duration<double>(stopwatch.elapsed()).count();
+                naiveSecondsPerPixel_ += smoothing * (seconds / static_cast<double>(counts.numPixels) - naiveSecondsPerPixel_);
+            }
+        } else {
+            applyCollectedUpdatingThreshold(threshold);
+            if (!costEstimator_ && counts.prunedPixels > 0.0) {
+                const double seconds = std::chrono::duration<double>(stopwatch.elapsed()).count();
+                updateSecondsPerPixel_ += smoothing * (seconds / counts.prunedPixels - updateSecondsPerPixel_);
+            }
+        }
     }
 
+    /**
+     * @brief Applies one threshold by rebuilding the trees instead of adjusting them.
+     * @details The member trees double as the temporary trees of the naive
+     * filter: the max-tree is rebuilt and pruned from the current image, then
+     * the min-tree from the result, and finally both trees are rebuilt from
+     * the filtered image. The intermediate images live in `scratchImage_`.
+     */
     void applyNaiveThreshold(int threshold) {
-        auto current = mintree_->reconstructionImage();
+        mintree_->reconstructionImage(*scratchImage_);
 
-        DynamicComponentTree maxTree(current, true, adjacency_);
-        const auto maxAttribute = computeAttribute(maxTree, attribute_);
-        for (NodeId nodeId : getNodesToPrune(maxTree, maxAttribute, threshold)) {
-            if (nodeId != maxTree.getRoot()) {
-                maxTree.pruneNode(nodeId);
+        maxtree_->build(scratchImage_, true, adjacency_, maxWorkspace_);
+        maxAttributeComputer_->onTreeRebuilt();
+        computeAttribute(*maxAttributeComputer_, *maxtree_, maxAttribute_);
+        collectNodesToPrune(*maxtree_, maxAttribute_, threshold);
+        for (NodeId nodeId : nodesToPrune_) {
+            if (nodeId != maxtree_->getRoot()) {
+                maxtree_->pruneNode(nodeId);
             }
         }
 
-        current = maxTree.reconstructionImage();
-        DynamicComponentTree minTree(current, false, adjacency_);
-        const auto minAttribute = computeAttribute(minTree, attribute_);
-        for (NodeId nodeId : getNodesToPrune(minTree, minAttribute, threshold)) {
-            if (nodeId != minTree.getRoot()) {
-                minTree.pruneNode(nodeId);
+        maxtree_->reconstructionImage(*scratchImage_);
+        mintree_->build(scratchImage_, false, adjacency_, maxWorkspace_);
+        minAttributeComputer_->onTreeRebuilt();
+        computeAttribute(*minAttributeComputer_, *mintree_, minAttribute_);
+        collectNodesToPrune(*mintree_, minAttribute_, threshold);
+        for (NodeId nodeId : nodesToPrune_) {
+            if (nodeId != mintree_->getRoot()) {
+                mintree_->pruneNode(nodeId);
             }
         }
 
-        rebuildFromImage(minTree.reconstructionImage());
+        mintree_->reconstructionImage(*scratchImage_);
+        rebuildFromImage(scratchImage_);
+    }
+
+    ComponentTreeCasf() = default;
+
+    /**
+     * @brief Creates the attribute computers, the adjuster, and the scratch image for trees and attribute buffers already in place.
+     */
+    void attachToTrees() {
+        maxAttributeComputer_ = makeAttributeComputer(maxtree_.get(), attribute_);
+        minAttributeComputer_ = makeAttributeComputer(mintree_.get(), attribute_);
+        adjust_ = std::make_unique<DualMinMaxTreeIncrementalFilter<PixelType>>(mintree_.get(), maxtree_.get(), *adjacency_);
+        adjust_->setAttributeComputer(*minAttributeComputer_, *maxAttributeComputer_, std::span<float>(minAttribute_), std::span<float>(maxAttribute_));
+        scratchImage_ = Image<PixelType>::create(maxtree_->getNumRowsOfImage(), maxtree_->getNumColsOfImage());
+    }
+
+    /**
+     * @brief Copies `source` into this empty runner, including its trees and attribute buffers.
+     * @details The tree columns are chunked copy-on-write storage, so copying
+     * a tree copies one pointer per chunk and both runners read the same
+     * chunks until one of them writes. The attribute buffers and the output
+     * image are copied in full. The attribute computers and the adjuster are
+     * bound to the copied trees; their summaries and per-step marks are
+     * rebuilt for the copies, which hold the same components as the source.
+     * The build workspaces are not copied: they only carry scratch storage and
+     * grow again on the first rebuild.
+     */
+    void copyStateFrom(const ComponentTreeCasf &source) {
+        adjacency_ = source.adjacency_;
+        attribute_ = source.attribute_;
+        concurrentTreeBuild_ = source.concurrentTreeBuild_;
+        compactionRatio_ = source.compactionRatio_;
+        lazyOwnership_ = source.lazyOwnership_;
+        numCompactions_ = source.numCompactions_;
+        costEstimator_ = source.costEstimator_;
+        naiveSecondsPerPixel_ = source.naiveSecondsPerPixel_;
+        updateSecondsPerPixel_ = source.updateSecondsPerPixel_;
+        adaptiveExplorationPeriod_ = source.adaptiveExplorationPeriod_;
+        lastAdaptiveMode_ = source.lastAdaptiveMode_;
+        numConsecutiveAdaptiveSteps_ = source.numConsecutiveAdaptiveSteps_;
+        numAdaptiveNaiveSteps_ = source.numAdaptiveNaiveSteps_;
+
+        maxtree_ = std::make_unique<DynamicComponentTree>(*source.maxtree_);
+        mintree_ = std::make_unique<DynamicComponentTree>(*source.mintree_);
+        maxAttribute_ = source.maxAttribute_;
+        minAttribute_ = source.minAttribute_;
+        attachToTrees();
+        // The copied min-tree carries the pending change log of the source, so
+        // its output image stays consistent with the copied trees.
+        output_ = source.output_->clone();
     }
 
 public:
-    ComponentTreeCasf(ImageUInt8Ptr image, double radiusAdj, Attribute attribute = AREA)
+    /**
+     * @brief Builds both trees of `image` and prepares the incremental filter.
+     * @details The image is only read while the trees are built and is not
+     * retained, so it may be an `Image::view` over a caller-owned buffer.
+     */
+    ComponentTreeCasf(ImagePtr<PixelType> image, double radiusAdj, Attribute attribute = AREA)
         : adjacency_(image ? std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), radiusAdj) : nullptr), attribute_(attribute) {
         rebuildFromImage(image);
     }
 
-    ComponentTreeCasf(ImageUInt8Ptr image, AdjacencyRelationPtr adjacency, Attribute attribute = AREA)
+    ComponentTreeCasf(ImagePtr<PixelType> image, AdjacencyRelationPtr adjacency, Attribute attribute = AREA)
         : adjacency_(std::move(adjacency)), attribute_(attribute) {
         if (adjacency_ == nullptr) {
             throw std::runtime_error("ComponentTreeCasf requires a valid adjacency relation.");
@@ -141,6 +397,73 @@ public:
         rebuildFromImage(image);
     }
 
+    /**
+     * @brief Builds the max-tree and min-tree on two threads in later rebuilds.
+     *
+     * Affects the naive, hybrid, and adaptive modes, which rebuild both trees from the
+     * current image at each naive threshold.
+     */
+    void setConcurrentTreeBuild(bool enabled) {
+        concurrentTreeBuild_ = enabled;
+    }
+
+    /**
+     * @brief Compacts a tree between thresholds once released slots exceed `ratio` of its id space.
+     * @details Prunes leave released slots scattered over the node-id space;
+     * compaction renumbers the live nodes breadth-first so later steps walk
+     * dense memory, and relinks the proper parts of each node in pixel order.
+     * The attribute buffers follow the new ids. A ratio `<= 0`,
+     * the default, disables compaction.
+     * @see DynamicComponentTree::compact
+     */
+    void setCompactionRatio(double ratio) {
+        compactionRatio_ = ratio;
+    }
+
+    /**
+     * @brief Selects lazy proper-part ownership for both trees.
+     * @details Speeds up updating steps that merge large regions into nodes
+     * of the same level. The gain is mostly on the max-tree: the min-tree
+     * keeps the change log that patches the incremental output, and the log
+     * is kept per pixel, so a min-tree move between nodes of different
+     * altitudes still visits every moved pixel with lazy ownership on.
+     * `BM_component_tree_casf_lazy_ownership` in the benchmark suite
+     * measures both settings on the same sequences: lazy ownership wins on
+     * piecewise-constant scenes and loses on the structured model, where
+     * its owner lookups cost more than the merges save, so it stays off by
+     * default.
+     * @see DynamicComponentTree::setLazyProperPartOwnership
+     */
+    void setLazyProperPartOwnership(bool enabled) {
+        lazyOwnership_ = enabled;
+        maxtree_->setLazyProperPartOwnership(enabled);
+        mintree_->setLazyProperPartOwnership(enabled);
+    }
+
+    /**
+     * @brief Number of tree compactions triggered by the compaction ratio.
+     */
+    std::size_t getNumCompactions() const {
+        return numCompactions_;
+    }
+
+    /**
+     * @brief Rebinds the filter to a new image of the same shape.
+     * @details Both trees, the attribute computers, the adjuster, and the build
+     * workspaces are rebuilt in place, so filtering a stream of same-shaped
+     * images through one instance reuses their storage instead of allocating
+     * it again for every frame.
+     */
+    void reset(ImagePtr<PixelType> image) {
+        if (image == nullptr) {
+            throw std::runtime_error("ComponentTreeCasf requires a valid image.");
+        }
+        if (!hasSameShape(image)) {
+            throw std::runtime_error("ComponentTreeCasf::reset requires an image with the shape of the adjacency relation.");
+        }
+        rebuildFromImage(image);
+    }
+
     static Mode parseMode(std::string_view mode) {
         const std::string normalized = normalizeToken(mode);
         if (normalized == "updating" || normalized == "updaing") {
@@ -152,37 +475,318 @@ public:
         if (normalized == "hybrid") {
             return Mode::Hybrid;
         }
+        if (normalized == "adaptive") {
+            return Mode::Adaptive;
+        }
 
-        throw std::runtime_error("Unknown ComponentTreeCasf mode. Expected one of: updating, naive, hybrid.");
+        throw std::runtime_error("Unknown ComponentTreeCasf mode. Expected one of: updating, naive, hybrid, adaptive.");
     }
 
-    ImageUInt8Ptr filter(const std::vector<int> &thresholds, Mode mode = Mode::Updating) {
-        switch (mode) {
-            case Mode::Updating:
-                for (int threshold : thresholds) {
-                    applyUpdatingThreshold(threshold);
-                }
-                break;
-            case Mode::Naive:
-                for (int threshold : thresholds) {
-                    applyNaiveThreshold(threshold);
+    /**
+     * @brief Applies the threshold schedule and reports each intermediate step.
+     * @param onThreshold Called as `onThreshold(step, threshold)` after every
+     * threshold, once both trees represent the image filtered up to that step.
+     * @details Visitors read the intermediate result from the trees, for
+     * example with `getMinTree().reconstructionImage(out)`, so one pass yields
+     * the whole morphological profile of the schedule.
+     */
+    template<typename OnThreshold>
+    ImagePtr<PixelType> filter(const std::vector<int> &thresholds, Mode mode, OnThreshold &&onThreshold) {
+        for (std::size_t step = 0; step < thresholds.size(); ++step) {
+            if (mode == Mode::Adaptive) {
+                applyAdaptiveThreshold(thresholds[step]);
+            } else if (mode == Mode::Naive || (mode == Mode::Hybrid && step == 0)) {
+                applyNaiveThreshold(thresholds[step]);
+            } else {
+                applyUpdatingThreshold(thresholds[step]);
+            }
+            compactFragmentedTrees();
+            onThreshold(step, thresholds[step]);
+        }
+
+        return getFilteredImage()->clone();
+    }
+
+    ImagePtr<PixelType> filter(const std::vector<int> &thresholds, Mode mode = Mode::Updating) {
+        return filter(thresholds, mode, [](std::size_t, int) {});
+    }
+
+    ImagePtr<PixelType> filter(const std::vector<int> &thresholds, std::string_view mode) {
+        return filter(thresholds, parseMode(mode));
+    }
+
+    /**
+     * @brief Returns an independent runner in the current state of this one.
+     * @details Filtering the fork continues from the thresholds already
+     * applied here, so schedule variants that share a prefix pay for the
+     * prefix once. Both trees are shared copy-on-write in chunks of
+     * `ChunkedColumn::ChunkSize` values, so a fork costs `O((N + P) / ChunkSize)`
+     * for the trees and each branch only copies the chunks its own updates
+     * write to; `DynamicComponentTree::getExclusiveMemoryUsage` reports that
+     * share. The attribute buffers, the output image and the adjuster's
+     * per-step marks are still allocated per fork. Later calls on either
+     * runner never affect the other, and forks of one runner may be filtered
+     * on different threads while it is left untouched.
+     */
+    std::unique_ptr<ComponentTreeCasf> fork() const {
+        std::unique_ptr<ComponentTreeCasf> forked(new ComponentTreeCasf());
+        forked->copyStateFrom(*this);
+        return forked;
+    }
+
+    /**
+     * @brief Continues the current state with several schedules on a thread pool.
+     * @param schedules Threshold schedules applied after the thresholds already filtered here.
+     * @param mode Strategy used by every branch.
+     * @param numThreads Number of workers; `<= 0` uses the hardware concurrency.
+     * @return One filtered image per schedule, in the order of `schedules`.
+     * @details Each branch runs on a fork of this runner, which is left in its
+     * current state. Work is distributed and errors are reported as in `filterBatch`.
+     */
+    std::vector<ImagePtr<PixelType>> filterBranches(const std::vector<std::vector<int>> &schedules, Mode mode = Mode::Updating, int numThreads = 0) const {
+        std::vector<ImagePtr<PixelType>> filtered(schedules.size());
+        if (schedules.empty()) {
+            return filtered;
+        }
+        if (numThreads <= 0) {
+            numThreads = (int) std::max(1u, std::thread::hardware_concurrency());
+        }
+        numThreads = (int) std::min<std::size_t>((std::size_t) numThreads, schedules.size());
+
+        std::atomic<std::size_t> nextSchedule{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr firstError;
+        std::atomic_flag errorClaimed = ATOMIC_FLAG_INIT;
+        auto worker = [&]() {
+            try {
+                for (std::size_t i = nextSchedule.fetch_add(1); i < schedules.size() && !failed.load(); i = nextSchedule.fetch_add(1)) {
+                    filtered[i] = fork()->filter(schedules[i], mode);
                 }
-                break;
-            case Mode::Hybrid:
-                if (!thresholds.empty()) {
-                    applyNaiveThreshold(thresholds.front());
-                    for (std::size_t i = 1; i < thresholds.size(); ++i) {
-                        applyUpdatingThreshold(thresholds[i]);
-                    }
+            } catch (...) {
+                if (!errorClaimed.test_and_set()) {
+                    firstError = std::current_exception();
                 }
-                break;
+                failed.store(true);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve((std::size_t) numThreads - 1);
+        for (int t = 1; t < numThreads; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : workers) {
+            thread.join();
         }
+        if (firstError) {
+            std::rethrow_exception(firstError);
+        }
+        return filtered;
+    }
 
-        return mintree_->reconstructionImage();
+    /**
+     * @brief Writes both trees and their attribute buffers to a versioned binary snapshot.
+     * @details Loading the snapshot with `loadSnapshot` restores the runner
+     * in this state without building any tree, which replaces the rebuild at
+     * worker start-up with a bulk read. The pixel type is recorded and must
+     * match at load time; the adjustment settings are not saved.
+     */
+    void writeSnapshot(std::ostream &out) const {
+        SnapshotIO::writeHeader(out, SnapshotMagic, SnapshotVersion);
+        SnapshotIO::write(out, (int32_t) (8 * sizeof(PixelType)));
+        SnapshotIO::write(out, (int32_t) attribute_);
+        maxtree_->writeSnapshot(out);
+        mintree_->writeSnapshot(out);
+        SnapshotIO::writeVector(out, maxAttribute_);
+        SnapshotIO::writeVector(out, minAttribute_);
+        if (!out) {
+            throw std::runtime_error("ComponentTreeCasf snapshot could not be written.");
+        }
     }
 
-    ImageUInt8Ptr filter(const std::vector<int> &thresholds, std::string_view mode) {
-        return filter(thresholds, parseMode(mode));
+    /**
+     * @brief Restores a runner from a snapshot written by `writeSnapshot`.
+     * @details Both trees share one adjacency relation rebuilt from the
+     * stored stencil. The first `getFilteredImage` rewrites the whole output.
+     */
+    static std::unique_ptr<ComponentTreeCasf> loadSnapshot(std::istream &in) {
+        if (readSnapshotBitDepth(in) != (int) (8 * sizeof(PixelType))) {
+            throw std::runtime_error("ComponentTreeCasf snapshot was written for another pixel type.");
+        }
+        SnapshotIO::readHeader(in, SnapshotMagic, SnapshotVersion, "ComponentTreeCasf");
+        int32_t bitDepth = 0;
+        int32_t attribute = 0;
+        SnapshotIO::read(in, bitDepth, "ComponentTreeCasf");
+        SnapshotIO::read(in, attribute, "ComponentTreeCasf");
+        if (attribute < (int32_t) AREA || attribute > (int32_t) DIAGONAL_LENGTH) {
+            throw std::runtime_error("ComponentTreeCasf snapshot has an unknown attribute.");
+        }
+
+        std::unique_ptr<ComponentTreeCasf> loaded(new ComponentTreeCasf());
+        loaded->attribute_ = static_cast<Attribute>(attribute);
+        loaded->maxtree_ = std::make_unique<DynamicComponentTree>();
+        loaded->maxtree_->readSnapshot(in);
+        loaded->adjacency_ = loaded->maxtree_->getAdjacencyRelation();
+        loaded->mintree_ = std::make_unique<DynamicComponentTree>();
+        loaded->mintree_->readSnapshot(in, loaded->adjacency_);
+        if (!loaded->maxtree_->isMaxtree() || loaded->mintree_->isMaxtree() ||
+            loaded->mintree_->getNumTotalProperParts() != loaded->maxtree_->getNumTotalProperParts()) {
+            throw std::runtime_error("ComponentTreeCasf snapshot does not hold a max-tree and min-tree pair.");
+        }
+        SnapshotIO::readVector(in, loaded->maxAttribute_, (std::size_t) loaded->maxtree_->getNumInternalNodeSlots(), "ComponentTreeCasf");
+        SnapshotIO::readVector(in, loaded->minAttribute_, (std::size_t) loaded->mintree_->getNumInternalNodeSlots(), "ComponentTreeCasf");
+        loaded->attachToTrees();
+        loaded->output_ = Image<PixelType>::create(loaded->maxtree_->getNumRowsOfImage(), loaded->maxtree_->getNumColsOfImage());
+        loaded->mintree_->setTrackPixelChanges(true);
+        return loaded;
+    }
+
+    /**
+     * @brief Pixel bit depth recorded in a runner snapshot, read without consuming the stream.
+     * @details Lets callers that handle several pixel types pick the
+     * instantiation whose `loadSnapshot` accepts the file.
+     */
+    static int readSnapshotBitDepth(std::istream &in) {
+        const auto start = in.tellg();
+        SnapshotIO::readHeader(in, SnapshotMagic, SnapshotVersion, "ComponentTreeCasf");
+        int32_t bitDepth = 0;
+        SnapshotIO::read(in, bitDepth, "ComponentTreeCasf");
+        in.seekg(start);
+        return bitDepth;
+    }
+
+    /**
+     * @brief Number of thresholds the adaptive mode has applied by rebuilding.
+     */
+    std::size_t getNumAdaptiveNaiveSteps() const {
+        return numAdaptiveNaiveSteps_;
+    }
+
+    /**
+     * @brief Strategy of the last adaptive step: `Mode::Naive` or `Mode::Updating`.
+     * @details `Mode::Updating` before the first adaptive step.
+     */
+    Mode getLastAdaptiveMode() const {
+        return lastAdaptiveMode_;
+    }
+
+    /**
+     * @brief Replaces the built-in cost model of the adaptive mode.
+     * @details `estimator` prices both strategies from the counts of each
+     * step, and the cheaper one runs; ties go to the update. Estimators that
+     * only read the counts make the adaptive mode deterministic, which the
+     * timed built-in model is not. An empty estimator restores the built-in
+     * model. Forks and branches share a copy of the estimator, so one used
+     * with `filterBranches` must be safe to call from several threads.
+     */
+    void setAdaptiveCostEstimator(AdaptiveCostEstimator estimator) {
+        costEstimator_ = std::move(estimator);
+    }
+
+    /**
+     * @brief Forces the other adaptive strategy after `period` consecutive steps of one.
+     * @details Keeps both estimates of the built-in model current when the
+     * costs drift along the schedule. Zero disables exploration; the default is 8.
+     */
+    void setAdaptiveExplorationPeriod(std::size_t period) {
+        adaptiveExplorationPeriod_ = period;
+    }
+
+    /**
+     * @brief Current filtered image, kept up to date incrementally.
+     * @details The min-tree logs the pixels whose owner altitude changes, so
+     * refreshing this image costs time proportional to the region edited
+     * since the previous call rather than to the image size; after a rebuild
+     * the whole image is rewritten once. The image is owned by the runner and
+     * is overwritten by later calls.
+     */
+    const ImagePtr<PixelType> &getFilteredImage() {
+        mintree_->updateReconstructionImage(*output_);
+        return output_;
+    }
+
+    /**
+     * @brief Filters with `thresholds` and returns the image after every threshold.
+     * @return One image per threshold; entry `i` equals a fresh `filter` run
+     * with the first `i + 1` thresholds.
+     */
+    std::vector<ImagePtr<PixelType>> filterProfile(const std::vector<int> &thresholds, Mode mode = Mode::Updating) {
+        std::vector<ImagePtr<PixelType>> profile;
+        profile.reserve(thresholds.size());
+        filter(thresholds, mode, [&](std::size_t, int) {
+            profile.push_back(getFilteredImage()->clone());
+        });
+        return profile;
+    }
+
+    /**
+     * @brief Filters many images with the same threshold schedule on a thread pool.
+     * @param images Input images; shapes may differ between entries.
+     * @param thresholds Threshold schedule applied to every image.
+     * @param numThreads Number of workers; `<= 0` uses the hardware concurrency.
+     * @return Filtered images, in the order of `images`.
+     * @details Workers claim the next unprocessed image from a shared atomic
+     * cursor, so a worker that finishes early keeps pulling work while others
+     * are busy on large images. Each worker owns one runner and recycles it
+     * with `reset` whenever consecutive images share a shape, so its trees and
+     * build workspaces are allocated once per shape instead of once per image.
+     * The first exception thrown by a worker is rethrown after all workers stop.
+     */
+    static std::vector<ImagePtr<PixelType>> filterBatch(const std::vector<ImagePtr<PixelType>> &images,
+                                                        const std::vector<int> &thresholds,
+                                                        double radiusAdj,
+                                                        Attribute attribute = AREA,
+                                                        Mode mode = Mode::Updating,
+                                                        int numThreads = 0) {
+        std::vector<ImagePtr<PixelType>> filtered(images.size());
+        if (images.empty()) {
+            return filtered;
+        }
+        if (numThreads <= 0) {
+            numThreads = (int) std::max(1u, std::thread::hardware_concurrency());
+        }
+        numThreads = (int) std::min<std::size_t>((std::size_t) numThreads, images.size());
+
+        std::atomic<std::size_t> nextImage{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr firstError;
+        std::atomic_flag errorClaimed = ATOMIC_FLAG_INIT;
+        auto worker = [&]() {
+            std::unique_ptr<ComponentTreeCasf> runner;
+            try {
+                for (std::size_t i = nextImage.fetch_add(1); i < images.size() && !failed.load(); i = nextImage.fetch_add(1)) {
+                    if (images[i] == nullptr) {
+                        throw std::runtime_error("ComponentTreeCasf::filterBatch requires valid images.");
+                    }
+                    if (runner != nullptr && runner->hasSameShape(images[i])) {
+                        runner->reset(images[i]);
+                    } else {
+                        runner = std::make_unique<ComponentTreeCasf>(images[i], radiusAdj, attribute);
+                    }
+                    filtered[i] = runner->filter(thresholds, mode);
+                }
+            } catch (...) {
+                if (!errorClaimed.test_and_set()) {
+                    firstError = std::current_exception();
+                }
+                failed.store(true);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve((std::size_t) numThreads - 1);
+        for (int t = 1; t < numThreads; ++t) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : workers) {
+            thread.join();
+        }
+        if (firstError) {
+            std::rethrow_exception(firstError);
+        }
+        return filtered;
     }
 
     DynamicComponentTree &getMaxTree() {
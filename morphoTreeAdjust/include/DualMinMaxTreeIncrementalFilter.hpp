@@ -125,18 +125,13 @@ public:
      */
     class MergedNodesCollection {
     private:
-        static_assert(std::numeric_limits<PixelType>::is_integer, "MergedNodesCollection requires integral PixelType");
-        static_assert(std::numeric_limits<PixelType>::lowest() == 0, "MergedNodesCollection expects non-negative contiguous levels");
-        static constexpr std::size_t NumLevels = static_cast<std::size_t>(std::numeric_limits<PixelType>::max()) + 1;
-
-        std::array<std::vector<NodeId>, NumLevels> mergeNodesByLevelStorage_;
-        std::vector<PixelType> mergeLevels_;
+        LevelBuckets<PixelType> mergeNodesByLevelStorage_;
         std::vector<NodeId> frontierNodesAboveB_;
         GenerationStampSet collectedNodeMarks_;
         GenerationStampSet mergeBucketNodeMarks_;
         GenerationStampSet adjacentSeedMarks_;
-        std::size_t maxBucketSize_ = 0;
         int currentMergeLevelIndex_ = 0;
+        int numMergeLevels_ = 0;
         bool isMaxtree_ = false;
 
     public:
@@ -149,33 +144,40 @@ public:
               mergeBucketNodeMarks_(std::max(0, maxNodes)),
               adjacentSeedMarks_(std::max(0, maxNodes)) {}
 
+        /**
+         * @brief Resizes the node marks for a new node-id space.
+         * @details The marks are refilled in place, so a collection that has
+         * already seen a node-id space at least as large does not allocate.
+         * @param maxNodes Expected maximum size of the node id space.
+         */
+        void resize(int maxNodes) {
+            collectedNodeMarks_.resize((std::size_t) std::max(0, maxNodes));
+            mergeBucketNodeMarks_.resize((std::size_t) std::max(0, maxNodes));
+            adjacentSeedMarks_.resize((std::size_t) std::max(0, maxNodes));
+        }
+
         /**
          * @brief Reinitializes all temporary state for a new adjustment step.
          * @param isMaxtree `true` for a max-tree update and `false` for a min-tree update.
          */
         void resetCollection(bool isMaxtree) {
             isMaxtree_ = isMaxtree;
-            for (auto level : mergeLevels_) {
-                // The current backend uses one preallocated bucket for every
-                // possible altitude, so it is enough to clear the levels that became active.
-                mergeNodesByLevelStorage_[static_cast<std::size_t>(level)].clear();
-            }
-            mergeLevels_.clear();
+            mergeNodesByLevelStorage_.clear();
             frontierNodesAboveB_.clear();
             collectedNodeMarks_.resetAll();
             mergeBucketNodeMarks_.resetAll();
             adjacentSeedMarks_.resetAll();
-            maxBucketSize_ = 0;
             currentMergeLevelIndex_ = 0;
+            numMergeLevels_ = 0;
         }
 
         /**
          * @brief Returns the bucket associated with an altitude value.
          * @param level Queried level.
-         * @return Mutable reference to the bucket corresponding to `level`.
+         * @return Read-only view of the nodes collected at `level`, in insertion order.
          */
-        std::vector<NodeId> &getMergedNodes(const PixelType &level) {
-            return mergeNodesByLevelStorage_[static_cast<std::size_t>(level)];
+        std::span<const NodeId> getMergedNodes(const PixelType &level) {
+            return mergeNodesByLevelStorage_.nodesAt(level);
         }
 
         /**
@@ -206,7 +208,7 @@ public:
          * reintroducing reallocations on the hot path.
          */
         std::size_t getMaxBucketSize() const {
-            return maxBucketSize_;
+            return mergeNodesByLevelStorage_.maxBucketSize();
         }
 
         /**
@@ -231,9 +233,7 @@ public:
                 return;
             }
 
-            auto &bucket = getMergedNodes(static_cast<PixelType>(tree.getAltitude(nodeId)));
-            bucket.push_back(nodeId);
-            maxBucketSize_ = std::max(maxBucketSize_, bucket.size());
+            mergeNodesByLevelStorage_.push(static_cast<PixelType>(tree.getAltitude(nodeId)), nodeId);
             collectedNodeMarks_.mark(nodeId);
             mergeBucketNodeMarks_.mark(nodeId);
         }
@@ -248,36 +248,29 @@ public:
 
         /**
          * @brief Builds the ordered list of active levels and returns the first one.
-         * @details Because the current implementation uses dense altitude-indexed
-         * buckets, the collection scans the full discrete domain and keeps only
-         * the levels that remained non-empty in the current step.
+         * @details Only the levels that received a bucket in the current step
+         * are visited, so the cost does not depend on the size of the
+         * gray-level domain.
          */
         PixelType firstMergeLevel() {
-            mergeLevels_.clear();
-            // The altitude domain is discrete and dense in this backend, so the
-            // scan visits all levels and keeps only the non-empty ones.
-            for (std::size_t i = 0; i < mergeNodesByLevelStorage_.size(); ++i) {
-                if (!mergeNodesByLevelStorage_[i].empty()) {
-                    mergeLevels_.push_back(static_cast<PixelType>(i));
-                }
-            }
-
-            if (mergeLevels_.empty()) {
+            mergeNodesByLevelStorage_.seal();
+            numMergeLevels_ = static_cast<int>(mergeNodesByLevelStorage_.levels().size());
+            if (numMergeLevels_ == 0) {
                 return PixelType{};
             }
 
-            currentMergeLevelIndex_ = isMaxtree_ ? (int) mergeLevels_.size() - 1 : 0;
-            return mergeLevels_[currentMergeLevelIndex_];
+            currentMergeLevelIndex_ = isMaxtree_ ? numMergeLevels_ - 1 : 0;
+            return mergeNodesByLevelStorage_.levels()[currentMergeLevelIndex_];
         }
 
         /**
          * @brief Returns `true` while there is still an active bucket to visit in the sweep.
          * @details The internal iterator does not traverse empty levels; it
-         * navigates only the compact `mergeLevels_` list built in
+         * navigates only the sorted active levels sealed by
          * `firstMergeLevel()`. This helper is the main guard of the sweep loop.
          */
         bool hasMergeLevel() const {
-            return !mergeLevels_.empty() && currentMergeLevelIndex_ >= 0 && currentMergeLevelIndex_ < (int) mergeLevels_.size();
+            return currentMergeLevelIndex_ >= 0 && currentMergeLevelIndex_ < numMergeLevels_;
         }
 
         /**
@@ -292,7 +285,7 @@ public:
             if (!hasMergeLevel()) {
                 return PixelType{};
             }
-            return mergeLevels_[currentMergeLevelIndex_];
+            return mergeNodesByLevelStorage_.levels()[currentMergeLevelIndex_];
         }
     };
 
@@ -300,7 +293,7 @@ private:
     // Dynamic primal/dual trees and shared adjacency of the domain.
     DynamicComponentTree *mintree_ = nullptr;
     DynamicComponentTree *maxtree_ = nullptr;
-    AdjacencyRelation *graph_ = nullptr;
+    const AdjacencyRelation *graph_ = nullptr;
 
     // Incremental computers and external buffers used after local edits.
     DynamicAttributeComputer *attrComputerMin_ = nullptr;
@@ -965,7 +958,7 @@ public:
      * @param maxtree Pointer to the dynamic max-tree owned externally.
      * @param graph Adjacency relation shared by both trees.
      */
-    DualMinMaxTreeIncrementalFilter(DynamicComponentTree *mintree, DynamicComponentTree *maxtree, AdjacencyRelation &graph)
+    DualMinMaxTreeIncrementalFilter(DynamicComponentTree *mintree, DynamicComponentTree *maxtree, const AdjacencyRelation &graph)
         : mintree_(mintree), maxtree_(maxtree), graph_(&graph),
           mergeNodesByLevel_(std::max(mintree ? mintree->getNumInternalNodeSlots() : 0, maxtree ? maxtree->getNumInternalNodeSlots() : 0)),
           removedMarks_(std::max(mintree ? mintree->getNumInternalNodeSlots() : 0, maxtree ? maxtree->getNumInternalNodeSlots() : 0)),
@@ -977,6 +970,24 @@ public:
         assert(graph_ != nullptr);
     }
 
+    /**
+     * @brief Resizes the per-step state after both trees were rebuilt in place.
+     * @details Must be called when the associated trees are rebuilt through
+     * `DynamicComponentTree::build` or `buildMinMaxTrees`, whose node-id space
+     * depends on the image. The marks keep their capacity, so processing a
+     * stream of same-shaped images does not allocate here once the largest
+     * id space has been seen.
+     */
+    void onTreesRebuilt() {
+        const int maxNodes = std::max(mintree_->getNumInternalNodeSlots(), maxtree_->getNumInternalNodeSlots());
+        const int maxPixels = std::max(mintree_->getNumTotalProperParts(), maxtree_->getNumTotalProperParts());
+        mergeNodesByLevel_.resize(maxNodes);
+        removedMarks_.resize((std::size_t) maxNodes);
+        pixelsInCMarks_.resize((std::size_t) maxPixels);
+        climbedNodeMarks_.resize((std::size_t) maxNodes);
+        attributeUpdateMarks_.resize((std::size_t) maxNodes);
+    }
+
     /**
      * @brief Clears the textual log from the last adjustment.
      */
@@ -1003,9 +1014,9 @@ public:
     /**
      * @brief Returns the merge bucket associated with an altitude value.
      * @param level Queried level.
-     * @return Mutable reference to the bucket for that level.
+     * @return Read-only view of the nodes collected at that level.
      */
-    std::vector<NodeId> &getMergedNodes(const PixelType &level) {
+    std::span<const NodeId> getMergedNodes(const PixelType &level) {
         return mergeNodesByLevel_.getMergedNodes(level);
     }
 
@@ -1061,56 +1072,59 @@ public:
 
         // Phase 2: for each pixel of C, locate valid adjacent seeds and climb
         // each relevant ancestral path only once.
-        for (PixelId p : properPartSetC) {
-            for (PixelId q : graph_->getNeighborPixels(p)) {
-                if (pixelsInCMarks_.isMarked(static_cast<std::size_t>(q))) {
-                    continue; // Neighbors internal to C do not generate adjacent seeds.
-                }
-
-                const NodeId nodeQ = dualTree->getSmallestComponent(q);
-                if (nodeQ == InvalidNode) {
-                    continue; // Pixels without a corresponding live component do not enter the collection.
-                }
-
-                const PixelType altitudeQ = static_cast<PixelType>(dualTree->getAltitude(nodeQ));
-                const bool validSeed = (isMaxtree && altitudeQ >= altitudeCa) || (!isMaxtree && altitudeQ <= altitudeCa);
-                if (!validSeed) {
-                    continue; // Seeds outside the valid interval do not participate in the merge.
-                }
+        graph_->withStencil([&](auto stencil) {
+            using Stencil = decltype(stencil);
+            for (PixelId p : properPartSetC) {
+                Stencil::forEachNeighbor(*graph_, p, [&](PixelId q) {
+                    if (pixelsInCMarks_.isMarked(static_cast<std::size_t>(q))) {
+                        return; // Neighbors internal to C do not generate adjacent seeds.
+                    }
 
-                if (mergeNodesByLevel_.markAdjacentSeed(nodeQ)) {
-                    NodeId nodeSubtree = nodeQ;
-                    NodeId n = nodeQ;
-                    while (n != InvalidNode && dualTree->isAlive(n) && !climbedNodeMarks_.isMarked(static_cast<std::size_t>(n))) {
-                        const PixelType levelCurrent = static_cast<PixelType>(dualTree->getAltitude(n));
-                        if (!((isMaxtree && levelCurrent >= altitudeCa) || (!isMaxtree && levelCurrent <= altitudeCa))) {
-                            break; // The climb left the level interval relevant to C.
-                        }
+                    const NodeId nodeQ = dualTree->getSmallestComponent(q);
+                    if (nodeQ == InvalidNode) {
+                        return; // Pixels without a corresponding live component do not enter the collection.
+                    }
 
-                        climbedNodeMarks_.mark(static_cast<std::size_t>(n));
-                        nodeSubtree = n;
+                    const PixelType altitudeQ = static_cast<PixelType>(dualTree->getAltitude(nodeQ));
+                    const bool validSeed = (isMaxtree && altitudeQ >= altitudeCa) || (!isMaxtree && altitudeQ <= altitudeCa);
+                    if (!validSeed) {
+                        return; // Seeds outside the valid interval do not participate in the merge.
+                    }
 
-                        if ((isMaxtree && levelCurrent <= b) || (!isMaxtree && levelCurrent >= b)) {
-                            mergeNodesByLevel_.addMergeNode(*dualTree, nodeSubtree);
-                        } else {
-                            NodeId parentId = dualTree->getNodeParent(nodeSubtree);
-                            if (parentId == nodeSubtree) {
-                                parentId = InvalidNode;
+                    if (mergeNodesByLevel_.markAdjacentSeed(nodeQ)) {
+                        NodeId nodeSubtree = nodeQ;
+                        NodeId n = nodeQ;
+                        while (n != InvalidNode && dualTree->isAlive(n) && !climbedNodeMarks_.isMarked(static_cast<std::size_t>(n))) {
+                            const PixelType levelCurrent = static_cast<PixelType>(dualTree->getAltitude(n));
+                            if (!((isMaxtree && levelCurrent >= altitudeCa) || (!isMaxtree && levelCurrent <= altitudeCa))) {
+                                break; // The climb left the level interval relevant to C.
                             }
-                            if (!(parentId != InvalidNode && ((isMaxtree && dualTree->getAltitude(parentId) > b) || (!isMaxtree && dualTree->getAltitude(parentId) < b)))) {
-                                mergeNodesByLevel_.addFrontierNodeAboveB(nodeSubtree);
+
+                            climbedNodeMarks_.mark(static_cast<std::size_t>(n));
+                            nodeSubtree = n;
+
+                            if ((isMaxtree && levelCurrent <= b) || (!isMaxtree && levelCurrent >= b)) {
+                                mergeNodesByLevel_.addMergeNode(*dualTree, nodeSubtree);
+                            } else {
+                                NodeId parentId = dualTree->getNodeParent(nodeSubtree);
+                                if (parentId == nodeSubtree) {
+                                    parentId = InvalidNode;
+                                }
+                                if (!(parentId != InvalidNode && ((isMaxtree && dualTree->getAltitude(parentId) > b) || (!isMaxtree && dualTree->getAltitude(parentId) < b)))) {
+                                    mergeNodesByLevel_.addFrontierNodeAboveB(nodeSubtree);
+                                }
                             }
-                        }
 
-                        const NodeId parentId = dualTree->getNodeParent(n);
-                        if (parentId == n) {
-                            break; // Reached the structural top of this path.
+                            const NodeId parentId = dualTree->getNodeParent(n);
+                            if (parentId == n) {
+                                break; // Reached the structural top of this path.
+                            }
+                            n = parentId;
                         }
-                        n = parentId;
                     }
-                }
+                });
             }
-        }
+        });
     }
 
 
@@ -1206,7 +1220,7 @@ public:
             outputLog_ << "F_λ = { ";
             int lambda = (int) b;
             while (lambda != altitudeCa) {
-                auto &mergeNodesAtLevel = mergeNodesByLevel_.getMergedNodes(lambda);
+                const auto mergeNodesAtLevel = mergeNodesByLevel_.getMergedNodes(lambda);
                 if (!mergeNodesAtLevel.empty()) {
                     outputLog_ << lambda << ":[ ";
                     for (auto node : mergeNodesAtLevel) {
@@ -1230,7 +1244,7 @@ public:
         NodeId previousLevelUnionNode = InvalidNode;
         nodesPendingRemoval_.reserve(mergeNodesByLevel_.getMaxBucketSize());
         while (mergeNodesByLevel_.hasMergeLevel() && ((isMaxtree && currentMergeLevel > altitudeCa) || (!isMaxtree && currentMergeLevel < altitudeCa))) {
-            auto &nodesAtCurrentLevel = mergeNodesByLevel_.getMergedNodes((int) currentMergeLevel);
+            const auto nodesAtCurrentLevel = mergeNodesByLevel_.getMergedNodes((int) currentMergeLevel);
             currentUnionNode = InvalidNode;
             nodesPendingRemoval_.clear();
 
@@ -194,18 +194,13 @@ public:
      */
     class MergedNodesCollection {
     private:
-        static_assert(std::numeric_limits<PixelType>::is_integer, "MergedNodesCollection requires integral PixelType");
-        static_assert(std::numeric_limits<PixelType>::lowest() == 0, "MergedNodesCollection expects non-negative contiguous levels");
-        static constexpr std::size_t NumLevels = static_cast<std::size_t>(std::numeric_limits<PixelType>::max()) + 1;
-
-        std::array<std::vector<NodeId>, NumLevels> mergeNodesByLevelStorage_;
-        std::vector<PixelType> mergeLevels_;
+        LevelBuckets<PixelType> mergeNodesByLevelStorage_;
         std::vector<NodeId> frontierNodesAboveB_;
         GenerationStampSet collectedNodeMarks_;
         GenerationStampSet mergeBucketNodeMarks_;
         GenerationStampSet adjacentSeedMarks_;
-        std::size_t maxBucketSize_ = 0;
         int currentMergeLevelIndex_ = 0;
+        int numMergeLevels_ = 0;
         bool isMaxtree_ = false;
 
     public:
@@ -224,27 +219,22 @@ public:
          */
         void resetCollection(bool isMaxtree) {
             isMaxtree_ = isMaxtree;
-            for (auto level : mergeLevels_) {
-                // The current backend uses one preallocated bucket for every
-                // possible altitude, so it is enough to clear the levels that became active.
-                mergeNodesByLevelStorage_[static_cast<std::size_t>(level)].clear();
-            }
-            mergeLevels_.clear();
+            mergeNodesByLevelStorage_.clear();
             frontierNodesAboveB_.clear();
             collectedNodeMarks_.resetAll();
             mergeBucketNodeMarks_.resetAll();
             adjacentSeedMarks_.resetAll();
-            maxBucketSize_ = 0;
             currentMergeLevelIndex_ = 0;
+            numMergeLevels_ = 0;
         }
 
         /**
          * @brief Returns the bucket associated with an altitude value.
          * @param level Queried level.
-         * @return Mutable reference to the bucket corresponding to `level`.
+         * @return Read-only view of the nodes collected at `level`, in insertion order.
          */
-        std::vector<NodeId> &getMergedNodes(const PixelType &level) {
-            return mergeNodesByLevelStorage_[static_cast<std::size_t>(level)];
+        std::span<const NodeId> getMergedNodes(const PixelType &level) {
+            return mergeNodesByLevelStorage_.nodesAt(level);
         }
 
         /**
@@ -275,7 +265,7 @@ public:
          * reintroducing reallocations on the hot path.
          */
         std::size_t getMaxBucketSize() const {
-            return maxBucketSize_;
+            return mergeNodesByLevelStorage_.maxBucketSize();
         }
 
         /**
@@ -300,9 +290,7 @@ public:
                 return;
             }
 
-            auto &bucket = getMergedNodes(static_cast<PixelType>(tree.getAltitude(nodeId)));
-            bucket.push_back(nodeId);
-            maxBucketSize_ = std::max(maxBucketSize_, bucket.size());
+            mergeNodesByLevelStorage_.push(static_cast<PixelType>(tree.getAltitude(nodeId)), nodeId);
             collectedNodeMarks_.mark(nodeId);
             mergeBucketNodeMarks_.mark(nodeId);
         }
@@ -317,33 +305,26 @@ public:
 
         /**
          * @brief Builds the ordered list of active levels and returns the first one.
-         * @details Because the current implementation uses dense altitude-indexed
-         * buckets, the collection scans the full discrete domain and keeps only
-         * the levels that remained non-empty in the current step.
+         * @details Only the levels that received a bucket in the current step
+         * are visited, so the cost does not depend on the size of the
+         * gray-level domain.
          */
         PixelType firstMergeLevel() {
-            mergeLevels_.clear();
-            // The altitude domain is discrete and dense in this backend, so the
-            // scan visits all levels and keeps only the non-empty ones.
-            for (std::size_t i = 0; i < mergeNodesByLevelStorage_.size(); ++i) {
-                if (!mergeNodesByLevelStorage_[i].empty()) {
-                    mergeLevels_.push_back(static_cast<PixelType>(i));
-                }
-            }
-
-            if (mergeLevels_.empty()) {
+            mergeNodesByLevelStorage_.seal();
+            numMergeLevels_ = static_cast<int>(mergeNodesByLevelStorage_.levels().size());
+            if (numMergeLevels_ == 0) {
                 return PixelType{};
             }
 
-            currentMergeLevelIndex_ = isMaxtree_ ? (int) mergeLevels_.size() - 1 : 0;
-            return mergeLevels_[currentMergeLevelIndex_];
+            currentMergeLevelIndex_ = isMaxtree_ ? numMergeLevels_ - 1 : 0;
+            return mergeNodesByLevelStorage_.levels()[currentMergeLevelIndex_];
         }
 
         /**
          * @brief Returns `true` while the level iterator remains valid.
          */
         bool hasMergeLevel() const {
-            return !mergeLevels_.empty() && currentMergeLevelIndex_ >= 0 && currentMergeLevelIndex_ < (int) mergeLevels_.size();
+            return currentMergeLevelIndex_ >= 0 && currentMergeLevelIndex_ < numMergeLevels_;
         }
 
         /**
@@ -354,7 +335,7 @@ public:
             if (!hasMergeLevel()) {
                 return PixelType{};
             }
-            return mergeLevels_[currentMergeLevelIndex_];
+            return mergeNodesByLevelStorage_.levels()[currentMergeLevelIndex_];
         }
     };
 
@@ -373,7 +354,7 @@ private:
     // Dynamic primal/dual trees and shared adjacency of the domain.
     DynamicComponentTree *mintree_ = nullptr;
     DynamicComponentTree *maxtree_ = nullptr;
-    AdjacencyRelation *graph_ = nullptr;
+    const AdjacencyRelation *graph_ = nullptr;
 
     // Incremental computers and external buffers used after local edits.
     DynamicAttributeComputer *attrComputerMin_ = nullptr;
@@ -1137,7 +1118,7 @@ public:
      * @param maxtree Pointer to the dynamic max-tree owned externally.
      * @param graph Adjacency relation shared by both trees.
      */
-    DualMinMaxTreeIncrementalFilterInstrumented(DynamicComponentTree *mintree, DynamicComponentTree *maxtree, AdjacencyRelation &graph)
+    DualMinMaxTreeIncrementalFilterInstrumented(DynamicComponentTree *mintree, DynamicComponentTree *maxtree, const AdjacencyRelation &graph)
         : mintree_(mintree), maxtree_(maxtree), graph_(&graph),
           mergeNodesByLevel_(std::max(mintree ? mintree->getNumInternalNodeSlots() : 0, maxtree ? maxtree->getNumInternalNodeSlots() : 0)),
           removedMarks_(std::max(mintree ? mintree->getNumInternalNodeSlots() : 0, maxtree ? maxtree->getNumInternalNodeSlots() : 0)),
@@ -1209,9 +1190,9 @@ public:
     /**
      * @brief Returns the merge bucket associated with an altitude value.
      * @param level Queried level.
-     * @return Mutable reference to the bucket for that level.
+     * @return Read-only view of the nodes collected at that level.
      */
-    std::vector<NodeId> &getMergedNodes(const PixelType &level) {
+    std::span<const NodeId> getMergedNodes(const PixelType &level) {
         return mergeNodesByLevel_.getMergedNodes(level);
     }
 
@@ -1257,7 +1238,7 @@ public:
         // Phase 2: for each pixel of C, locate valid adjacent seeds and climb
         // each relevant ancestral path only once.
         for (PixelId p : properPartSetC) {
-            for (PixelId q : graph_->getNeighborPixels(p)) {
+            for (PixelId q : graph_->getNeighborRange(p)) {
                 if (pixelsInCMarks_.isMarked(static_cast<std::size_t>(q))) {
                     continue; // Neighbors internal to C do not generate adjacent seeds.
                 }
@@ -1409,7 +1390,7 @@ public:
             outputLog_ << "F_λ = { ";
             int lambda = (int) b;
             while (lambda != altitudeCa) {
-                auto &mergeNodesAtLevel = mergeNodesByLevel_.getMergedNodes(lambda);
+                const auto mergeNodesAtLevel = mergeNodesByLevel_.getMergedNodes(lambda);
                 if (!mergeNodesAtLevel.empty()) {
                     outputLog_ << lambda << ":[ ";
                     for (auto node : mergeNodesAtLevel) {
@@ -1443,7 +1424,7 @@ public:
             if (metrics_) {
                 ++loopIterations;
             }
-            auto &nodesAtCurrentLevel = mergeNodesByLevel_.getMergedNodes((int) currentMergeLevel);
+            const auto nodesAtCurrentLevel = mergeNodesByLevel_.getMergedNodes((int) currentMergeLevel);
             currentUnionNode = InvalidNode;
             nodesPendingRemoval_.clear();
 
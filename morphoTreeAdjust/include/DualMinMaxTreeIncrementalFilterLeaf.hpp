@@ -88,17 +88,13 @@ class DualMinMaxTreeIncrementalFilterLeaf {
 public:
     class MergedNodesCollection {
     private:
-        static_assert(std::numeric_limits<PixelType>::is_integer, "MergedNodesCollection requires integral PixelType");
-        static_assert(std::numeric_limits<PixelType>::lowest() == 0, "MergedNodesCollection expects non-negative contiguous levels");
-        static constexpr std::size_t NumLevels = static_cast<std::size_t>(std::numeric_limits<PixelType>::max()) + 1;
-
-        std::array<std::vector<NodeId>, NumLevels> mergeNodesByLevelStorage_;
-        std::vector<PixelType> mergeLevels_;
+        LevelBuckets<PixelType> mergeNodesByLevelStorage_;
         std::vector<NodeId> adjacentNodes_;
         std::vector<NodeId> frontierNodesAboveB_;
         GenerationStampSet visited_;
         GenerationStampSet visitedAdj_;
         int currentMergeLevelIndex_ = 0;
+        int numMergeLevels_ = 0;
         bool isMaxtree_ = false;
 
     public:
@@ -108,19 +104,17 @@ public:
 
         void resetCollection(bool isMaxtree) {
             isMaxtree_ = isMaxtree;
-            for (auto level : mergeLevels_) {
-                mergeNodesByLevelStorage_[static_cast<std::size_t>(level)].clear();
-            }
-            mergeLevels_.clear();
+            mergeNodesByLevelStorage_.clear();
             adjacentNodes_.clear();
             frontierNodesAboveB_.clear();
             visited_.resetAll();
             visitedAdj_.resetAll();
             currentMergeLevelIndex_ = 0;
+            numMergeLevels_ = 0;
         }
 
-        std::vector<NodeId> &getMergedNodes(const PixelType &level) {
-            return mergeNodesByLevelStorage_[static_cast<std::size_t>(level)];
+        std::span<const NodeId> getMergedNodes(const PixelType &level) {
+            return mergeNodesByLevelStorage_.nodesAt(level);
         }
 
         std::vector<NodeId> &getAdjacentNodes() {
@@ -146,8 +140,7 @@ public:
             NodeId nodeId = adjacentNode;
             while (nodeId != InvalidNode) {
                 if (!visited_.isMarked(nodeId)) {
-                    auto &bucket = getMergedNodes(static_cast<PixelType>(tree.getAltitude(nodeId)));
-                    bucket.push_back(nodeId);
+                    mergeNodesByLevelStorage_.push(static_cast<PixelType>(tree.getAltitude(nodeId)), nodeId);
                     visited_.mark(nodeId);
                 } else {
                     break;
@@ -167,8 +160,7 @@ public:
                 return;
             }
 
-            auto &bucket = getMergedNodes(static_cast<PixelType>(tree.getAltitude(nodeId)));
-            bucket.push_back(nodeId);
+            mergeNodesByLevelStorage_.push(static_cast<PixelType>(tree.getAltitude(nodeId)), nodeId);
             visited_.mark(nodeId);
         }
 
@@ -183,23 +175,18 @@ public:
         }
 
         PixelType firstMergeLevel() {
-            mergeLevels_.clear();
-            for (std::size_t i = 0; i < mergeNodesByLevelStorage_.size(); ++i) {
-                if (!mergeNodesByLevelStorage_[i].empty()) {
-                    mergeLevels_.push_back(static_cast<PixelType>(i));
-                }
-            }
-
-            if (mergeLevels_.empty()) {
+            mergeNodesByLevelStorage_.seal();
+            numMergeLevels_ = static_cast<int>(mergeNodesByLevelStorage_.levels().size());
+            if (numMergeLevels_ == 0) {
                 return PixelType{};
             }
 
-            currentMergeLevelIndex_ = isMaxtree_ ? static_cast<int>(mergeLevels_.size()) - 1 : 0;
-            return mergeLevels_[currentMergeLevelIndex_];
+            currentMergeLevelIndex_ = isMaxtree_ ? numMergeLevels_ - 1 : 0;
+            return mergeNodesByLevelStorage_.levels()[currentMergeLevelIndex_];
         }
 
         bool hasMergeLevel() const {
-            return !mergeLevels_.empty() && currentMergeLevelIndex_ >= 0 && currentMergeLevelIndex_ < static_cast<int>(mergeLevels_.size());
+            return currentMergeLevelIndex_ >= 0 && currentMergeLevelIndex_ < numMergeLevels_;
         }
 
         PixelType nextMergeLevel() {
@@ -207,14 +194,14 @@ public:
             if (!hasMergeLevel()) {
                 return PixelType{};
             }
-            return mergeLevels_[currentMergeLevelIndex_];
+            return mergeNodesByLevelStorage_.levels()[currentMergeLevelIndex_];
         }
     };
 
 private:
     DynamicComponentTree *mintree_ = nullptr;
     DynamicComponentTree *maxtree_ = nullptr;
-    AdjacencyRelation *graph_ = nullptr;
+    const AdjacencyRelation *graph_ = nullptr;
     DynamicAttributeComputer *attrComputerMin_ = nullptr;
     DynamicAttributeComputer *attrComputerMax_ = nullptr;
     std::span<float> bufferMin_;
@@ -498,7 +485,7 @@ public:
      * The public `prune*AndUpdate*` methods act on this same pair and do not
      * rebind trees per call.
      */
-    DualMinMaxTreeIncrementalFilterLeaf(DynamicComponentTree *mintree, DynamicComponentTree *maxtree, AdjacencyRelation &graph)
+    DualMinMaxTreeIncrementalFilterLeaf(DynamicComponentTree *mintree, DynamicComponentTree *maxtree, const AdjacencyRelation &graph)
         : mintree_(mintree), maxtree_(maxtree), graph_(&graph),
           mergeNodesByLevel_(std::max(mintree ? mintree->getNumInternalNodeSlots() : 0, maxtree ? maxtree->getNumInternalNodeSlots() : 0)),
           removedMarks_(std::max(mintree ? mintree->getNumInternalNodeSlots() : 0, maxtree ? maxtree->getNumInternalNodeSlots() : 0)),
@@ -540,7 +527,7 @@ public:
     }
 
     /** @brief Exposes the merge bucket associated with a level. */
-    std::vector<NodeId> &getMergedNodes(const PixelType &level) {
+    std::span<const NodeId> getMergedNodes(const PixelType &level) {
         return mergeNodesByLevel_.getMergedNodes(level);
     }
 
@@ -576,58 +563,61 @@ public:
             pixelsInLeafMarks_.mark(static_cast<size_t>(pixelId));
         }
 
-        for (PixelId p : primalTree->getProperParts(leafId)) {
-            for (PixelId q : graph_->getNeighborPixels(p)) {
-                if (pixelsInLeafMarks_.isMarked(static_cast<size_t>(q))) {
-                    continue;
-                }
-
-                const NodeId nodeQ = dualTree->getSmallestComponent(q);
-                if (nodeQ == InvalidNode) {
-                    continue;
-                }
-
-                const PixelType altitudeQ = static_cast<PixelType>(dualTree->getAltitude(nodeQ));
-                const bool validSeed = (isMaxtree && altitudeQ >= altitudeCa) ||
-                                       (!isMaxtree && altitudeQ <= altitudeCa);
-                if (!validSeed || !mergeNodesByLevel_.markAdjacentSeed(nodeQ)) {
-                    continue;
-                }
+        graph_->withStencil([&](auto stencil) {
+            using Stencil = decltype(stencil);
+            for (PixelId p : primalTree->getProperParts(leafId)) {
+                Stencil::forEachNeighbor(*graph_, p, [&](PixelId q) {
+                    if (pixelsInLeafMarks_.isMarked(static_cast<size_t>(q))) {
+                        return;
+                    }
 
-                NodeId nodeSubtree = nodeQ;
-                NodeId n = nodeQ;
-                while (n != InvalidNode && dualTree->isAlive(n) && !climbedNodeMarks_.isMarked(static_cast<size_t>(n))) {
-                    const PixelType levelCurrent = static_cast<PixelType>(dualTree->getAltitude(n));
-                    if (!((isMaxtree && levelCurrent >= altitudeCa) ||
-                          (!isMaxtree && levelCurrent <= altitudeCa))) {
-                        break;
+                    const NodeId nodeQ = dualTree->getSmallestComponent(q);
+                    if (nodeQ == InvalidNode) {
+                        return;
                     }
 
-                    climbedNodeMarks_.mark(static_cast<size_t>(n));
-                    nodeSubtree = n;
+                    const PixelType altitudeQ = static_cast<PixelType>(dualTree->getAltitude(nodeQ));
+                    const bool validSeed = (isMaxtree && altitudeQ >= altitudeCa) ||
+                                           (!isMaxtree && altitudeQ <= altitudeCa);
+                    if (!validSeed || !mergeNodesByLevel_.markAdjacentSeed(nodeQ)) {
+                        return;
+                    }
 
-                    if ((isMaxtree && levelCurrent <= b) || (!isMaxtree && levelCurrent >= b)) {
-                        mergeNodesByLevel_.addMergeNode(*dualTree, nodeSubtree);
-                    } else {
-                        NodeId parentId = dualTree->getNodeParent(nodeSubtree);
-                        if (parentId == nodeSubtree) {
-                            parentId = InvalidNode;
+                    NodeId nodeSubtree = nodeQ;
+                    NodeId n = nodeQ;
+                    while (n != InvalidNode && dualTree->isAlive(n) && !climbedNodeMarks_.isMarked(static_cast<size_t>(n))) {
+                        const PixelType levelCurrent = static_cast<PixelType>(dualTree->getAltitude(n));
+                        if (!((isMaxtree && levelCurrent >= altitudeCa) ||
+                              (!isMaxtree && levelCurrent <= altitudeCa))) {
+                            break;
                         }
-                        if (!(parentId != InvalidNode &&
-                              ((isMaxtree && dualTree->getAltitude(parentId) > b) ||
-                               (!isMaxtree && dualTree->getAltitude(parentId) < b)))) {
-                            mergeNodesByLevel_.addFrontierNodeAboveB(nodeSubtree);
+
+                        climbedNodeMarks_.mark(static_cast<size_t>(n));
+                        nodeSubtree = n;
+
+                        if ((isMaxtree && levelCurrent <= b) || (!isMaxtree && levelCurrent >= b)) {
+                            mergeNodesByLevel_.addMergeNode(*dualTree, nodeSubtree);
+                        } else {
+                            NodeId parentId = dualTree->getNodeParent(nodeSubtree);
+                            if (parentId == nodeSubtree) {
+                                parentId = InvalidNode;
+                            }
+                            if (!(parentId != InvalidNode &&
+                                  ((isMaxtree && dualTree->getAltitude(parentId) > b) ||
+                                   (!isMaxtree && dualTree->getAltitude(parentId) < b)))) {
+                                mergeNodesByLevel_.addFrontierNodeAboveB(nodeSubtree);
+                            }
                         }
-                    }
 
-                    const NodeId parentId = dualTree->getNodeParent(n);
-                    if (parentId == n) {
-                        break;
+                        const NodeId parentId = dualTree->getNodeParent(n);
+                        if (parentId == n) {
+                            break;
+                        }
+                        n = parentId;
                     }
-                    n = parentId;
-                }
+                });
             }
-        }
+        });
     }
 
     /**
@@ -711,7 +701,7 @@ public:
         bool nodeCaRemoved = false;
 
         while (mergeNodesByLevel_.hasMergeLevel() && ((isMaxtree && mergeLevel > altitudeCa) || (!isMaxtree && mergeLevel < altitudeCa))) {
-            auto &mergeNodesAtLevel = mergeNodesByLevel_.getMergedNodes(static_cast<PixelType>(mergeLevel));
+            const auto mergeNodesAtLevel = mergeNodesByLevel_.getMergedNodes(static_cast<PixelType>(mergeLevel));
             unionNode = InvalidNode;
 
             for (auto nodeId : mergeNodesAtLevel) {
@@ -1,9 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "AdjacencyRelation.hpp"
@@ -21,41 +35,59 @@
  *
  * - image pixels are indexed by `PixelId`;
  * - hierarchy nodes are indexed by `NodeId`, in a dense id space from `0` to
- *   `nodeParent_.size() - 1`;
+ *   `nodes_.size() - 1`;
  * - each live node represents a connected component at one level;
  * - each pixel belongs directly to exactly one live node;
  * - the full support of a node is given by its subtree.
  *
  * Hierarchy encoding:
  *
- * - the parent relation is encoded by `nodeParent_`, which stores the direct
- *   parent of each node and therefore defines the node id space;
+ * - the hot per-node fields live in one `NodeRecord` per slot of `nodes_`,
+ *   which therefore defines the node id space;
+ * - the parent relation is encoded by `NodeRecord::parent`, the direct parent
+ *   of each node;
  * - the child relation is encoded by the doubly linked child backend
- *   `firstChild_`, `lastChild_`, `nextSibling_`, and `prevSibling_`; each of
- *   these arrays has size `nodeParent_.size()`;
+ *   `firstChild`, `lastChild`, `nextSibling`, and `prevSibling`, with the
+ *   child count in `numChildren`;
  * - the node-to-pixel relation for direct proper parts is encoded by
- *   `properHead_`, `properTail_`, `nextProperPart_`, and `prevProperPart_`;
- *   `properHead_` and `properTail_` are node-indexed and have size
- *   `nodeParent_.size()`, while `nextProperPart_` and `prevProperPart_` are
- *   pixel-indexed and have size `properPartOwner_.size()`;
- * - the pixel-to-node relation is encoded by `properPartOwner_`, which stores
- *   the current direct owner of each pixel and has size
+ *   `NodeRecord::properHead`, `properTail_`, `nextProperPart_`, and
+ *   `prevProperPart_`; `properTail_` and `numProperPartsByNode_` are
+ *   node-indexed and have size `nodes_.size()`, while `nextProperPart_` and
+ *   `prevProperPart_` are pixel-indexed and have size
  *   `properPartOwner_.size()`;
- * - `altitude_` stores the canonical level associated with each node and has
- *   size `nodeParent_.size()`;
+ * - the pixel-to-node relation is encoded by `properPartOwner_`, which stores
+ *   the current direct owner of each pixel;
+ * - `NodeRecord::altitude` stores the canonical level associated with each
+ *   node;
  * - `freeNodeIds_` stores released node slots that may later be reused; its
- *   current size is dynamic and never exceeds `nodeParent_.size()`.
-
+ *   current size is dynamic and never exceeds `nodes_.size()`.
+ *
+ * Index width:
+ *
+ * Stored ids and counts use the signed integer `Index`, so the layout is
+ * chosen per instantiation: `DynamicComponentTree` uses 32-bit indices, and
+ * `BasicDynamicComponentTree<int16_t>` halves every column for images of at
+ * most 32767 pixels, such as tiles. The public interface keeps `NodeId`,
+ * `PixelId`, and `int` whatever the width.
+ *
+ * Bytes-per-pixel target: a tree never has more node slots than pixels, so
+ * its columns stay within `14 * sizeof(Index)` bytes per pixel, that is 56
+ * bytes with 32-bit and 28 bytes with 16-bit indices: 3 indices per pixel
+ * (owner and the two proper-part links) plus, per node slot, the 8-index
+ * record, the proper-part tail and count, and one free-pool entry. Chunk
+ * rounding adds at most one chunk per column, and the optional change log,
+ * undo journal, and lazy-ownership tables are extra.
  *
  * Fundamental invariants:
  *
  * - the `rootNodeId_` root is a live node and points to itself as parent;
  * - every live node other than the root has a live parent;
  * - every pixel in the domain has a single direct owner;
- * - the direct pixels of a node are uniform at level `altitude_[nodeId]`;
+ * - the direct pixels of a node are uniform at level `nodes_[nodeId].altitude`;
  * - concatenating the proper parts of a node subtree reconstructs its full
  *   support;
- * - the id of a live node never changes during its lifetime;
+ * - the id of a live node never changes during its lifetime, except through
+ *   an explicit `compact`;
  * - released nodes leave the topology and their slots can only reappear
  *   through reuse via `allocateNode`.
  *
@@ -83,7 +115,7 @@
  *
  * Main costs:
  *
- * - space: `Theta(P + N)`;
+ * - space: `Theta(P + N)`; see `getMemoryUsage` for the bytes per column;
  * - local topology and metadata queries (`getParent`, `getAltitude`,
  *   `isLeaf`, `isAlive`, `getProperPartOwner`): `O(1)`;
  * - direct-child iteration: linear in the number of children;
@@ -118,64 +150,457 @@
  * The tradeoff is extra `Theta(P + N)` storage to maintain these parallel
  * backends, but the benefit is that the adjusters can operate on the affected
  * region instead of paying for a global rebuild after each pruning step.
+ *
+ * The backend columns are `ChunkedColumn`s: copying a tree shares their
+ * chunks copy-on-write, so a copy costs `O((N + P) / ChunkSize)` and each
+ * copy later pays only for the chunks it writes to. Reads go through one
+ * more indirection than a flat array would need.
  */
-class DynamicComponentTree {
+template<typename Index>
+class BasicDynamicComponentTree {
+    static_assert(std::is_integral_v<Index> && std::is_signed_v<Index> && sizeof(Index) >= 2 && sizeof(Index) <= sizeof(NodeId),
+                  "BasicDynamicComponentTree stores ids and counts in a signed integer of 16 bits up to the width of NodeId");
+
+public:
+    /**
+     * @brief Storage type of node altitudes.
+     * @details Builds accept pixels of at most 16 bits, so altitudes are kept
+     * at that width instead of the `Index` used by the id columns.
+     */
+    using NodeAltitude = uint16_t;
+
+    /**
+     * @brief Storage type of the stored node ids, pixel ids, and counts.
+     * @details The public interface keeps using `NodeId`, `PixelId`, and
+     * `int`; only the stored values are narrowed, so an image may have at
+     * most `MaxNumPixels` pixels.
+     */
+    using IndexType = Index;
+    static constexpr int64_t MaxNumPixels = std::numeric_limits<Index>::max();
+
+    /**
+     * @brief Hot per-node fields, packed into one record.
+     * @details The parent, the child links, the child count, the head of the
+     * proper-part list and the altitude are what traversals and merges read
+     * together, so they share one record of `8 * sizeof(Index)` bytes,
+     * aligned to its size: two records per 64-byte cache line with 32-bit
+     * indices, four with 16-bit indices, and a record never straddles a
+     * line. The tail and the count of the proper-part list, touched only
+     * when pixels move, stay in separate columns.
+     */
+    struct alignas(8 * sizeof(Index)) NodeRecord {
+        Index parent;
+        Index firstChild;
+        Index lastChild;
+        Index nextSibling;
+        Index prevSibling;
+        Index numChildren;
+        Index properHead;
+        NodeAltitude altitude;
+    };
+    static_assert(sizeof(NodeRecord) == 8 * sizeof(Index));
+
+    /**
+     * @brief Pixel-indexed scratch buffers used by the construction.
+     *
+     * The buffers are only meaningful during a build. Passing the same
+     * workspace to consecutive builds (or to the two trees of a pair build)
+     * lets them share the allocation instead of creating fresh vectors; once
+     * the workspace and the tree storage have reached the size of the images
+     * being processed, the sequential rebuild path does no heap allocation.
+     */
+    struct BuildWorkspace {
+        std::vector<PixelId> orderedPixels;
+        std::vector<PixelId> radixScratch;
+        std::vector<int> zPar;
+        std::vector<int> parent;
+        std::vector<NodeId> pixelToNodeId;
+    };
+
 private:
     // Permanent metadata of the base image and the adjacency used in construction.
     AdjacencyRelationPtr adj_;
     int numRows_ = 0;
     int numCols_ = 0;
     bool isMaxtree_ = true;
+    int imageBitDepth_ = 8;
 
     // Current root and live-node cache.
     NodeId rootNodeId_ = InvalidNode;
     int numNodes_ = 0;
 
-    // Main hierarchy structure indexed only by nodes.
-    std::vector<int> altitude_; //This is unique attribute of the node, so it is stored in a separate vector for better cache performance.
-    std::vector<NodeId> freeNodeIds_;
-    std::vector<NodeId> nodeParent_;
-    
-    // Backend for the doubly linked child lists.
-    std::vector<NodeId> firstChild_;
-    std::vector<NodeId> lastChild_;
-    std::vector<NodeId> nextSibling_;
-    std::vector<NodeId> prevSibling_;
-    std::vector<int> numChildrenByNode_;
-
-    // Backend for the doubly linked lists of direct proper parts.
-    std::vector<PixelId> properHead_;
-    std::vector<PixelId> properTail_;
-    std::vector<int> numProperPartsByNode_;
-    std::vector<NodeId> properPartOwner_;
-    std::vector<PixelId> nextProperPart_;
-    std::vector<PixelId> prevProperPart_;
+    // Main hierarchy structure indexed only by nodes: parent, child lists,
+    // altitude, and the head of the proper-part list.
+    ChunkedColumn<NodeRecord> nodes_;
+    std::vector<Index> freeNodeIds_;
+
+    // Rest of the backend for the doubly linked lists of direct proper parts.
+    ChunkedColumn<Index> properTail_;
+    ChunkedColumn<Index> numProperPartsByNode_;
+    ChunkedColumn<Index> properPartOwner_;
+    ChunkedColumn<Index> nextProperPart_;
+    ChunkedColumn<Index> prevProperPart_;
 
     // Mutation counters used in internal checks and tests.
     std::size_t nodeStructureVersion_ = 0;
     std::size_t topologyVersion_ = 0;
     std::size_t properPartVersion_ = 0;
 
+    // Opt-in log of pixels whose owner altitude changed since the last
+    // incremental reconstruction.
+    bool trackPixelChanges_ = false;
+    bool allPixelsChanged_ = true;
+    std::vector<PixelId> changedPixels_;
+    GenerationStampSet changedPixelMarks_;
+
+    void recordChangedPixel(PixelId pixelId) {
+        if (!allPixelsChanged_ && !changedPixelMarks_.isMarked((size_t) pixelId)) {
+            changedPixelMarks_.mark((size_t) pixelId);
+            changedPixels_.push_back(pixelId);
+        }
+    }
+
+    // Undo journal of the backend writes made since the last checkpoint. Each
+    // entry restores one column cell, one node-record field, or one of the
+    // scalar/free-list edits tagged by `JournalOp`.
+    enum class JournalOp : uint8_t {
+        Cell,
+        NodeField,
+        Altitude,
+        Root,
+        NumNodes,
+        PushFreeNode,
+        PopFreeNode,
+    };
+    struct JournalEntry {
+        ChunkedColumn<Index> BasicDynamicComponentTree::*column;
+        Index NodeRecord::*field;
+        int index;
+        int oldValue;
+        JournalOp op;
+    };
+    bool journaling_ = false;
+    std::vector<JournalEntry> journal_;
+    // Size of the ownership-block forest when the checkpoint was set; blocks
+    // appended after it are dropped by a rollback.
+    std::size_t checkpointNumOwnerBlocks_ = 0;
+
+    // Optional lazy ownership. In this mode `properPartOwner_` stores an
+    // ownership block per pixel; blocks form a union-find forest whose roots
+    // map to nodes, so moving all proper parts of a node is a union instead
+    // of a rewrite of every moved pixel. Every node slot points at a root
+    // block that maps back to it.
+    bool lazyOwnership_ = false;
+    ChunkedColumn<Index> ownerBlockParent_;
+    ChunkedColumn<Index> ownerBlockRank_;
+    ChunkedColumn<Index> ownerBlockNode_;
+    ChunkedColumn<Index> nodeOwnerBlock_;
+
+    /**
+     * @brief Root of the block forest above `blockId`.
+     * @details No path compression: const queries may run concurrently on a
+     * shared tree, and union by rank already bounds the depth by the
+     * logarithm of the number of blocks.
+     */
+    int findOwnerBlock(int blockId) const {
+        while (ownerBlockParent_[blockId] != blockId) {
+            blockId = ownerBlockParent_[blockId];
+        }
+        return blockId;
+    }
+
+    /**
+     * @brief Root of the block forest above `blockId`, halving the path it walks.
+     * @details Skipped while a checkpoint is active: the shortcuts are not
+     * journaled, and a rollback that undoes a union would leave them pointing
+     * at a block that is no longer an ancestor.
+     */
+    int compressOwnerBlockPath(int blockId) {
+        if (journaling_) {
+            return findOwnerBlock(blockId);
+        }
+        while (ownerBlockParent_[blockId] != blockId) {
+            const int grandparentBlock = ownerBlockParent_[ownerBlockParent_[blockId]];
+            ownerBlockParent_.set(blockId, grandparentBlock);
+            blockId = grandparentBlock;
+        }
+        return blockId;
+    }
+
+    /**
+     * @brief Resets the block forest to one block per node slot, with block id equal to node id.
+     * @details Valid whenever `properPartOwner_` holds node ids.
+     */
+    void resetOwnerBlocks() {
+        const std::size_t numSlots = nodes_.size();
+        ownerBlockParent_.resize(numSlots);
+        ownerBlockRank_.assign(numSlots, 0);
+        ownerBlockNode_.resize(numSlots);
+        nodeOwnerBlock_.resize(numSlots);
+        for (std::size_t id = 0; id < numSlots; ++id) {
+            ownerBlockParent_.set(id, (int) id);
+            ownerBlockNode_.set(id, (NodeId) id);
+            nodeOwnerBlock_.set(id, (int) id);
+        }
+    }
+
+    /**
+     * @brief Rewrites every pixel owner as a node id and resets the block forest.
+     */
+    void flattenOwnerBlocks() {
+        for (std::size_t pixelId = 0; pixelId < properPartOwner_.size(); ++pixelId) {
+            const int ownerBlock = properPartOwner_[pixelId];
+            if (ownerBlock != InvalidNode) {
+                properPartOwner_.set(pixelId, ownerBlockNode_[findOwnerBlock(ownerBlock)]);
+            }
+        }
+        resetOwnerBlocks();
+    }
+
+    /**
+     * @brief Lazy counterpart of relabeling every proper part of `sourceNodeId` as owned by `targetNodeId`.
+     * @details Called before the lists are spliced, while both counts still
+     * describe the nodes before the move. The source ends with a root block
+     * that owns no pixel, ready for later single-pixel moves. The block forest
+     * is flattened once it holds more blocks than node slots and pixels
+     * together, which keeps its size linear and its cost amortized `O(1)` per
+     * move; flattening is deferred while a checkpoint is active.
+     */
+    void linkOwnerBlocks(NodeId targetNodeId, NodeId sourceNodeId) {
+        if (!journaling_ && ownerBlockParent_.size() > nodes_.size() + properPartOwner_.size()) {
+            flattenOwnerBlocks();
+        }
+        const int targetBlock = nodeOwnerBlock_[targetNodeId];
+        const int sourceBlock = nodeOwnerBlock_[sourceNodeId];
+        if (numProperPartsByNode_[targetNodeId] == 0) {
+            // No pixel resolves to the target block, so the nodes swap blocks.
+            writeCell(&BasicDynamicComponentTree::nodeOwnerBlock_, targetNodeId, sourceBlock);
+            writeCell(&BasicDynamicComponentTree::ownerBlockNode_, sourceBlock, targetNodeId);
+            writeCell(&BasicDynamicComponentTree::nodeOwnerBlock_, sourceNodeId, targetBlock);
+            writeCell(&BasicDynamicComponentTree::ownerBlockNode_, targetBlock, sourceNodeId);
+            return;
+        }
+
+        int rootBlock = targetBlock;
+        if (ownerBlockRank_[sourceBlock] > ownerBlockRank_[targetBlock]) {
+            writeCell(&BasicDynamicComponentTree::ownerBlockParent_, targetBlock, sourceBlock);
+            rootBlock = sourceBlock;
+        } else {
+            writeCell(&BasicDynamicComponentTree::ownerBlockParent_, sourceBlock, targetBlock);
+            if (ownerBlockRank_[sourceBlock] == ownerBlockRank_[targetBlock]) {
+                writeCell(&BasicDynamicComponentTree::ownerBlockRank_, targetBlock, ownerBlockRank_[targetBlock] + 1);
+            }
+        }
+        writeCell(&BasicDynamicComponentTree::nodeOwnerBlock_, targetNodeId, rootBlock);
+        writeCell(&BasicDynamicComponentTree::ownerBlockNode_, rootBlock, targetNodeId);
+
+        // A block appended while journaling is only referenced through
+        // journaled cells, so a rollback can truncate it away.
+        const int freshBlock = (int) ownerBlockParent_.size();
+        ownerBlockParent_.push_back(freshBlock);
+        ownerBlockRank_.push_back(0);
+        ownerBlockNode_.push_back(sourceNodeId);
+        writeCell(&BasicDynamicComponentTree::nodeOwnerBlock_, sourceNodeId, freshBlock);
+    }
+
+    static constexpr char SnapshotMagic[9] = "MTATREE1";
+    static constexpr uint32_t SnapshotVersion = 1;
+
+    /**
+     * @brief Checks the columns of a tree read from a snapshot before it is used.
+     * @details Every stored id must lie in its id space or be `InvalidNode`,
+     * every pixel must be owned by a live node, the free-id pool must list
+     * each released slot exactly once, and the child and proper-part lists
+     * must agree with the parent and owner columns and form one tree
+     * reachable from the root whose proper-part lists hold every pixel
+     * exactly once. A file that passes cannot make later traversals read out
+     * of bounds or loop forever.
+     */
+    void requireConsistentSnapshotColumns() const {
+        const auto fail = [](const char *problem) {
+            throw std::runtime_error(std::string("DynamicComponentTree snapshot has ") + problem + ".");
+        };
+        const int numSlots = (int) nodes_.size();
+        const int numPixels = (int) properPartOwner_.size();
+        const auto isNodeIdOrNone = [&](NodeId nodeId) { return nodeId == InvalidNode || (nodeId >= 0 && nodeId < numSlots); };
+        const auto isPixelIdOrNone = [&](PixelId pixelId) { return pixelId == InvalidNode || (pixelId >= 0 && pixelId < numPixels); };
+        const int maxAltitude = (1 << imageBitDepth_) - 1;
+
+        int numLiveSlots = 0;
+        for (NodeId nodeId = 0; nodeId < numSlots; ++nodeId) {
+            if (!isNodeIdOrNone(nodes_[nodeId].parent) || !isNodeIdOrNone(nodes_[nodeId].firstChild) || !isNodeIdOrNone(nodes_[nodeId].lastChild) ||
+                !isNodeIdOrNone(nodes_[nodeId].nextSibling) || !isNodeIdOrNone(nodes_[nodeId].prevSibling) ||
+                !isPixelIdOrNone(nodes_[nodeId].properHead) || !isPixelIdOrNone(properTail_[nodeId])) {
+                fail("a node link out of range");
+            }
+            if (nodes_[nodeId].parent == InvalidNode) {
+                continue;
+            }
+            ++numLiveSlots;
+            if (!isAlive(nodes_[nodeId].parent) || nodes_[nodeId].altitude > maxAltitude) {
+                fail("an invalid live node");
+            }
+        }
+        for (PixelId pixelId = 0; pixelId < numPixels; ++pixelId) {
+            if (!isNodeIdOrNone(properPartOwner_[pixelId]) || !isPixelIdOrNone(nextProperPart_[pixelId]) || !isPixelIdOrNone(prevProperPart_[pixelId])) {
+                fail("a pixel link out of range");
+            }
+            if (properPartOwner_[pixelId] == InvalidNode || !isAlive(properPartOwner_[pixelId])) {
+                fail("a pixel without a live owner");
+            }
+        }
+        if (numLiveSlots != numNodes_ || (numNodes_ > 0) != (rootNodeId_ != InvalidNode) ||
+            (rootNodeId_ != InvalidNode && nodes_[rootNodeId_].parent != rootNodeId_)) {
+            fail("an inconsistent root or node count");
+        }
+
+        if ((int) freeNodeIds_.size() != numSlots - numNodes_) {
+            fail("an invalid free-id pool");
+        }
+        std::vector<uint8_t> seen((std::size_t) numSlots, 0);
+        for (NodeId nodeId : freeNodeIds_) {
+            if (nodeId < 0 || nodeId >= numSlots || nodes_[nodeId].parent != InvalidNode || seen[nodeId]) {
+                fail("an invalid free-id pool");
+            }
+            seen[nodeId] = 1;
+        }
+
+        // Walk the tree from the root; each list is bounded by its stored
+        // count, so a cycle is detected instead of followed.
+        std::fill(seen.begin(), seen.end(), 0);
+        std::vector<NodeId> order;
+        int64_t numListedPixels = 0;
+        if (rootNodeId_ != InvalidNode) {
+            order.push_back(rootNodeId_);
+            seen[rootNodeId_] = 1;
+        }
+        for (std::size_t head = 0; head < order.size(); ++head) {
+            const NodeId nodeId = order[head];
+            if (nodes_[nodeId].numChildren < 0 || nodes_[nodeId].numChildren > numSlots ||
+                numProperPartsByNode_[nodeId] < 0 || numProperPartsByNode_[nodeId] > numPixels) {
+                fail("an invalid child or proper-part count");
+            }
+            int numChildren = 0;
+            NodeId previousId = InvalidNode;
+            for (NodeId childId = nodes_[nodeId].firstChild; childId != InvalidNode; childId = nodes_[childId].nextSibling) {
+                if (++numChildren > nodes_[nodeId].numChildren || seen[childId] || nodes_[childId].parent != nodeId || nodes_[childId].prevSibling != previousId) {
+                    fail("an inconsistent child list");
+                }
+                seen[childId] = 1;
+                order.push_back(childId);
+                previousId = childId;
+            }
+            if (numChildren != nodes_[nodeId].numChildren || nodes_[nodeId].lastChild != previousId) {
+                fail("an inconsistent child list");
+            }
+            int numProperParts = 0;
+            PixelId previousPixelId = InvalidNode;
+            for (PixelId pixelId = nodes_[nodeId].properHead; pixelId != InvalidNode; pixelId = nextProperPart_[pixelId]) {
+                if (++numProperParts > numProperPartsByNode_[nodeId] || properPartOwner_[pixelId] != nodeId || prevProperPart_[pixelId] != previousPixelId) {
+                    fail("an inconsistent proper-part list");
+                }
+                previousPixelId = pixelId;
+            }
+            if (numProperParts != numProperPartsByNode_[nodeId] || properTail_[nodeId] != previousPixelId) {
+                fail("an inconsistent proper-part list");
+            }
+            numListedPixels += numProperParts;
+        }
+        if ((int) order.size() != numNodes_) {
+            fail("live nodes unreachable from the root");
+        }
+        // Each listed pixel names its list's node as owner, so no pixel is
+        // listed twice; the total then rules out pixels left out of every list.
+        if (numListedPixels != numPixels) {
+            fail("pixels outside every proper-part list");
+        }
+    }
+
     /**
-     * @brief Initializes the tree backend vectors.
+     * @brief Sum of `measure(column)` over every chunked column.
+     */
+    template<typename Measure>
+    std::size_t forEachColumnSum(Measure &&measure) const {
+        return measure(nodes_) + measure(properTail_) + measure(numProperPartsByNode_) +
+               measure(properPartOwner_) + measure(nextProperPart_) + measure(prevProperPart_) +
+               measure(ownerBlockParent_) + measure(ownerBlockRank_) + measure(ownerBlockNode_) + measure(nodeOwnerBlock_);
+    }
+
+    void writeCell(ChunkedColumn<Index> BasicDynamicComponentTree::*column, int index, int value) {
+        ChunkedColumn<Index> &cells = this->*column;
+        if (journaling_) {
+            journal_.push_back({column, nullptr, index, cells[index], JournalOp::Cell});
+        }
+        cells.set(index, (Index) value);
+    }
+
+    void writeNode(Index NodeRecord::*field, NodeId nodeId, int value) {
+        if (journaling_) {
+            journal_.push_back({nullptr, field, nodeId, nodes_[nodeId].*field, JournalOp::NodeField});
+        }
+        nodes_.mutableAt(nodeId).*field = (Index) value;
+    }
+
+    void writeAltitude(NodeId nodeId, NodeAltitude value) {
+        if (journaling_) {
+            journal_.push_back({nullptr, nullptr, nodeId, nodes_[nodeId].altitude, JournalOp::Altitude});
+        }
+        nodes_.mutableAt(nodeId).altitude = value;
+    }
+
+    void writeRootId(NodeId nodeId) {
+        if (journaling_) {
+            journal_.push_back({nullptr, nullptr, 0, rootNodeId_, JournalOp::Root});
+        }
+        rootNodeId_ = nodeId;
+    }
+
+    void addToNumNodes(int delta) {
+        if (journaling_) {
+            journal_.push_back({nullptr, nullptr, 0, numNodes_, JournalOp::NumNodes});
+        }
+        numNodes_ += delta;
+    }
+
+    void pushFreeNodeId(NodeId nodeId) {
+        if (journaling_) {
+            journal_.push_back({nullptr, nullptr, 0, nodeId, JournalOp::PushFreeNode});
+        }
+        freeNodeIds_.push_back(nodeId);
+    }
+
+    void popFreeNodeId() {
+        if (journaling_) {
+            journal_.push_back({nullptr, nullptr, 0, freeNodeIds_.back(), JournalOp::PopFreeNode});
+        }
+        freeNodeIds_.pop_back();
+    }
+
+    void resetChangedPixels(bool allChanged) {
+        changedPixels_.clear();
+        if (changedPixelMarks_.n != properPartOwner_.size()) {
+            changedPixelMarks_.resize(properPartOwner_.size());
+        } else {
+            changedPixelMarks_.resetAll();
+        }
+        allPixelsChanged_ = allChanged;
+    }
+
+    /**
+     * @brief Initializes the tree backend columns.
      * @param numProperParts Number of image pixels.
      * @param numInternalNodeSlots Number of nodes materialized in the initial build.
      *
-     * The node vectors and pixel vectors are kept separate.
+     * The node columns and pixel columns are kept separate.
      */
+    static constexpr NodeRecord EmptyNodeRecord = {InvalidNode, InvalidNode, InvalidNode, InvalidNode, InvalidNode, 0, InvalidNode, 0};
+
     void initializeStorage(int numProperParts, int numInternalNodeSlots) {
         rootNodeId_ = InvalidNode;
         numNodes_ = 0;
 
-        altitude_.assign((size_t) std::max(0, numInternalNodeSlots), 0);
+        nodes_.assign((size_t) std::max(0, numInternalNodeSlots), EmptyNodeRecord);
         freeNodeIds_.clear();
-        nodeParent_.assign((size_t) std::max(0, numInternalNodeSlots), InvalidNode);
-        firstChild_.assign((size_t) std::max(0, numInternalNodeSlots), InvalidNode);
-        lastChild_.assign((size_t) std::max(0, numInternalNodeSlots), InvalidNode);
-        nextSibling_.assign((size_t) std::max(0, numInternalNodeSlots), InvalidNode);
-        prevSibling_.assign((size_t) std::max(0, numInternalNodeSlots), InvalidNode);
-        numChildrenByNode_.assign((size_t) std::max(0, numInternalNodeSlots), 0);
-        properHead_.assign((size_t) std::max(0, numInternalNodeSlots), InvalidNode);
         properTail_.assign((size_t) std::max(0, numInternalNodeSlots), InvalidNode);
         numProperPartsByNode_.assign((size_t) std::max(0, numInternalNodeSlots), 0);
 
@@ -186,6 +611,14 @@ private:
         nodeStructureVersion_ = 0;
         topologyVersion_ = 0;
         properPartVersion_ = 0;
+        if (trackPixelChanges_) {
+            resetChangedPixels(true);
+        }
+        if (lazyOwnership_) {
+            resetOwnerBlocks();
+        }
+        journaling_ = false;
+        journal_.clear();
     }
 
     /**
@@ -194,17 +627,17 @@ private:
      * @param pixelId Pixel to append.
      */
     void appendProperPartToNode(NodeId nodeId, PixelId pixelId) {
-        properPartOwner_[pixelId] = nodeId;
-        if (properHead_[nodeId] == InvalidNode) {
-            properHead_[nodeId] = pixelId;
-            properTail_[nodeId] = pixelId;
+        properPartOwner_.set(pixelId, (Index) nodeId);
+        if (nodes_[nodeId].properHead == InvalidNode) {
+            nodes_.mutableAt(nodeId).properHead = (Index) pixelId;
+            properTail_.set(nodeId, (Index) pixelId);
         } else {
             const PixelId tail = properTail_[nodeId];
-            nextProperPart_[tail] = pixelId;
-            prevProperPart_[pixelId] = tail;
-            properTail_[nodeId] = pixelId;
+            nextProperPart_.set(tail, (Index) pixelId);
+            prevProperPart_.set(pixelId, (Index) tail);
+            properTail_.set(nodeId, (Index) pixelId);
         }
-        numProperPartsByNode_[nodeId]++;
+        numProperPartsByNode_.set(nodeId, (Index) (numProperPartsByNode_[nodeId] + 1));
     }
 
     /**
@@ -213,16 +646,16 @@ private:
      * @param childId Direct child node to append.
      */
     void linkChildBack(NodeId parentId, NodeId childId) {
-        const NodeId tail = lastChild_[parentId];
+        const NodeId tail = nodes_[parentId].lastChild;
         if (tail == InvalidNode) {
-            firstChild_[parentId] = childId;
-            lastChild_[parentId] = childId;
+            writeNode(&NodeRecord::firstChild, parentId, childId);
+            writeNode(&NodeRecord::lastChild, parentId, childId);
         } else {
-            nextSibling_[tail] = childId;
-            prevSibling_[childId] = tail;
-            lastChild_[parentId] = childId;
+            writeNode(&NodeRecord::nextSibling, tail, childId);
+            writeNode(&NodeRecord::prevSibling, childId, tail);
+            writeNode(&NodeRecord::lastChild, parentId, childId);
         }
-        numChildrenByNode_[parentId]++;
+        writeNode(&NodeRecord::numChildren, parentId, nodes_[parentId].numChildren + 1);
     }
 
     /**
@@ -230,25 +663,25 @@ private:
      * @param childId Child to detach.
      */
     void unlinkChild(NodeId childId) {
-        const NodeId parentId = nodeParent_[childId];
-        const NodeId prev = prevSibling_[childId];
-        const NodeId next = nextSibling_[childId];
+        const NodeId parentId = nodes_[childId].parent;
+        const NodeId prev = nodes_[childId].prevSibling;
+        const NodeId next = nodes_[childId].nextSibling;
 
         if (prev != InvalidNode) {
-            nextSibling_[prev] = next;
+            writeNode(&NodeRecord::nextSibling, prev, next);
         } else {
-            firstChild_[parentId] = next;
+            writeNode(&NodeRecord::firstChild, parentId, next);
         }
 
         if (next != InvalidNode) {
-            prevSibling_[next] = prev;
+            writeNode(&NodeRecord::prevSibling, next, prev);
         } else {
-            lastChild_[parentId] = prev;
+            writeNode(&NodeRecord::lastChild, parentId, prev);
         }
 
-        prevSibling_[childId] = InvalidNode;
-        nextSibling_[childId] = InvalidNode;
-        numChildrenByNode_[parentId]--;
+        writeNode(&NodeRecord::prevSibling, childId, InvalidNode);
+        writeNode(&NodeRecord::nextSibling, childId, InvalidNode);
+        writeNode(&NodeRecord::numChildren, parentId, nodes_[parentId].numChildren - 1);
     }
 
     /**
@@ -257,29 +690,40 @@ private:
      * The backend only relinks the lists and updates the owner node of each pixel.
      */
     void moveProperPartsInBackend(NodeId targetNodeId, NodeId sourceNodeId) {
-        const PixelId movedHead = properHead_[sourceNodeId];
+        const PixelId movedHead = nodes_[sourceNodeId].properHead;
         if (movedHead == InvalidNode) {
             return;
         }
 
-        for (PixelId pixelId = movedHead; pixelId != InvalidNode; pixelId = nextProperPart_[pixelId]) {
-            properPartOwner_[pixelId] = targetNodeId;
+        // Pixels that change level are visited anyway to log them, so lazy
+        // ownership only skips the walk when nothing needs logging.
+        const bool recordChanges = trackPixelChanges_ && nodes_[targetNodeId].altitude != nodes_[sourceNodeId].altitude;
+        if (lazyOwnership_ && !recordChanges) {
+            linkOwnerBlocks(targetNodeId, sourceNodeId);
+        } else {
+            const int ownerId = lazyOwnership_ ? nodeOwnerBlock_[targetNodeId] : targetNodeId;
+            for (PixelId pixelId = movedHead; pixelId != InvalidNode; pixelId = nextProperPart_[pixelId]) {
+                writeCell(&BasicDynamicComponentTree::properPartOwner_, pixelId, ownerId);
+                if (recordChanges) {
+                    recordChangedPixel(pixelId);
+                }
+            }
         }
 
         if (numProperPartsByNode_[targetNodeId] == 0) {
-            properHead_[targetNodeId] = movedHead;
-            properTail_[targetNodeId] = properTail_[sourceNodeId];
-            numProperPartsByNode_[targetNodeId] = numProperPartsByNode_[sourceNodeId];
+            writeNode(&NodeRecord::properHead, targetNodeId, movedHead);
+            writeCell(&BasicDynamicComponentTree::properTail_, targetNodeId, properTail_[sourceNodeId]);
+            writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, targetNodeId, numProperPartsByNode_[sourceNodeId]);
         } else {
-            prevProperPart_[movedHead] = properTail_[targetNodeId];
-            nextProperPart_[properTail_[targetNodeId]] = movedHead;
-            properTail_[targetNodeId] = properTail_[sourceNodeId];
-            numProperPartsByNode_[targetNodeId] += numProperPartsByNode_[sourceNodeId];
+            writeCell(&BasicDynamicComponentTree::prevProperPart_, movedHead, properTail_[targetNodeId]);
+            writeCell(&BasicDynamicComponentTree::nextProperPart_, properTail_[targetNodeId], movedHead);
+            writeCell(&BasicDynamicComponentTree::properTail_, targetNodeId, properTail_[sourceNodeId]);
+            writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, targetNodeId, numProperPartsByNode_[targetNodeId] + numProperPartsByNode_[sourceNodeId]);
         }
 
-        properHead_[sourceNodeId] = InvalidNode;
-        properTail_[sourceNodeId] = InvalidNode;
-        numProperPartsByNode_[sourceNodeId] = 0;
+        writeNode(&NodeRecord::properHead, sourceNodeId, InvalidNode);
+        writeCell(&BasicDynamicComponentTree::properTail_, sourceNodeId, InvalidNode);
+        writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, sourceNodeId, 0);
     }
 
     /**
@@ -287,7 +731,7 @@ private:
      */
     void detachNodeInBackend(NodeId nodeId) {
         unlinkChild(nodeId);
-        nodeParent_[nodeId] = nodeId;
+        writeNode(&NodeRecord::parent, nodeId, nodeId);
     }
 
     /**
@@ -296,25 +740,208 @@ private:
      * The node index becomes available for reuse by `allocateNode`.
      */
     void releaseNodeSlot(NodeId nodeId) {
-        firstChild_[nodeId] = InvalidNode;
-        lastChild_[nodeId] = InvalidNode;
-        nextSibling_[nodeId] = InvalidNode;
-        prevSibling_[nodeId] = InvalidNode;
-        numChildrenByNode_[nodeId] = 0;
-        properHead_[nodeId] = InvalidNode;
-        properTail_[nodeId] = InvalidNode;
-        numProperPartsByNode_[nodeId] = 0;
-        nodeParent_[nodeId] = InvalidNode;
-        altitude_[nodeId] = 0;
-        freeNodeIds_.push_back(nodeId);
-        numNodes_--;
+        writeNode(&NodeRecord::firstChild, nodeId, InvalidNode);
+        writeNode(&NodeRecord::lastChild, nodeId, InvalidNode);
+        writeNode(&NodeRecord::nextSibling, nodeId, InvalidNode);
+        writeNode(&NodeRecord::prevSibling, nodeId, InvalidNode);
+        writeNode(&NodeRecord::numChildren, nodeId, 0);
+        writeNode(&NodeRecord::properHead, nodeId, InvalidNode);
+        writeCell(&BasicDynamicComponentTree::properTail_, nodeId, InvalidNode);
+        writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, nodeId, 0);
+        writeNode(&NodeRecord::parent, nodeId, InvalidNode);
+        writeAltitude(nodeId, 0);
+        pushFreeNodeId(nodeId);
+        addToNumNodes(-1);
+    }
+
+    /**
+     * @brief Materializes nodes and proper parts from a union-find parent forest.
+     * @param orderedPixels Pixels in min/max-tree-compatible order.
+     * @param parent Pixel parent forest; it is canonicalized in place.
+     * @param pixelToNodeId Scratch buffer for the pixel-to-node map.
+     *
+     * Node ids are assigned in the order of `orderedPixels`, so every build
+     * path that produces the same canonical forest yields the same tree.
+     */
+    template<typename PixelType>
+    void materializeTreeFromParents(const std::vector<PixelId> &orderedPixels,
+                                    std::vector<int> &parent,
+                                    std::vector<NodeId> &pixelToNodeId,
+                                    const PixelType *img) {
+        const int numPixels = static_cast<int>(orderedPixels.size());
+        pixelToNodeId.assign((size_t) numPixels, InvalidNode);
+
+        int numNodes = 0;
+        for (int i = 0; i < numPixels; ++i) {
+            const int p = orderedPixels[i];
+            const int q = parent[p];
+            if (img[parent[q]] == img[q]) {
+                parent[p] = parent[q];
+            }
+            if (parent[p] == p || img[parent[p]] != img[p]) {
+                ++numNodes;
+            }
+        }
+
+        initializeStorage(numPixels, numNodes);
+
+        int nextNodeId = 0;
+        for (int i = 0; i < numPixels; ++i) {
+            const int p = orderedPixels[i];
+            if (p == parent[p]) {
+                const NodeId dynamicNodeId = nextNodeId++;
+                rootNodeId_ = dynamicNodeId;
+                NodeRecord &record = nodes_.mutableAt(dynamicNodeId);
+                record.parent = (Index) dynamicNodeId;
+                record.altitude = img[p];
+                pixelToNodeId[p] = dynamicNodeId;
+                numNodes_++;
+            } else if (img[p] != img[parent[p]]) {
+                const NodeId dynamicNodeId = nextNodeId++;
+                const NodeId dynamicParentId = pixelToNodeId[parent[p]];
+                NodeRecord &record = nodes_.mutableAt(dynamicNodeId);
+                record.parent = (Index) dynamicParentId;
+                record.altitude = img[p];
+                linkChildBack(dynamicParentId, dynamicNodeId);
+                pixelToNodeId[p] = dynamicNodeId;
+                numNodes_++;
+            } else {
+                pixelToNodeId[p] = pixelToNodeId[parent[p]];
+            }
+        }
+
+        for (int i = 0; i < numPixels; ++i) {
+            const int p = orderedPixels[i];
+            appendProperPartToNode(pixelToNodeId[p], p);
+        }
+    }
+
+    /**
+     * @brief Runs the sequential union-find and fills `workspace.parent`.
+     * @param adj Adjacency used for the neighbor scans.
+     */
+    void computeUnionFindParents(const std::vector<PixelId> &orderedPixels, BuildWorkspace &workspace, const AdjacencyRelation &adj) {
+        const int numPixels = numRows_ * numCols_;
+        std::vector<int> &zPar = workspace.zPar;
+        std::vector<int> &parent = workspace.parent;
+        zPar.assign((size_t) numPixels, -1);
+        parent.assign((size_t) numPixels, -1);
+        auto findRoot = [&](NodeId p) {
+            while (zPar[p] != p) {
+                zPar[p] = zPar[zPar[p]];
+                p = zPar[p];
+            }
+            return p;
+        };
+        adj.withStencil([&](auto stencil) {
+            using Stencil = decltype(stencil);
+            for (int i = numPixels - 1; i >= 0; --i) {
+                const int p = orderedPixels[i];
+                parent[p] = p;
+                zPar[p] = p;
+                Stencil::forEachNeighbor(adj, p, [&](int q) {
+                    if (zPar[q] != -1) {
+                        const int r = findRoot(q);
+                        if (p != r) {
+                            parent[r] = p;
+                            zPar[r] = p;
+                        }
+                    }
+                });
+            }
+        });
+    }
+
+    /**
+     * @brief Records the image metadata of a build without touching the storage.
+     */
+    template<typename PixelType>
+    void prepareBuild(const ImagePtr<PixelType> &image, bool isMaxtree, AdjacencyRelationPtr adj) {
+        static_assert(std::is_integral_v<PixelType> && std::is_unsigned_v<PixelType>, "DynamicComponentTree requires unsigned integral pixels");
+        static_assert(sizeof(PixelType) <= 2, "DynamicComponentTree altitudes are limited to 16 bits");
+        assert(image != nullptr);
+        assert(adj != nullptr);
+        if ((int64_t) image->getSize() > MaxNumPixels) {
+            throw std::runtime_error("DynamicComponentTree index type is too narrow for an image of this size.");
+        }
+        adj_ = std::move(adj);
+        numRows_ = image->getNumRows();
+        numCols_ = image->getNumCols();
+        isMaxtree_ = isMaxtree;
+        imageBitDepth_ = 8 * (int) sizeof(PixelType);
+    }
+
+    /**
+     * @brief Stable LSD radix sort of the pixels in `[beginPixel, endPixel)` by tree key.
+     * @param orderedPixels Receives the sorted pixels.
+     * @param scratch Ping-pong buffer; its contents are unspecified on return.
+     *
+     * The key is the gray level for a max-tree and its complement for a
+     * min-tree, sorted one byte per pass; ties keep increasing pixel order,
+     * exactly as in `countingSort`. Passes whose digit is constant over the
+     * range are skipped, so 12-bit data sorted as 16 bits pays for the high
+     * byte only when it actually varies.
+     */
+    template<typename PixelType>
+    static void radixSortPixels(const PixelType *img,
+                                int beginPixel,
+                                int endPixel,
+                                bool isMaxtree,
+                                std::vector<PixelId> &orderedPixels,
+                                std::vector<PixelId> &scratch) {
+        const int count = endPixel - beginPixel;
+        orderedPixels.resize((size_t) count);
+        scratch.resize((size_t) count);
+        for (int i = 0; i < count; ++i) {
+            orderedPixels[i] = beginPixel + i;
+        }
+        if (count == 0) {
+            return;
+        }
+
+        auto key = [img, isMaxtree](PixelId p) -> uint32_t {
+            return isMaxtree ? (uint32_t) img[p] : (uint32_t) (std::numeric_limits<PixelType>::max() - img[p]);
+        };
+        std::array<uint32_t, 256> counter;
+        for (int shift = 0; shift < 8 * (int) sizeof(PixelType); shift += 8) {
+            counter.fill(0);
+            for (int i = 0; i < count; ++i) {
+                counter[(key(orderedPixels[i]) >> shift) & 0xFFu]++;
+            }
+            if (counter[(key(orderedPixels[0]) >> shift) & 0xFFu] == (uint32_t) count) {
+                continue;
+            }
+            uint32_t sum = 0;
+            for (uint32_t &bucket : counter) {
+                const uint32_t size = bucket;
+                bucket = sum;
+                sum += size;
+            }
+            for (int i = 0; i < count; ++i) {
+                const PixelId p = orderedPixels[i];
+                scratch[counter[(key(p) >> shift) & 0xFFu]++] = p;
+            }
+            orderedPixels.swap(scratch);
+        }
+    }
+
+    /**
+     * @brief Sorts the image pixels into `workspace.orderedPixels` for this tree's polarity.
+     */
+    template<typename PixelType>
+    void sortPixels(const ImagePtr<PixelType> &image, BuildWorkspace &workspace) const {
+        if constexpr (sizeof(PixelType) == 1) {
+            countingSort(image, workspace.orderedPixels);
+        } else {
+            radixSortPixels(image->rawData(), 0, numRows_ * numCols_, isMaxtree_, workspace.orderedPixels, workspace.radixScratch);
+        }
     }
 
 public:
     /**
      * @brief Lightweight range of the direct children of a node.
      *
-     * The range encapsulates the singly traversable list via `nextSibling_`,
+     * The range encapsulates the singly traversable list via `NodeRecord::nextSibling`,
      * exposing only a minimal forward interface.
      */
     class ChildrenRange;
@@ -322,20 +949,20 @@ public:
      * @brief Lightweight range of a node's direct proper parts.
      *
      * Each proper part is a leaf/pixel of the hierarchy. The range traverses
-     * the doubly linked list whose head lives in `properHead_[nodeId]`.
+     * the doubly linked list whose head lives in `nodes_[nodeId].properHead`.
      */
     class ProperPartsRange;
     /**
      * @brief Range for traversing a subtree in depth-first order.
      *
-     * The traversal uses iterative DFS and returns only live internal nodes.
+     * The traversal is stackless and returns only live internal nodes.
      */
     class SubtreeNodeRange;
 
     /**
      * @brief Empty constructor; the tree can be built later with `build`.
      */
-    DynamicComponentTree() = default;
+    BasicDynamicComponentTree() = default;
 
     /**
      * @brief Range for breadth-first traversal of a subtree.
@@ -347,9 +974,11 @@ public:
      * @param image Grayscale image.
      * @param isMaxtree `true` for max-tree, `false` for min-tree.
      * @param adj Image adjacency relation.
+     * @param numThreads Number of worker threads used by the union-find phase.
      */
-    DynamicComponentTree(ImageUInt8Ptr image, bool isMaxtree, AdjacencyRelationPtr adj) {
-        build(image, isMaxtree, adj);
+    template<typename PixelType>
+    BasicDynamicComponentTree(ImagePtr<PixelType> image, bool isMaxtree, AdjacencyRelationPtr adj, int numThreads = 1) {
+        build(image, isMaxtree, adj, numThreads);
     }
 
     /**
@@ -357,16 +986,117 @@ public:
      * @param image Base grayscale image.
      * @param isMaxtree `true` for max-tree, `false` for min-tree.
      * @param adj Adjacency relation used during construction.
+     * @param numThreads Number of worker threads used by the union-find phase.
+     *
+     * With `numThreads > 1` the union-find runs on horizontal image tiles in
+     * parallel and the partial trees are merged along the tile borders (see
+     * `createTreeByTiledUnionFind`). Both paths produce exactly the same node
+     * ids, child lists, and proper-part lists.
      */
-    void build(ImageUInt8Ptr image, bool isMaxtree, AdjacencyRelationPtr adj) {
-        assert(image != nullptr);
-        assert(adj != nullptr);
-        adj_ = adj;
-        numRows_ = image->getNumRows();
-        numCols_ = image->getNumCols();
-        isMaxtree_ = isMaxtree;
-        auto orderedPixels = countingSort(image);
-        createTreeByUnionFind(orderedPixels, image);
+    template<typename PixelType>
+    void build(ImagePtr<PixelType> image, bool isMaxtree, AdjacencyRelationPtr adj, int numThreads = 1) {
+        BuildWorkspace workspace;
+        build(image, isMaxtree, adj, workspace, numThreads);
+    }
+
+    /**
+     * @brief Variant of `build` that recycles the tree storage and a caller-held workspace.
+     * @param workspace Scratch buffers reused across builds.
+     *
+     * The node and pixel columns are refilled with `assign`, so the chunks
+     * of the previous build of this instance are reused unless a copy of the
+     * tree still shares them.
+     */
+    template<typename PixelType>
+    void build(ImagePtr<PixelType> image, bool isMaxtree, AdjacencyRelationPtr adj, BuildWorkspace &workspace, int numThreads = 1) {
+        prepareBuild(image, isMaxtree, adj);
+        sortPixels(image, workspace);
+        if (std::min(numThreads, numRows_) > 1) {
+            createTreeByTiledUnionFind(workspace.orderedPixels, image, numThreads, workspace);
+        } else {
+            createTreeByUnionFind(workspace.orderedPixels, image, workspace);
+        }
+    }
+
+    /**
+     * @brief Rebuilds the tree from a new image keeping polarity and adjacency.
+     * @param image Image with the same size as the adjacency relation.
+     * @param workspace Scratch buffers reused across builds.
+     */
+    template<typename PixelType>
+    void rebuild(ImagePtr<PixelType> image, BuildWorkspace &workspace) {
+        assert(adj_ != nullptr);
+        build(image, isMaxtree_, adj_, workspace);
+    }
+
+    /**
+     * @brief Builds a max-tree and a min-tree of the same image from a single sort.
+     * @param maxtree Tree rebuilt as the max-tree of `image`.
+     * @param mintree Tree rebuilt as the min-tree of `image`.
+     * @param image Base grayscale image shared by both trees.
+     * @param adj Adjacency relation shared by both trees.
+     * @param concurrent If `true`, both union-finds run on two threads.
+     *
+     * The histogram is computed once by `countingSortMinMax`; the min-tree
+     * order is the max-tree order with its level blocks taken in reverse, so
+     * each tree is identical to the one built independently by `build`. The
+     * sequential path shares one `BuildWorkspace` between both trees.
+     */
+    template<typename PixelType>
+    static void buildMinMaxTrees(BasicDynamicComponentTree &maxtree,
+                                 BasicDynamicComponentTree &mintree,
+                                 ImagePtr<PixelType> image,
+                                 AdjacencyRelationPtr adj,
+                                 bool concurrent = false) {
+        BuildWorkspace maxWorkspace;
+        BuildWorkspace minWorkspace;
+        buildMinMaxTrees(maxtree, mintree, image, adj, maxWorkspace, minWorkspace, concurrent);
+    }
+
+    /**
+     * @brief Variant of `buildMinMaxTrees` that recycles storage and caller-held workspaces.
+     * @param maxWorkspace Receives the max-tree order; its union-find scratch
+     *        is shared by both trees in the sequential path.
+     * @param minWorkspace Receives the min-tree order; its union-find scratch
+     *        is only used by the concurrent path.
+     */
+    template<typename PixelType>
+    static void buildMinMaxTrees(BasicDynamicComponentTree &maxtree,
+                                 BasicDynamicComponentTree &mintree,
+                                 ImagePtr<PixelType> image,
+                                 AdjacencyRelationPtr adj,
+                                 BuildWorkspace &maxWorkspace,
+                                 BuildWorkspace &minWorkspace,
+                                 bool concurrent = false) {
+        assert(&maxtree != &mintree);
+        assert(&maxWorkspace != &minWorkspace);
+        maxtree.prepareBuild(image, true, adj);
+        mintree.prepareBuild(image, false, adj);
+        countingSortMinMax(image, maxWorkspace.orderedPixels, minWorkspace.orderedPixels);
+
+        if (concurrent) {
+            std::thread minWorker([&]() {
+                mintree.createTreeByUnionFind(minWorkspace.orderedPixels, image, minWorkspace);
+            });
+            maxtree.createTreeByUnionFind(maxWorkspace.orderedPixels, image, maxWorkspace);
+            minWorker.join();
+        } else {
+            maxtree.createTreeByUnionFind(maxWorkspace.orderedPixels, image, maxWorkspace);
+            mintree.createTreeByUnionFind(minWorkspace.orderedPixels, image, maxWorkspace);
+        }
+    }
+
+    /**
+     * @brief Factory variant of `buildMinMaxTrees`.
+     * @return Pair `(maxtree, mintree)`.
+     */
+    template<typename PixelType>
+    static std::pair<std::unique_ptr<BasicDynamicComponentTree>, std::unique_ptr<BasicDynamicComponentTree>>
+    createMinMaxTrees(ImagePtr<PixelType> image, AdjacencyRelationPtr adj, bool concurrent = false) {
+        auto maxtree = std::make_unique<BasicDynamicComponentTree>();
+        auto mintree = std::make_unique<BasicDynamicComponentTree>();
+        buildMinMaxTrees(*maxtree, *mintree, image, adj, concurrent);
+        return {std::move(maxtree), std::move(mintree)};
     }
 
     /**
@@ -374,14 +1104,32 @@ public:
      * @return Vector of pixels in min-tree/max-tree-compatible order.
      *
      * For a max-tree, the order is increasing in gray level; for a min-tree,
-     * the order is inverted by the `maxvalue - gray` transform.
+     * the order is inverted by the `maxvalue - gray` transform. Images wider
+     * than 8 bits are sorted by `radixSortPixels`, which yields the same order.
+     */
+    template<typename PixelType>
+    std::vector<PixelId> countingSort(ImagePtr<PixelType> image) const {
+        std::vector<PixelId> orderedPixels;
+        countingSort(image, orderedPixels);
+        return orderedPixels;
+    }
+
+    /**
+     * @brief Variant of `countingSort` that writes into a reusable buffer.
      */
-    std::vector<PixelId> countingSort(ImageUInt8Ptr image) const {
+    template<typename PixelType>
+    void countingSort(const ImagePtr<PixelType> &image, std::vector<PixelId> &orderedPixels) const {
         assert(image != nullptr);
-        const uint8_t *img = image->rawData();
+        if constexpr (sizeof(PixelType) > 1) {
+            std::vector<PixelId> scratch;
+            radixSortPixels(image->rawData(), 0, numRows_ * numCols_, isMaxtree_, orderedPixels, scratch);
+            return;
+        }
+        const PixelType *img = image->rawData();
         const int n = numRows_ * numCols_;
+        orderedPixels.resize((size_t) n);
         if (n == 0) {
-            return {};
+            return;
         }
 
         int maxvalue = img[0];
@@ -391,8 +1139,7 @@ public:
             }
         }
 
-        std::vector<uint32_t> counter(maxvalue + 1, 0);
-        std::vector<PixelId> orderedPixels(n);
+        std::array<uint32_t, 256> counter{};
 
         if (isMaxtree_) {
             for (int i = 0; i < n; ++i) {
@@ -421,8 +1168,61 @@ public:
                 orderedPixels[--counter[maxvalue - img[i]]] = i;
             }
         }
+    }
 
-        return orderedPixels;
+    /**
+     * @brief Sorts pixels once for both polarities.
+     * @param maxOrder Receives the order used by the max-tree build.
+     * @param minOrder Receives the order used by the min-tree build.
+     *
+     * Both outputs equal what `countingSort` returns for the corresponding
+     * polarity: one histogram is shared and a single stable scatter pass
+     * writes each pixel into its level block of both orders. For wider
+     * pixels the max-tree order comes from `radixSortPixels` and the min-tree
+     * order is obtained by taking its level runs in reverse.
+     */
+    template<typename PixelType>
+    static void countingSortMinMax(const ImagePtr<PixelType> &image, std::vector<PixelId> &maxOrder, std::vector<PixelId> &minOrder) {
+        assert(image != nullptr);
+        const PixelType *img = image->rawData();
+        const int n = image->getSize();
+        if constexpr (sizeof(PixelType) > 1) {
+            radixSortPixels(img, 0, n, true, maxOrder, minOrder);
+            minOrder.resize((size_t) n);
+            int out = 0;
+            for (int runEnd = n; runEnd > 0;) {
+                int runBegin = runEnd - 1;
+                while (runBegin > 0 && img[maxOrder[runBegin - 1]] == img[maxOrder[runEnd - 1]]) {
+                    --runBegin;
+                }
+                std::copy(maxOrder.begin() + runBegin, maxOrder.begin() + runEnd, minOrder.begin() + out);
+                out += runEnd - runBegin;
+                runEnd = runBegin;
+            }
+            return;
+        }
+        maxOrder.resize((size_t) n);
+        minOrder.resize((size_t) n);
+
+        std::array<uint32_t, 256> maxEnd{};
+        std::array<uint32_t, 256> minEnd{};
+        for (int i = 0; i < n; ++i) {
+            maxEnd[img[i]]++;
+        }
+        uint32_t ascending = 0;
+        for (int level = 0; level < 256; ++level) {
+            ascending += maxEnd[level];
+            maxEnd[level] = ascending;
+        }
+        uint32_t descending = 0;
+        for (int level = 255; level >= 0; --level) {
+            descending += maxEnd[level] - (level > 0 ? maxEnd[level - 1] : 0);
+            minEnd[level] = descending;
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            maxOrder[--maxEnd[img[i]]] = i;
+            minOrder[--minEnd[img[i]]] = i;
+        }
     }
 
     /**
@@ -432,79 +1232,184 @@ public:
      * The result is produced directly in the mutable format used by the rest of
      * the class: explicit nodes, explicit proper parts, and linked child lists.
      */
-    void createTreeByUnionFind(std::vector<PixelId> &orderedPixels, ImageUInt8Ptr image) {
+    template<typename PixelType>
+    void createTreeByUnionFind(std::vector<PixelId> &orderedPixels, ImagePtr<PixelType> image) {
+        BuildWorkspace workspace;
+        createTreeByUnionFind(orderedPixels, image, workspace);
+    }
+
+    /**
+     * @brief Variant of `createTreeByUnionFind` that reuses caller-provided scratch buffers.
+     */
+    template<typename PixelType>
+    void createTreeByUnionFind(const std::vector<PixelId> &orderedPixels, ImagePtr<PixelType> image, BuildWorkspace &workspace) {
+        assert(adj_ != nullptr);
+        createTreeByUnionFind(orderedPixels, image, workspace, *adj_);
+    }
+
+    /**
+     * @brief Variant of `createTreeByUnionFind` with an explicit adjacency for the neighbor scans.
+     */
+    template<typename PixelType>
+    void createTreeByUnionFind(const std::vector<PixelId> &orderedPixels,
+                               ImagePtr<PixelType> image,
+                               BuildWorkspace &workspace,
+                               const AdjacencyRelation &adj) {
+        assert(image != nullptr);
+        computeUnionFindParents(orderedPixels, workspace, adj);
+        materializeTreeFromParents(orderedPixels, workspace.parent, workspace.pixelToNodeId, image->rawData());
+    }
+
+    /**
+     * @brief Parallel variant of `createTreeByUnionFind` over horizontal tiles.
+     * @param orderedPixels Pixels in min/max-tree-compatible order.
+     * @param numThreads Number of tiles/worker threads.
+     *
+     * Each worker sorts the pixels of its tile, runs the union-find restricted
+     * to the tile, and canonicalizes its partial parent forest. The partial
+     * trees are then merged along every adjacency edge crossing a tile border
+     * with the level-root merge of Wilkinson et al. (2008), where ties between
+     * pixels of equal gray level are broken by the same `(level, pixelId)`
+     * order produced by `countingSort`. Because the canonical parent of every
+     * pixel only depends on that order, the merged forest is materialized by
+     * the same sequential pass as the serial build and yields identical node
+     * ids, child lists, and proper-part lists.
+     */
+    template<typename PixelType>
+    void createTreeByTiledUnionFind(const std::vector<PixelId> &orderedPixels,
+                                    ImagePtr<PixelType> image,
+                                    int numThreads,
+                                    BuildWorkspace &workspace) {
         assert(image != nullptr);
         assert(adj_ != nullptr);
-        const uint8_t *img = image->rawData();
+        const PixelType *img = image->rawData();
 
         const int numPixels = numRows_ * numCols_;
-        std::vector<int> zPar(numPixels, -1);
-        std::vector<int> parent(numPixels, -1);
-        std::vector<NodeId> pixelToNodeId(numPixels, InvalidNode);
-        auto findRoot = [&](NodeId p) {
-            while (zPar[p] != p) {
-                zPar[p] = zPar[zPar[p]];
-                p = zPar[p];
+        const int numTiles = std::max(1, std::min(numThreads, numRows_));
+        std::vector<int> &zPar = workspace.zPar;
+        std::vector<int> &parent = workspace.parent;
+        zPar.assign((size_t) numPixels, -1);
+        parent.assign((size_t) numPixels, -1);
+
+        // Rank of the serial order: higher rank is processed first by the union-find.
+        const bool isMaxtree = isMaxtree_;
+        auto isDeeper = [img, isMaxtree](int a, int b) {
+            if (img[a] != img[b]) {
+                return isMaxtree ? img[a] > img[b] : img[a] < img[b];
             }
-            return p;
+            return a > b;
         };
-        for (int i = numPixels - 1; i >= 0; --i) {
-            const int p = orderedPixels[i];
-            parent[p] = p;
-            zPar[p] = p;
-            for (int q : adj_->getNeighborPixels(p)) {
-                if (zPar[q] != -1) {
-                    const int r = findRoot(q);
-                    if (p != r) {
-                        parent[r] = p;
-                        zPar[r] = p;
-                    }
+
+        auto tileBegin = [&](int tile) { return (int) (((long long) numRows_ * tile) / numTiles) * numCols_; };
+
+        auto buildTile = [&](int tile) {
+            const int beginPixel = tileBegin(tile);
+            const int endPixel = tileBegin(tile + 1);
+            const int tileSize = endPixel - beginPixel;
+
+            std::vector<PixelId> tilePixels(tileSize);
+            if constexpr (sizeof(PixelType) == 1) {
+                std::vector<int> counter(257, 0);
+                auto key = [img, isMaxtree](int p) { return isMaxtree ? img[p] : 255 - img[p]; };
+                for (int p = beginPixel; p < endPixel; ++p) {
+                    counter[key(p) + 1]++;
+                }
+                for (int level = 1; level < 257; ++level) {
+                    counter[level] += counter[level - 1];
+                }
+                for (int p = beginPixel; p < endPixel; ++p) {
+                    tilePixels[counter[key(p)]++] = p;
                 }
+            } else {
+                std::vector<PixelId> scratch;
+                radixSortPixels(img, beginPixel, endPixel, isMaxtree, tilePixels, scratch);
             }
-        }
 
-        int numNodes = 0;
-        for (int i = 0; i < numPixels; ++i) {
-            const int p = orderedPixels[i];
-            const int q = parent[p];
-            if (img[parent[q]] == img[q]) {
-                parent[p] = parent[q];
-            }
-            if (parent[p] == p || img[parent[p]] != img[p]) {
-                ++numNodes;
+            const AdjacencyRelation &adj = *adj_;
+            auto findRoot = [&](int p) {
+                while (zPar[p] != p) {
+                    zPar[p] = zPar[zPar[p]];
+                    p = zPar[p];
+                }
+                return p;
+            };
+            adj.withStencil([&](auto stencil) {
+                using Stencil = decltype(stencil);
+                for (int i = tileSize - 1; i >= 0; --i) {
+                    const int p = tilePixels[i];
+                    parent[p] = p;
+                    zPar[p] = p;
+                    Stencil::forEachNeighbor(adj, p, [&](int q) {
+                        if (q >= beginPixel && q < endPixel && zPar[q] != -1) {
+                            const int r = findRoot(q);
+                            if (p != r) {
+                                parent[r] = p;
+                                zPar[r] = p;
+                            }
+                        }
+                    });
+                }
+            });
+            for (int i = 0; i < tileSize; ++i) {
+                const int p = tilePixels[i];
+                const int q = parent[p];
+                if (img[parent[q]] == img[q]) {
+                    parent[p] = parent[q];
+                }
             }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve((size_t) numTiles - 1);
+        for (int tile = 1; tile < numTiles; ++tile) {
+            workers.emplace_back(buildTile, tile);
+        }
+        buildTile(0);
+        for (auto &worker : workers) {
+            worker.join();
         }
 
-        initializeStorage(numPixels, numNodes);
+        auto levelRoot = [&](int p) {
+            while (parent[p] != p && img[parent[p]] == img[p]) {
+                p = parent[p];
+            }
+            return p;
+        };
+        auto connect = [&](int x, int y) {
+            x = levelRoot(x);
+            y = levelRoot(y);
+            if (isDeeper(y, x)) {
+                std::swap(x, y);
+            }
+            while (x != y && y != InvalidNode) {
+                const int z = (parent[x] == x) ? InvalidNode : levelRoot(parent[x]);
+                if (z != InvalidNode && isDeeper(z, y)) {
+                    x = z;
+                } else {
+                    parent[x] = y;
+                    x = y;
+                    y = z;
+                }
+            }
+        };
 
-        int nextNodeId = 0;
-        for (int i = 0; i < numPixels; ++i) {
-            const int p = orderedPixels[i];
-            if (p == parent[p]) {
-                const NodeId dynamicNodeId = nextNodeId++;
-                rootNodeId_ = dynamicNodeId;
-                nodeParent_[dynamicNodeId] = dynamicNodeId;
-                pixelToNodeId[p] = dynamicNodeId;
-                altitude_[dynamicNodeId] = img[p];
-                numNodes_++;
-            } else if (img[p] != img[parent[p]]) {
-                const NodeId dynamicNodeId = nextNodeId++;
-                const NodeId dynamicParentId = pixelToNodeId[parent[p]];
-                nodeParent_[dynamicNodeId] = dynamicParentId;
-                linkChildBack(dynamicParentId, dynamicNodeId);
-                pixelToNodeId[p] = dynamicNodeId;
-                altitude_[dynamicNodeId] = img[p];
-                numNodes_++;
-            } else {
-                pixelToNodeId[p] = pixelToNodeId[parent[p]];
+        int reach = 0;
+        for (int i = 0; i < adj_->getSize(); ++i) {
+            reach = std::max(reach, std::abs(adj_->getOffsetRow(i)));
+        }
+        for (int tile = 0; tile + 1 < numTiles; ++tile) {
+            const int endPixel = tileBegin(tile + 1);
+            const int borderBegin = std::max(tileBegin(tile), endPixel - reach * numCols_);
+            for (int p = borderBegin; p < endPixel; ++p) {
+                for (int q : adj_->getNeighborRange(p)) {
+                    if (q >= endPixel) {
+                        connect(p, q);
+                    }
+                }
             }
-            
         }
 
-        for (int i = 0; i < numPixels; ++i) {
-            const int p = orderedPixels[i];
-            appendProperPartToNode(pixelToNodeId[p], p);
-        }
+        materializeTreeFromParents(orderedPixels, parent, workspace.pixelToNodeId, img);
     }
 
     /**
@@ -517,7 +1422,11 @@ public:
      * Some of these nodes may be live, while others may already have been
      * released for reuse.
      */
-    int getNumInternalNodeSlots() const { return static_cast<int>(nodeParent_.size()); }
+    int getNumInternalNodeSlots() const { return static_cast<int>(nodes_.size()); }
+    /**
+     * @brief Number of released node slots waiting for reuse.
+     */
+    int getNumFreeNodeSlots() const { return static_cast<int>(freeNodeIds_.size()); }
     /**
      * @brief Id of the current hierarchy root.
      */
@@ -530,6 +1439,10 @@ public:
      * @brief Explicit alias for the number of columns in the base image.
      */
     int getNumColsOfImage() const { return numCols_; }
+    /**
+     * @brief Bit depth of the pixel type of the last image used to build the tree.
+     */
+    int getImageBitDepth() const { return imageBitDepth_; }
     /**
      * @brief Indicates whether the instance represents a max-tree.
      */
@@ -541,7 +1454,7 @@ public:
     /**
      * @brief Altitude/level of an internal node.
      */
-    int getAltitude(NodeId nodeId) const { return altitude_[nodeId]; }
+    int getAltitude(NodeId nodeId) const { return nodes_[nodeId].altitude; }
 
     /**
      * @brief Tests whether an index belongs to the node domain.
@@ -571,42 +1484,42 @@ public:
      * @brief Tests whether a node is currently live.
      */
     bool isAlive(NodeId nodeId) const {
-        return isNode(nodeId) && nodeParent_[nodeId] != InvalidNode;
+        return isNode(nodeId) && nodes_[nodeId].parent != InvalidNode;
     }
 
     /**
      * @brief Direct parent of an internal node.
      */
     NodeId getNodeParent(NodeId nodeId) const {
-        return nodeParent_[nodeId];
+        return nodes_[nodeId].parent;
     }
 
     /**
      * @brief Number of direct children of a node.
      */
     int getNumChildren(NodeId nodeId) const {
-        return numChildrenByNode_[nodeId];
+        return nodes_[nodeId].numChildren;
     }
 
     /**
      * @brief Tests whether a node has no children.
      */
     bool isLeaf(NodeId nodeId) const {
-        return firstChild_[nodeId] == InvalidNode;
+        return nodes_[nodeId].firstChild == InvalidNode;
     }
 
     /**
      * @brief First direct child of `nodeId`, or `InvalidNode` if none exists.
      */
     NodeId getFirstChild(NodeId nodeId) const {
-        return firstChild_[nodeId];
+        return nodes_[nodeId].firstChild;
     }
 
     /**
      * @brief Next sibling of `nodeId` in the parent's child list.
      */
     NodeId getNextSibling(NodeId nodeId) const {
-        return nextSibling_[nodeId];
+        return nodes_[nodeId].nextSibling;
     }
 
     /**
@@ -618,9 +1531,120 @@ public:
 
     /**
      * @brief Node that currently owns the given pixel.
+     * @details `O(1)`; with lazy ownership, logarithmic in the number of
+     * proper-part moves since the last flattening of the block forest. This
+     * overload does not write, so concurrent readers may share the tree.
      */
     NodeId getSmallestComponent(PixelId pixelId) const {
-        return properPartOwner_[pixelId];
+        const NodeId ownerId = properPartOwner_[pixelId];
+        if (lazyOwnership_ && ownerId != InvalidNode) {
+            return ownerBlockNode_[findOwnerBlock(ownerId)];
+        }
+        return ownerId;
+    }
+
+    /**
+     * @brief Node that currently owns the given pixel, shortening the block path for later lookups.
+     * @details With lazy ownership, each lookup halves the path it walks, so
+     * repeated lookups, such as those of the update phases of the dual
+     * filter, cost amortized near-constant time.
+     */
+    NodeId getSmallestComponent(PixelId pixelId) {
+        const NodeId ownerId = properPartOwner_[pixelId];
+        if (lazyOwnership_ && ownerId != InvalidNode) {
+            return ownerBlockNode_[compressOwnerBlockPath(ownerId)];
+        }
+        return ownerId;
+    }
+
+    /**
+     * @brief Read-only column view of one field of the packed node records.
+     * @details The view references the live record storage and widens each
+     * field to `Value` on access, so callers keep a column interface even
+     * though the field is interleaved with the other hot node fields.
+     */
+    template<typename Value, auto Field>
+    class NodeFieldView {
+    private:
+        const ChunkedColumn<NodeRecord> *nodes_ = nullptr;
+
+    public:
+        using value_type = Value;
+
+        /**
+         * @brief Forward iterator over the field of consecutive node slots.
+         */
+        class const_iterator {
+        private:
+            const ChunkedColumn<NodeRecord> *nodes_ = nullptr;
+            std::size_t index_ = 0;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Value;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = Value;
+
+            const_iterator() = default;
+            const_iterator(const ChunkedColumn<NodeRecord> *nodes, std::size_t index) : nodes_(nodes), index_(index) {}
+
+            Value operator*() const { return static_cast<Value>((*nodes_)[index_].*Field); }
+            const_iterator &operator++() { ++index_; return *this; }
+            const_iterator operator++(int) { const_iterator previous = *this; ++index_; return previous; }
+            bool operator==(const const_iterator &other) const { return index_ == other.index_; }
+            bool operator!=(const const_iterator &other) const { return index_ != other.index_; }
+        };
+
+        explicit NodeFieldView(const ChunkedColumn<NodeRecord> &nodes) : nodes_(&nodes) {}
+
+        std::size_t size() const { return nodes_->size(); }
+        bool empty() const { return nodes_->empty(); }
+        Value operator[](std::size_t index) const { return static_cast<Value>((*nodes_)[index].*Field); }
+        const_iterator begin() const { return const_iterator(nodes_, 0); }
+        const_iterator end() const { return const_iterator(nodes_, nodes_->size()); }
+
+        /**
+         * @brief Copies the field of every node slot into `out`, which must hold `size()` values.
+         */
+        void copyTo(Value *out) const {
+            nodes_->forEachChunk([&](const NodeRecord *records, std::size_t count) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    *out++ = static_cast<Value>(records[i].*Field);
+                }
+            });
+        }
+    };
+
+    /**
+     * @brief Parent of every node slot, indexed by `NodeId`.
+     * @details The root is its own parent and released slots hold
+     * `InvalidNode`, so the column also encodes node liveness. Like the other
+     * bulk views below, it reads the live storage, so it reflects later
+     * updates and `copyTo` takes a contiguous snapshot.
+     */
+    NodeFieldView<NodeId, &NodeRecord::parent> getNodeParents() const { return NodeFieldView<NodeId, &NodeRecord::parent>(nodes_); }
+
+    /**
+     * @brief Altitude of every node slot, indexed by `NodeId`.
+     */
+    NodeFieldView<NodeAltitude, &NodeRecord::altitude> getAltitudes() const { return NodeFieldView<NodeAltitude, &NodeRecord::altitude>(nodes_); }
+
+    /**
+     * @brief Number of direct proper parts of every node slot, indexed by `NodeId`.
+     */
+    const ChunkedColumn<Index> &getNumProperPartsByNode() const { return numProperPartsByNode_; }
+
+    /**
+     * @brief Node that owns each pixel, indexed by `PixelId`.
+     * @details Only available with eager ownership, where the owner column
+     * holds node ids; throws `std::runtime_error` otherwise.
+     */
+    const ChunkedColumn<Index> &getSmallestComponents() const {
+        if (lazyOwnership_) {
+            throw std::runtime_error("DynamicComponentTree::getSmallestComponents requires eager proper-part ownership.");
+        }
+        return properPartOwner_;
     }
 
     /**
@@ -634,14 +1658,14 @@ public:
      * @brief Returns a range for traversing direct children.
      */
     ChildrenRange getChildren(NodeId nodeId) const {
-        return ChildrenRange(this, firstChild_[nodeId]);
+        return ChildrenRange(this, nodes_[nodeId].firstChild);
     }
 
     /**
      * @brief Returns a range for traversing the node's direct proper parts.
      */
     ProperPartsRange getProperParts(NodeId nodeId) const {
-        return ProperPartsRange(this, properHead_[nodeId]);
+        return ProperPartsRange(this, nodes_[nodeId].properHead);
     }
 
     /**
@@ -700,32 +1724,35 @@ public:
         const PixelId nextPixel = nextProperPart_[pixelId];
 
         if (prevPixel == InvalidNode) {
-            properHead_[sourceNodeId] = nextPixel;
+            writeNode(&NodeRecord::properHead, sourceNodeId, nextPixel);
         } else {
-            nextProperPart_[prevPixel] = nextPixel;
+            writeCell(&BasicDynamicComponentTree::nextProperPart_, prevPixel, nextPixel);
         }
 
         if (nextPixel == InvalidNode) {
-            properTail_[sourceNodeId] = prevPixel;
+            writeCell(&BasicDynamicComponentTree::properTail_, sourceNodeId, prevPixel);
         } else {
-            prevProperPart_[nextPixel] = prevPixel;
+            writeCell(&BasicDynamicComponentTree::prevProperPart_, nextPixel, prevPixel);
         }
 
-        numProperPartsByNode_[sourceNodeId]--;
+        writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, sourceNodeId, numProperPartsByNode_[sourceNodeId] - 1);
 
-        prevProperPart_[pixelId] = properTail_[targetNodeId];
-        nextProperPart_[pixelId] = InvalidNode;
+        writeCell(&BasicDynamicComponentTree::prevProperPart_, pixelId, properTail_[targetNodeId]);
+        writeCell(&BasicDynamicComponentTree::nextProperPart_, pixelId, InvalidNode);
 
         if (numProperPartsByNode_[targetNodeId] == 0) {
-            properHead_[targetNodeId] = pixelId;
-            properTail_[targetNodeId] = pixelId;
-            numProperPartsByNode_[targetNodeId] = 1;
+            writeNode(&NodeRecord::properHead, targetNodeId, pixelId);
+            writeCell(&BasicDynamicComponentTree::properTail_, targetNodeId, pixelId);
+            writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, targetNodeId, 1);
         } else {
-            nextProperPart_[properTail_[targetNodeId]] = pixelId;
-            properTail_[targetNodeId] = pixelId;
-            numProperPartsByNode_[targetNodeId] += 1;
+            writeCell(&BasicDynamicComponentTree::nextProperPart_, properTail_[targetNodeId], pixelId);
+            writeCell(&BasicDynamicComponentTree::properTail_, targetNodeId, pixelId);
+            writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, targetNodeId, numProperPartsByNode_[targetNodeId] + 1);
+        }
+        writeCell(&BasicDynamicComponentTree::properPartOwner_, pixelId, lazyOwnership_ ? nodeOwnerBlock_[targetNodeId] : targetNodeId);
+        if (trackPixelChanges_ && nodes_[targetNodeId].altitude != nodes_[sourceNodeId].altitude) {
+            recordChangedPixel(pixelId);
         }
-        properPartOwner_[pixelId] = targetNodeId;
         properPartVersion_++;
     }
 
@@ -750,10 +1777,10 @@ public:
             unlinkChild(nodeId);
         }
         if (oldRoot != InvalidNode && oldRoot != nodeId && isNode(oldRoot) && isAlive(oldRoot)) {
-            nodeParent_[oldRoot] = getNodeParent(oldRoot);
+            writeNode(&NodeRecord::parent, oldRoot, getNodeParent(oldRoot));
         }
-        rootNodeId_ = nodeId;
-        nodeParent_[nodeId] = nodeId;
+        writeRootId(nodeId);
+        writeNode(&NodeRecord::parent, nodeId, nodeId);
         topologyVersion_++;
     }
 
@@ -766,29 +1793,374 @@ public:
             return InvalidNode;
         }
         const NodeId nodeId = freeNodeIds_.back();
-        freeNodeIds_.pop_back();
-        nodeParent_[nodeId] = nodeId;
-        firstChild_[nodeId] = InvalidNode;
-        lastChild_[nodeId] = InvalidNode;
-        nextSibling_[nodeId] = InvalidNode;
-        prevSibling_[nodeId] = InvalidNode;
-        numChildrenByNode_[nodeId] = 0;
-        properHead_[nodeId] = InvalidNode;
-        properTail_[nodeId] = InvalidNode;
-        numProperPartsByNode_[nodeId] = 0;
-        altitude_[nodeId] = 0;
-        numNodes_++;
+        popFreeNodeId();
+        writeNode(&NodeRecord::parent, nodeId, nodeId);
+        writeNode(&NodeRecord::firstChild, nodeId, InvalidNode);
+        writeNode(&NodeRecord::lastChild, nodeId, InvalidNode);
+        writeNode(&NodeRecord::nextSibling, nodeId, InvalidNode);
+        writeNode(&NodeRecord::prevSibling, nodeId, InvalidNode);
+        writeNode(&NodeRecord::numChildren, nodeId, 0);
+        writeNode(&NodeRecord::properHead, nodeId, InvalidNode);
+        writeCell(&BasicDynamicComponentTree::properTail_, nodeId, InvalidNode);
+        writeCell(&BasicDynamicComponentTree::numProperPartsByNode_, nodeId, 0);
+        writeAltitude(nodeId, 0);
+        addToNumNodes(1);
         nodeStructureVersion_++;
         return nodeId;
     }
 
+    /**
+     * @brief Renumbers the live nodes in breadth-first order and drops the free slots.
+     * @return Map from each old node id to its new id; released slots map to `InvalidNode`.
+     * @details The root becomes node `0` and the children of every node get
+     * consecutive ids, so traversals after many prunes walk dense memory
+     * again. All node-indexed columns are shrunk to the number of live nodes.
+     * This is the only operation that changes the id of a live node: every
+     * node-indexed buffer kept outside the tree must be remapped, for example
+     * with `applyNodeRemap`, and objects sized by the id space must be
+     * resized. The pixel change log is kept, since no pixel changes value,
+     * while the checkpoint is discarded. Costs `O(N + P)`.
+     */
+    std::vector<NodeId> compact() {
+        std::vector<NodeId> newIdOf(nodes_.size(), InvalidNode);
+        std::vector<NodeId> order;
+        order.reserve((std::size_t) numNodes_);
+        if (rootNodeId_ != InvalidNode) {
+            newIdOf[rootNodeId_] = 0;
+            order.push_back(rootNodeId_);
+            for (std::size_t head = 0; head < order.size(); ++head) {
+                for (NodeId childId = nodes_[order[head]].firstChild; childId != InvalidNode; childId = nodes_[childId].nextSibling) {
+                    newIdOf[childId] = (NodeId) order.size();
+                    order.push_back(childId);
+                }
+            }
+        }
+        assert((int) order.size() == numNodes_);
+
+        auto gather = [&](ChunkedColumn<Index> &column) {
+            ChunkedColumn<Index> compacted;
+            compacted.resize(order.size());
+            for (std::size_t newId = 0; newId < order.size(); ++newId) {
+                compacted.set(newId, column[order[newId]]);
+            }
+            column = std::move(compacted);
+        };
+        const auto newIdOrNone = [&](Index nodeId) {
+            return (Index) (nodeId == InvalidNode ? InvalidNode : newIdOf[nodeId]);
+        };
+        ChunkedColumn<NodeRecord> compactedNodes;
+        compactedNodes.resize(order.size());
+        for (std::size_t newId = 0; newId < order.size(); ++newId) {
+            NodeRecord record = nodes_[order[newId]];
+            record.parent = newIdOrNone(record.parent);
+            record.firstChild = newIdOrNone(record.firstChild);
+            record.lastChild = newIdOrNone(record.lastChild);
+            record.nextSibling = newIdOrNone(record.nextSibling);
+            record.prevSibling = newIdOrNone(record.prevSibling);
+            compactedNodes.set(newId, record);
+        }
+        nodes_ = std::move(compactedNodes);
+        gather(properTail_);
+        gather(numProperPartsByNode_);
+        if (lazyOwnership_) {
+            flattenOwnerBlocks();
+        }
+        for (std::size_t pixelId = 0; pixelId < properPartOwner_.size(); ++pixelId) {
+            const NodeId ownerId = properPartOwner_[pixelId];
+            if (ownerId != InvalidNode) {
+                properPartOwner_.set(pixelId, (Index) newIdOf[ownerId]);
+            }
+        }
+        if (lazyOwnership_) {
+            resetOwnerBlocks();
+        }
+        std::vector<Index>().swap(freeNodeIds_);
+        rootNodeId_ = order.empty() ? InvalidNode : 0;
+
+        journaling_ = false;
+        journal_.clear();
+        nodeStructureVersion_++;
+        topologyVersion_++;
+        properPartVersion_++;
+        return newIdOf;
+    }
+
+    /**
+     * @brief Moves the entries of a node-indexed buffer to the ids assigned by `compact`.
+     * @param newIdOf Map returned by `compact`.
+     * @param values Buffer indexed by the old ids; on return it is indexed by
+     * the new ids and has one entry per live node.
+     */
+    template<typename T>
+    static void applyNodeRemap(const std::vector<NodeId> &newIdOf, std::vector<T> &values) {
+        assert(values.size() >= newIdOf.size());
+        std::size_t numLive = 0;
+        for (NodeId newId : newIdOf) {
+            numLive += newId != InvalidNode ? 1 : 0;
+        }
+        std::vector<T> remapped(numLive);
+        for (std::size_t oldId = 0; oldId < newIdOf.size(); ++oldId) {
+            if (newIdOf[oldId] != InvalidNode) {
+                remapped[(std::size_t) newIdOf[oldId]] = std::move(values[oldId]);
+            }
+        }
+        values.swap(remapped);
+    }
+
+    /**
+     * @brief Relinks every proper-part list in increasing pixel order.
+     * @details Moves and merges splice lists together, so after many updates
+     * walking the proper parts of a node jumps between distant pixel ids.
+     * Relinking restores increasing ids within each list, which turns those
+     * walks into forward scans of the pixel-indexed columns. Owners, counts,
+     * and the represented image are unchanged; only list order is affected,
+     * and the checkpoint is discarded. One sequential pass, `O(N + P)`.
+     */
+    void relayoutProperParts() {
+        for (std::size_t nodeId = 0; nodeId < nodes_.size(); ++nodeId) {
+            nodes_.mutableAt(nodeId).properHead = InvalidNode;
+        }
+        properTail_.assign(properTail_.size(), InvalidNode);
+        for (PixelId pixelId = 0; pixelId < (PixelId) properPartOwner_.size(); ++pixelId) {
+            const NodeId ownerId = getSmallestComponent(pixelId);
+            if (ownerId == InvalidNode) {
+                // A pixel without an owner stays out of every list.
+                nextProperPart_.set(pixelId, InvalidNode);
+                prevProperPart_.set(pixelId, InvalidNode);
+                continue;
+            }
+            const PixelId tail = properTail_[ownerId];
+            if (tail == InvalidNode) {
+                nodes_.mutableAt(ownerId).properHead = (Index) pixelId;
+            } else {
+                nextProperPart_.set(tail, (Index) pixelId);
+            }
+            prevProperPart_.set(pixelId, (Index) tail);
+            properTail_.set(ownerId, (Index) pixelId);
+        }
+        for (PixelId tail : properTail_) {
+            if (tail != InvalidNode) {
+                nextProperPart_.set(tail, InvalidNode);
+            }
+        }
+
+        journaling_ = false;
+        journal_.clear();
+        properPartVersion_++;
+    }
+
+    /**
+     * @brief Writes the tree to a versioned binary snapshot.
+     * @details The snapshot holds the image metadata, the adjacency stencil,
+     * the root, the free-id pool, and every backend column in its in-memory
+     * layout, so `readSnapshot` restores the tree with one bulk read per
+     * column instead of a rebuild. The change log and the checkpoint are not
+     * saved.
+     */
+    void writeSnapshot(std::ostream &out) const {
+        SnapshotIO::writeHeader(out, SnapshotMagic, SnapshotVersion);
+        SnapshotIO::write(out, (int32_t) numRows_);
+        SnapshotIO::write(out, (int32_t) numCols_);
+        SnapshotIO::write(out, (int32_t) isMaxtree_);
+        SnapshotIO::write(out, (int32_t) imageBitDepth_);
+        SnapshotIO::write(out, (int32_t) rootNodeId_);
+        SnapshotIO::write(out, (int32_t) numNodes_);
+        SnapshotIO::write(out, (uint64_t) nodes_.size());
+        SnapshotIO::write(out, adj_ ? adj_->getRadius() : -1.0);
+        std::vector<int32_t> offsets;
+        for (int i = 0; adj_ && i < adj_->getSize(); ++i) {
+            offsets.push_back(adj_->getOffsetRow(i));
+            offsets.push_back(adj_->getOffsetCol(i));
+        }
+        SnapshotIO::writeVector(out, offsets);
+
+        // The on-disk columns keep 32-bit ids whatever `Index` is, so files
+        // move freely between index widths that can hold the image.
+        const auto field = [](auto member) { return [member](const NodeRecord &record) { return record.*member; }; };
+        const auto id = [](Index value) { return value; };
+        SnapshotIO::writeColumn<NodeAltitude>(out, nodes_, field(&NodeRecord::altitude));
+        SnapshotIO::writeVector(out, std::vector<NodeId>(freeNodeIds_.begin(), freeNodeIds_.end()));
+        SnapshotIO::writeColumn<NodeId>(out, nodes_, field(&NodeRecord::parent));
+        SnapshotIO::writeColumn<NodeId>(out, nodes_, field(&NodeRecord::firstChild));
+        SnapshotIO::writeColumn<NodeId>(out, nodes_, field(&NodeRecord::lastChild));
+        SnapshotIO::writeColumn<NodeId>(out, nodes_, field(&NodeRecord::nextSibling));
+        SnapshotIO::writeColumn<NodeId>(out, nodes_, field(&NodeRecord::prevSibling));
+        SnapshotIO::writeColumn<NodeId>(out, nodes_, field(&NodeRecord::numChildren));
+        SnapshotIO::writeColumn<NodeId>(out, nodes_, field(&NodeRecord::properHead));
+        SnapshotIO::writeColumn<NodeId>(out, properTail_, id);
+        SnapshotIO::writeColumn<NodeId>(out, numProperPartsByNode_, id);
+        if (lazyOwnership_) {
+            std::vector<NodeId> owners(properPartOwner_.size());
+            for (PixelId pixelId = 0; pixelId < (PixelId) owners.size(); ++pixelId) {
+                owners[pixelId] = getSmallestComponent(pixelId);
+            }
+            SnapshotIO::writeVector(out, owners);
+        } else {
+            SnapshotIO::writeColumn<NodeId>(out, properPartOwner_, id);
+        }
+        SnapshotIO::writeColumn<NodeId>(out, nextProperPart_, id);
+        SnapshotIO::writeColumn<NodeId>(out, prevProperPart_, id);
+        if (!out) {
+            throw std::runtime_error("DynamicComponentTree snapshot could not be written.");
+        }
+    }
+
+    /**
+     * @brief Replaces this tree with one read from a snapshot written by `writeSnapshot`.
+     * @param adj Adjacency to attach to the tree. When null, a relation is
+     * rebuilt from the stored stencil; when given, it must match the stored
+     * image shape, which lets the two trees of a pair share one relation.
+     * @details Like a build, loading discards the checkpoint and, when the
+     * change log is enabled, marks the whole image as changed. The file is
+     * untrusted: header counts are bounded by the image size before any
+     * allocation, and every stored id and list is checked, so a corrupt or
+     * tampered file throws `std::runtime_error` and leaves this tree as it was.
+     */
+    void readSnapshot(std::istream &in, AdjacencyRelationPtr adj = nullptr) {
+        constexpr const char *what = "DynamicComponentTree";
+        SnapshotIO::readHeader(in, SnapshotMagic, SnapshotVersion, what);
+        int32_t numRows = 0, numCols = 0, isMaxtree = 0, imageBitDepth = 0, rootNodeId = 0, numNodes = 0;
+        uint64_t numSlots = 0;
+        double radius = -1.0;
+        SnapshotIO::read(in, numRows, what);
+        SnapshotIO::read(in, numCols, what);
+        SnapshotIO::read(in, isMaxtree, what);
+        SnapshotIO::read(in, imageBitDepth, what);
+        SnapshotIO::read(in, rootNodeId, what);
+        SnapshotIO::read(in, numNodes, what);
+        SnapshotIO::read(in, numSlots, what);
+        SnapshotIO::read(in, radius, what);
+        // Every count that sizes an allocation is bounded by the image size
+        // before anything is allocated: a tree never has more node slots
+        // than pixels, and a stencil never more offsets than the image has
+        // displacements.
+        const uint64_t numPixelsInHeader = (uint64_t) std::max(0, numRows) * (uint64_t) std::max(0, numCols);
+        if (numRows < 0 || numCols < 0 || numPixelsInHeader > (uint64_t) std::numeric_limits<PixelId>::max() ||
+            (isMaxtree != 0 && isMaxtree != 1) || (imageBitDepth != 8 && imageBitDepth != 16) ||
+            numSlots > numPixelsInHeader || numNodes < 0 || (uint64_t) numNodes > numSlots ||
+            rootNodeId < InvalidNode || rootNodeId >= (int64_t) numSlots || !(radius < 0.0 || radius <= std::hypot((double) numRows, (double) numCols))) {
+            throw std::runtime_error("DynamicComponentTree snapshot has an inconsistent header.");
+        }
+        if ((int64_t) numPixelsInHeader > MaxNumPixels) {
+            throw std::runtime_error("DynamicComponentTree index type is too narrow for an image of this size.");
+        }
+        uint64_t numOffsetValues = 0;
+        SnapshotIO::read(in, numOffsetValues, what);
+        const uint64_t maxOffsetValues = 2 * (2 * (uint64_t) numRows + 1) * (2 * (uint64_t) numCols + 1);
+        if (numOffsetValues % 2 != 0 || numOffsetValues > maxOffsetValues) {
+            throw std::runtime_error("DynamicComponentTree snapshot has an invalid adjacency stencil.");
+        }
+        std::vector<int32_t> offsets((std::size_t) numOffsetValues);
+        if (!in.read(reinterpret_cast<char *>(offsets.data()), (std::streamsize) (offsets.size() * sizeof(int32_t)))) {
+            throw std::runtime_error("DynamicComponentTree snapshot has an invalid adjacency stencil.");
+        }
+        if (adj == nullptr) {
+            if (radius >= 0.0) {
+                adj = std::make_shared<AdjacencyRelation>(numRows, numCols, radius);
+            } else {
+                std::vector<AdjacencyRelation::Offset> stencil;
+                for (std::size_t i = 0; i < offsets.size(); i += 2) {
+                    if (std::abs(offsets[i]) > numRows || std::abs(offsets[i + 1]) > numCols) {
+                        throw std::runtime_error("DynamicComponentTree snapshot has an invalid adjacency stencil.");
+                    }
+                    stencil.emplace_back(offsets[i], offsets[i + 1]);
+                }
+                adj = std::make_shared<AdjacencyRelation>(numRows, numCols, stencil);
+            }
+        } else if (adj->getNumRows() != numRows || adj->getNumCols() != numCols) {
+            throw std::runtime_error("DynamicComponentTree snapshot does not match the shape of the given adjacency.");
+        }
+
+        // Columns are read into a scratch tree so that a failed load leaves
+        // this tree untouched.
+        BasicDynamicComponentTree loaded;
+        const std::size_t numPixels = (std::size_t) numRows * (std::size_t) numCols;
+        const std::size_t slots = (std::size_t) numSlots;
+        loaded.nodes_.assign(slots, EmptyNodeRecord);
+        const auto field = [](auto member) {
+            return [member](auto stored, NodeRecord &record) {
+                record.*member = static_cast<std::remove_reference_t<decltype(record.*member)>>(stored);
+                return stored == static_cast<decltype(stored)>(record.*member);
+            };
+        };
+        const auto id = [](NodeId stored, Index &value) {
+            value = (Index) stored;
+            return stored == (NodeId) value;
+        };
+        SnapshotIO::readColumn<NodeAltitude>(in, loaded.nodes_, what, field(&NodeRecord::altitude));
+        uint64_t numFree = 0;
+        SnapshotIO::read(in, numFree, what);
+        if (numFree > numSlots || numFree + (uint64_t) numNodes != numSlots) {
+            throw std::runtime_error("DynamicComponentTree snapshot has an inconsistent free-id pool.");
+        }
+        std::vector<NodeId> freeNodeIds((std::size_t) numFree);
+        if (!in.read(reinterpret_cast<char *>(freeNodeIds.data()), (std::streamsize) (freeNodeIds.size() * sizeof(NodeId)))) {
+            throw std::runtime_error("DynamicComponentTree snapshot is truncated.");
+        }
+        loaded.freeNodeIds_.reserve(freeNodeIds.size());
+        for (NodeId nodeId : freeNodeIds) {
+            if (nodeId != (Index) nodeId) {
+                throw std::runtime_error("DynamicComponentTree snapshot has a value out of range.");
+            }
+            loaded.freeNodeIds_.push_back((Index) nodeId);
+        }
+        SnapshotIO::readColumn<NodeId>(in, loaded.nodes_, what, field(&NodeRecord::parent));
+        SnapshotIO::readColumn<NodeId>(in, loaded.nodes_, what, field(&NodeRecord::firstChild));
+        SnapshotIO::readColumn<NodeId>(in, loaded.nodes_, what, field(&NodeRecord::lastChild));
+        SnapshotIO::readColumn<NodeId>(in, loaded.nodes_, what, field(&NodeRecord::nextSibling));
+        SnapshotIO::readColumn<NodeId>(in, loaded.nodes_, what, field(&NodeRecord::prevSibling));
+        SnapshotIO::readColumn<NodeId>(in, loaded.nodes_, what, field(&NodeRecord::numChildren));
+        SnapshotIO::readColumn<NodeId>(in, loaded.nodes_, what, field(&NodeRecord::properHead));
+        loaded.properTail_.resize(slots);
+        loaded.numProperPartsByNode_.resize(slots);
+        loaded.properPartOwner_.resize(numPixels);
+        loaded.nextProperPart_.resize(numPixels);
+        loaded.prevProperPart_.resize(numPixels);
+        SnapshotIO::readColumn<NodeId>(in, loaded.properTail_, what, id);
+        SnapshotIO::readColumn<NodeId>(in, loaded.numProperPartsByNode_, what, id);
+        SnapshotIO::readColumn<NodeId>(in, loaded.properPartOwner_, what, id);
+        SnapshotIO::readColumn<NodeId>(in, loaded.nextProperPart_, what, id);
+        SnapshotIO::readColumn<NodeId>(in, loaded.prevProperPart_, what, id);
+        loaded.imageBitDepth_ = imageBitDepth;
+        loaded.rootNodeId_ = rootNodeId;
+        loaded.numNodes_ = numNodes;
+        loaded.requireConsistentSnapshotColumns();
+
+        nodes_ = std::move(loaded.nodes_);
+        freeNodeIds_ = std::move(loaded.freeNodeIds_);
+        properTail_ = std::move(loaded.properTail_);
+        numProperPartsByNode_ = std::move(loaded.numProperPartsByNode_);
+        properPartOwner_ = std::move(loaded.properPartOwner_);
+        nextProperPart_ = std::move(loaded.nextProperPart_);
+        prevProperPart_ = std::move(loaded.prevProperPart_);
+
+        adj_ = std::move(adj);
+        numRows_ = numRows;
+        numCols_ = numCols;
+        isMaxtree_ = isMaxtree != 0;
+        imageBitDepth_ = imageBitDepth;
+        rootNodeId_ = rootNodeId;
+        numNodes_ = numNodes;
+        nodeStructureVersion_ = 0;
+        topologyVersion_ = 0;
+        properPartVersion_ = 0;
+        if (trackPixelChanges_) {
+            resetChangedPixels(true);
+        }
+        if (lazyOwnership_) {
+            resetOwnerBlocks();
+        }
+        journaling_ = false;
+        journal_.clear();
+    }
+
     /**
      * @brief Releases an isolated node with no children and no proper parts.
      */
     void releaseNode(NodeId nodeId) {
         assert(isAlive(nodeId));
         assert(getNodeParent(nodeId) == nodeId);
-        assert(firstChild_[nodeId] == InvalidNode);
+        assert(nodes_[nodeId].firstChild == InvalidNode);
         assert(numProperPartsByNode_[nodeId] == 0);
         releaseNodeSlot(nodeId);
         nodeStructureVersion_++;
@@ -810,7 +2182,7 @@ public:
             releaseNodeSlot(childId);
             nodeStructureVersion_++;
         } else {
-            nodeParent_[childId] = childId;
+            writeNode(&NodeRecord::parent, childId, childId);
         }
         topologyVersion_++;
     }
@@ -820,7 +2192,7 @@ public:
      */
     void attachNode(NodeId parentId, NodeId nodeId) {
         linkChildBack(parentId, nodeId);
-        nodeParent_[nodeId] = parentId;
+        writeNode(&NodeRecord::parent, nodeId, parentId);
         topologyVersion_++;
     }
 
@@ -829,7 +2201,7 @@ public:
      */
     void detachNode(NodeId nodeId) {
         unlinkChild(nodeId);
-        nodeParent_[nodeId] = nodeId;
+        writeNode(&NodeRecord::parent, nodeId, nodeId);
         topologyVersion_++;
     }
 
@@ -842,7 +2214,7 @@ public:
             unlinkChild(nodeId);
             linkChildBack(newParentId, nodeId);
         }
-        nodeParent_[nodeId] = newParentId;
+        writeNode(&NodeRecord::parent, nodeId, newParentId);
         topologyVersion_++;
     }
 
@@ -852,33 +2224,33 @@ public:
      * The relative order of the moved children is preserved in the final linkage.
      */
     void moveChildren(NodeId parentId, NodeId sourceId) {
-        const NodeId firstChildId = firstChild_[sourceId];
+        const NodeId firstChildId = nodes_[sourceId].firstChild;
         if (firstChildId == InvalidNode) {
             return;
         }
 
-        const NodeId lastChildId = lastChild_[sourceId];
-        const int movedCount = numChildrenByNode_[sourceId];
-        const NodeId tail = lastChild_[parentId];
+        const NodeId lastChildId = nodes_[sourceId].lastChild;
+        const int movedCount = nodes_[sourceId].numChildren;
+        const NodeId tail = nodes_[parentId].lastChild;
 
-        firstChild_[sourceId] = InvalidNode;
-        lastChild_[sourceId] = InvalidNode;
-        numChildrenByNode_[sourceId] = 0;
-        prevSibling_[firstChildId] = InvalidNode;
-        nextSibling_[lastChildId] = InvalidNode;
+        writeNode(&NodeRecord::firstChild, sourceId, InvalidNode);
+        writeNode(&NodeRecord::lastChild, sourceId, InvalidNode);
+        writeNode(&NodeRecord::numChildren, sourceId, 0);
+        writeNode(&NodeRecord::prevSibling, firstChildId, InvalidNode);
+        writeNode(&NodeRecord::nextSibling, lastChildId, InvalidNode);
 
         if (tail == InvalidNode) {
-            firstChild_[parentId] = firstChildId;
-            lastChild_[parentId] = lastChildId;
+            writeNode(&NodeRecord::firstChild, parentId, firstChildId);
+            writeNode(&NodeRecord::lastChild, parentId, lastChildId);
         } else {
-            nextSibling_[tail] = firstChildId;
-            prevSibling_[firstChildId] = tail;
-            lastChild_[parentId] = lastChildId;
+            writeNode(&NodeRecord::nextSibling, tail, firstChildId);
+            writeNode(&NodeRecord::prevSibling, firstChildId, tail);
+            writeNode(&NodeRecord::lastChild, parentId, lastChildId);
         }
-        numChildrenByNode_[parentId] += movedCount;
+        writeNode(&NodeRecord::numChildren, parentId, nodes_[parentId].numChildren + movedCount);
 
-        for (NodeId childId = firstChildId; childId != InvalidNode; childId = nextSibling_[childId]) {
-            nodeParent_[childId] = parentId;
+        for (NodeId childId = firstChildId; childId != InvalidNode; childId = nodes_[childId].nextSibling) {
+            writeNode(&NodeRecord::parent, childId, parentId);
         }
         topologyVersion_++;
     }
@@ -894,7 +2266,7 @@ public:
         auto descendToDeepestLastChild = [this](NodeId startId) {
             NodeId currentId = startId;
             while (!isLeaf(currentId)) {
-                currentId = lastChild_[currentId];
+                currentId = nodes_[currentId].lastChild;
             }
             return currentId;
         };
@@ -939,21 +2311,240 @@ public:
 
     /**
      * @brief Reconstructs the current image from the dynamic hierarchy.
+     * @tparam PixelType Pixel type of the returned image; must hold every altitude.
+     */
+    template<typename PixelType = AltitudeType>
+    ImagePtr<PixelType> reconstructionImage() const {
+        auto image = Image<PixelType>::create(numRows_, numCols_);
+        reconstructionImage(*image);
+        return image;
+    }
+
+    /**
+     * @brief Writes the current image into an existing image of the same size.
      */
-    ImageUInt8Ptr reconstructionImage() const {
-        auto image = ImageUInt8::create(numRows_, numCols_, 0);
-        auto *data = image->rawData();
+    template<typename PixelType>
+    void reconstructionImage(Image<PixelType> &image) const {
+        assert(image.getNumRows() == numRows_ && image.getNumCols() == numCols_);
+        auto *data = image.rawData();
+        if (lazyOwnership_) {
+            // Walking the proper-part lists avoids resolving every owner;
+            // pixels in no list read 0, as in the eager path.
+            std::fill_n(data, getNumTotalProperParts(), PixelType{0});
+            for (NodeId nodeId = 0; nodeId < getNumInternalNodeSlots(); ++nodeId) {
+                for (PixelId pixelId = nodes_[nodeId].properHead; pixelId != InvalidNode; pixelId = nextProperPart_[pixelId]) {
+                    data[pixelId] = static_cast<PixelType>(nodes_[nodeId].altitude);
+                }
+            }
+            return;
+        }
         for (PixelId pixelId = 0; pixelId < getNumTotalProperParts(); ++pixelId) {
             const NodeId ownerId = properPartOwner_[pixelId];
-            if (ownerId == InvalidNode) {
-                continue;
+            data[pixelId] = ownerId == InvalidNode ? PixelType{0} : static_cast<PixelType>(nodes_[ownerId].altitude);
+        }
+    }
+
+    /**
+     * @brief Starts recording an undo journal from the current state.
+     * @details Every later edit through the public mutation API logs the
+     * previous value of each backend cell it overwrites, so
+     * `rollbackToCheckpoint` costs time proportional to the edits made since
+     * this call rather than to the tree size. Calling it again discards the
+     * journal and moves the checkpoint to the current state. A build
+     * discards the checkpoint. Under lazy ownership the block forest is not
+     * flattened while the checkpoint is active, so it grows by one block per
+     * `moveProperParts` until the checkpoint is rolled back or cleared.
+     */
+    void setCheckpoint() {
+        journal_.clear();
+        journaling_ = true;
+        checkpointNumOwnerBlocks_ = ownerBlockParent_.size();
+    }
+
+    /**
+     * @brief Restores the state saved by the last `setCheckpoint`.
+     * @details The checkpoint stays active with an empty journal, so the
+     * same state can be restored again after further edits. Node ids are
+     * restored too, including the order of the free-id pool, and ownership
+     * blocks appended since the checkpoint are released. Restored pixels
+     * are reported to the change log when it is enabled.
+     */
+    void rollbackToCheckpoint() {
+        if (!journaling_) {
+            throw std::runtime_error("DynamicComponentTree::rollbackToCheckpoint requires an active checkpoint.");
+        }
+        for (auto it = journal_.rbegin(); it != journal_.rend(); ++it) {
+            switch (it->op) {
+                case JournalOp::Cell:
+                    (this->*(it->column)).set(it->index, (Index) it->oldValue);
+                    if (trackPixelChanges_ && it->column == &BasicDynamicComponentTree::properPartOwner_) {
+                        recordChangedPixel(it->index);
+                    }
+                    break;
+                case JournalOp::NodeField:
+                    nodes_.mutableAt(it->index).*(it->field) = (Index) it->oldValue;
+                    break;
+                case JournalOp::Altitude:
+                    nodes_.mutableAt(it->index).altitude = (NodeAltitude) it->oldValue;
+                    break;
+                case JournalOp::Root:
+                    rootNodeId_ = it->oldValue;
+                    break;
+                case JournalOp::NumNodes:
+                    numNodes_ = it->oldValue;
+                    break;
+                case JournalOp::PushFreeNode:
+                    freeNodeIds_.pop_back();
+                    break;
+                case JournalOp::PopFreeNode:
+                    freeNodeIds_.push_back((Index) it->oldValue);
+                    break;
             }
-            data[pixelId] = static_cast<uint8_t>(altitude_[ownerId]);
         }
-        return image;
+        journal_.clear();
+        if (lazyOwnership_) {
+            ownerBlockParent_.resize(checkpointNumOwnerBlocks_);
+            ownerBlockRank_.resize(checkpointNumOwnerBlocks_);
+            ownerBlockNode_.resize(checkpointNumOwnerBlocks_);
+        }
+        topologyVersion_++;
+        nodeStructureVersion_++;
+        properPartVersion_++;
+    }
+
+    /**
+     * @brief Stops recording and drops the journal, keeping the current state.
+     */
+    void clearCheckpoint() {
+        journaling_ = false;
+        journal_.clear();
+    }
+
+    bool hasCheckpoint() const { return journaling_; }
+
+    /**
+     * @brief Number of undo entries recorded since the last checkpoint.
+     */
+    std::size_t getJournalSize() const { return journal_.size(); }
+
+    /**
+     * @brief Heap bytes held by the tree, counted from the vector capacities and column chunks.
+     * @details This reports the current footprint; it is not a bound. The
+     * columns hold `3 * sizeof(Index)` bytes per pixel (owner and the two
+     * proper-part links) and `10 * sizeof(Index)` per node slot (the record,
+     * the proper-part tail and count), rounded up to whole chunks, plus up to
+     * `sizeof(Index)` per slot for the free-id pool; see the class notes for
+     * the resulting bytes-per-pixel target. Chunks shared with a copy of the tree are counted in
+     * full; see `getExclusiveMemoryUsage`. The optional change log, the undo
+     * journal and the lazy-ownership tables are counted while they hold memory.
+     */
+    std::size_t getMemoryUsage() const {
+        auto bytesOf = []<typename T>(const std::vector<T> &column) {
+            return column.capacity() * sizeof(T);
+        };
+        return forEachColumnSum([](const auto &column) { return column.getMemoryUsage(); }) +
+               bytesOf(freeNodeIds_) + bytesOf(changedPixels_) + bytesOf(changedPixelMarks_.stamp) + bytesOf(journal_);
+    }
+
+    /**
+     * @brief Bytes of column chunks that no copy of the tree shares.
+     * @details A copy starts at zero and grows by one chunk per column chunk
+     * it writes to, which is what a branch pays for its changes.
+     */
+    std::size_t getExclusiveMemoryUsage() const {
+        return forEachColumnSum([](const auto &column) { return column.getOwnedMemoryUsage(); });
+    }
+
+    /**
+     * @brief Switches between eager and lazy proper-part ownership.
+     * @details Eager ownership, the default, stores the owning node of every
+     * pixel, so moving all proper parts of a node costs one write per moved
+     * pixel. Lazy ownership resolves owners through a union-find forest of
+     * ownership blocks: such moves become an `O(1)` union, which pays off when
+     * large regions are merged repeatedly, at the price of a
+     * `getSmallestComponent` that walks the forest: logarithmic on a const
+     * tree, amortized near-constant through the non-const overload, which
+     * compresses paths. Moves between nodes of different altitudes still
+     * visit their pixels while the change log is enabled. Switching modes
+     * costs `O(N + P)` and discards the checkpoint. Block ids are not bounded
+     * by the pixel count, so lazy ownership requires a full-width `Index`.
+     */
+    void setLazyProperPartOwnership(bool enabled) {
+        if (enabled == lazyOwnership_) {
+            return;
+        }
+        if (enabled && sizeof(Index) < sizeof(NodeId)) {
+            throw std::runtime_error("DynamicComponentTree lazy proper-part ownership requires a 32-bit index type.");
+        }
+        if (enabled) {
+            resetOwnerBlocks();
+        } else {
+            flattenOwnerBlocks();
+            ownerBlockParent_.clear();
+            ownerBlockRank_.clear();
+            ownerBlockNode_.clear();
+            nodeOwnerBlock_.clear();
+        }
+        lazyOwnership_ = enabled;
+        journaling_ = false;
+        journal_.clear();
+    }
+
+    bool isLazyProperPartOwnership() const { return lazyOwnership_; }
+
+    /**
+     * @brief Enables or disables the log of pixels whose reconstructed value changes.
+     * @details While enabled, `moveProperPart`, `moveProperParts`, `pruneNode`
+     * and `mergeNodeIntoParent` record every pixel that moves between nodes of
+     * different altitudes. A build, or enabling the log, marks the whole image
+     * as changed because there is no previous reconstruction to patch.
+     */
+    void setTrackPixelChanges(bool enabled) {
+        trackPixelChanges_ = enabled;
+        if (enabled) {
+            resetChangedPixels(true);
+        } else {
+            changedPixels_.clear();
+            changedPixelMarks_ = GenerationStampSet();
+        }
+    }
+
+    bool isTrackingPixelChanges() const { return trackPixelChanges_; }
+
+    /**
+     * @brief Pixels recorded since the last `updateReconstructionImage`, each listed once.
+     * @details Meaningless when `hasFullImageChange()` is true.
+     */
+    std::span<const PixelId> getChangedPixels() const { return changedPixels_; }
+
+    /**
+     * @brief Tests whether the next incremental update must rewrite every pixel.
+     */
+    bool hasFullImageChange() const { return allPixelsChanged_; }
+
+    /**
+     * @brief Brings `image` up to date by rewriting only the pixels that changed.
+     * @details `image` must hold the result of the previous update (or of a
+     * full reconstruction made right after it); the first call after a build
+     * or after enabling the log rewrites the whole image. The change log is
+     * cleared afterwards, so the cost of a call is proportional to the region
+     * edited since the previous one. Requires `setTrackPixelChanges(true)`.
+     */
+    template<typename PixelType>
+    void updateReconstructionImage(Image<PixelType> &image) {
+        assert(trackPixelChanges_);
+        if (allPixelsChanged_) {
+            reconstructionImage(image);
+        } else {
+            auto *data = image.rawData();
+            for (PixelId pixelId : changedPixels_) {
+                data[pixelId] = static_cast<PixelType>(nodes_[getSmallestComponent(pixelId)].altitude);
+            }
+        }
+        resetChangedPixels(false);
     }
 
-    static std::vector<NodeId> getNodesThreshold(DynamicComponentTree *tree,
+    static std::vector<NodeId> getNodesThreshold(BasicDynamicComponentTree *tree,
                                                  int areaThreshold,
                                                  bool enableLog = false) {
         std::vector<NodeId> nodes;
@@ -961,19 +2552,21 @@ public:
             return nodes;
         }
 
-        auto computeArea = [&](auto &&self, NodeId nodeId) -> int {
-            int area = tree->getNumProperParts(nodeId);
-            for (NodeId childId : tree->getChildren(nodeId)) {
-                area += self(self, childId);
+        std::vector<NodeId> order;
+        tree->collectBreadthFirstOrder(tree->getRoot(), order);
+        std::vector<int> area((std::size_t) tree->getNumInternalNodeSlots(), 0);
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            area[*it] += tree->getNumProperParts(*it);
+            if (*it != tree->getRoot()) {
+                area[tree->getNodeParent(*it)] += area[*it];
             }
-            return area;
-        };
+        }
 
         FastQueue<NodeId> queue;
         queue.push(tree->getRoot());
         while (!queue.empty()) {
             const NodeId nodeId = queue.pop();
-            if (computeArea(computeArea, nodeId) > areaThreshold) {
+            if (area[nodeId] > areaThreshold) {
                 for (NodeId childId : tree->getChildren(nodeId)) {
                     queue.push(childId);
                 }
@@ -999,7 +2592,7 @@ public:
      */
     class ChildrenRange {
     private:
-        const DynamicComponentTree *tree_ = nullptr;
+        const BasicDynamicComponentTree *tree_ = nullptr;
         NodeId firstChildId_ = InvalidNode;
 
     public:
@@ -1010,16 +2603,16 @@ public:
          */
         class iterator {
         private:
-            const DynamicComponentTree *tree_ = nullptr;
+            const BasicDynamicComponentTree *tree_ = nullptr;
             NodeId currentChildId_ = InvalidNode;
 
         public:
-            iterator(const DynamicComponentTree *tree, NodeId currentChildId) : tree_(tree), currentChildId_(currentChildId) {}
+            iterator(const BasicDynamicComponentTree *tree, NodeId currentChildId) : tree_(tree), currentChildId_(currentChildId) {}
 
             NodeId operator*() const { return currentChildId_; }
 
             iterator &operator++() {
-                currentChildId_ = (currentChildId_ == InvalidNode) ? InvalidNode : tree_->nextSibling_[currentChildId_];
+                currentChildId_ = (currentChildId_ == InvalidNode) ? InvalidNode : tree_->nodes_[currentChildId_].nextSibling;
                 return *this;
             }
 
@@ -1028,7 +2621,7 @@ public:
             }
         };
 
-        ChildrenRange(const DynamicComponentTree *tree, NodeId firstChildId) : tree_(tree), firstChildId_(firstChildId) {}
+        ChildrenRange(const BasicDynamicComponentTree *tree, NodeId firstChildId) : tree_(tree), firstChildId_(firstChildId) {}
 
         iterator begin() const { return iterator(tree_, firstChildId_); }
         iterator end() const { return iterator(tree_, InvalidNode); }
@@ -1042,7 +2635,7 @@ public:
      */
     class ProperPartsRange {
     private:
-        const DynamicComponentTree *tree_ = nullptr;
+        const BasicDynamicComponentTree *tree_ = nullptr;
         PixelId firstPixelId_ = InvalidNode;
 
     public:
@@ -1053,11 +2646,11 @@ public:
          */
         class iterator {
         private:
-            const DynamicComponentTree *tree_ = nullptr;
+            const BasicDynamicComponentTree *tree_ = nullptr;
             PixelId currentPixelId_ = InvalidNode;
 
         public:
-            iterator(const DynamicComponentTree *tree, PixelId currentPixelId) : tree_(tree), currentPixelId_(currentPixelId) {}
+            iterator(const BasicDynamicComponentTree *tree, PixelId currentPixelId) : tree_(tree), currentPixelId_(currentPixelId) {}
 
             PixelId operator*() const { return currentPixelId_; }
 
@@ -1071,7 +2664,7 @@ public:
             }
         };
 
-        ProperPartsRange(const DynamicComponentTree *tree, PixelId firstPixelId) : tree_(tree), firstPixelId_(firstPixelId) {}
+        ProperPartsRange(const BasicDynamicComponentTree *tree, PixelId firstPixelId) : tree_(tree), firstPixelId_(firstPixelId) {}
 
         iterator begin() const { return iterator(tree_, firstPixelId_); }
         iterator end() const { return iterator(tree_, InvalidNode); }
@@ -1080,45 +2673,53 @@ public:
     /**
      * @brief Range for depth-first traversal of a subtree.
      *
-     * The subtree root is included in the traversal. Children are pushed in
-     * reverse order to preserve the natural linkage order when visiting.
+     * The subtree root is included in the traversal and children are visited
+     * in their linkage order. The iterator is stackless: it walks the
+     * `firstChild`/`nextSibling`/`parent` record links, so a traversal does no
+     * heap allocation and several traversals may run concurrently on a const
+     * tree. The subtree must not be edited while it is being traversed.
      */
     class SubtreeNodeRange {
     private:
-        const DynamicComponentTree *tree_ = nullptr;
+        const BasicDynamicComponentTree *tree_ = nullptr;
         NodeId rootNodeId_ = InvalidNode;
 
     public:
         /**
-         * @brief Non-recursive DFS iterator over internal nodes.
+         * @brief Stackless pre-order iterator over internal nodes.
          *
-         * This iterator avoids explicit recursion and traverses only live
-         * internal nodes reachable from the root provided to the range.
+         * After a node, the iterator descends to its first child; from a leaf
+         * it climbs towards the range root until it finds a next sibling.
          */
         class iterator {
         private:
-            const DynamicComponentTree *tree_ = nullptr;
-            FastStack<int> stack_;
+            const BasicDynamicComponentTree *tree_ = nullptr;
+            NodeId rootNodeId_ = InvalidNode;
             NodeId currentNodeId_ = InvalidNode;
 
             void advance() {
-                if (stack_.empty()) {
-                    currentNodeId_ = InvalidNode;
+                const NodeId firstChildId = tree_->nodes_[currentNodeId_].firstChild;
+                if (firstChildId != InvalidNode) {
+                    currentNodeId_ = firstChildId;
                     return;
                 }
-                currentNodeId_ = stack_.pop();
-                for (NodeId childId = tree_->lastChild_[currentNodeId_];
-                     childId != InvalidNode;
-                     childId = tree_->prevSibling_[childId]) {
-                    stack_.push(childId);
+                NodeId nodeId = currentNodeId_;
+                while (nodeId != rootNodeId_) {
+                    const NodeId siblingId = tree_->nodes_[nodeId].nextSibling;
+                    if (siblingId != InvalidNode) {
+                        currentNodeId_ = siblingId;
+                        return;
+                    }
+                    nodeId = tree_->nodes_[nodeId].parent;
                 }
+                currentNodeId_ = InvalidNode;
             }
 
         public:
-            iterator(const DynamicComponentTree *tree, NodeId rootNodeId, bool isEnd) : tree_(tree) {
+            iterator(const BasicDynamicComponentTree *tree, NodeId rootNodeId, bool isEnd) : tree_(tree) {
                 if (!isEnd && tree_ != nullptr && rootNodeId != InvalidNode) {
-                    stack_.push(rootNodeId);
-                    advance();
+                    rootNodeId_ = rootNodeId;
+                    currentNodeId_ = rootNodeId;
                 }
             }
 
@@ -1134,7 +2735,7 @@ public:
             }
         };
 
-        SubtreeNodeRange(const DynamicComponentTree *tree, NodeId rootNodeId) : tree_(tree), rootNodeId_(rootNodeId) {}
+        SubtreeNodeRange(const BasicDynamicComponentTree *tree, NodeId rootNodeId) : tree_(tree), rootNodeId_(rootNodeId) {}
 
         iterator begin() const { return iterator(tree_, rootNodeId_, false); }
         iterator end() const { return iterator(tree_, InvalidNode, true); }
@@ -1142,51 +2743,65 @@ public:
 
     class BreadthFirstNodeRange {
     private:
-        const DynamicComponentTree *tree_ = nullptr;
+        const BasicDynamicComponentTree *tree_ = nullptr;
         NodeId rootNodeId_ = InvalidNode;
+        FastQueue<NodeId> *workspace_ = nullptr;
 
     public:
         /**
          * @brief Breadth-first forward iterator over internal nodes.
+         *
+         * The frontier lives in the caller's workspace when the range was
+         * given one, and in a queue owned by the iterator otherwise.
          */
         class iterator {
         private:
-            const DynamicComponentTree *tree_ = nullptr;
-            FastQueue<NodeId> queue_;
+            const BasicDynamicComponentTree *tree_ = nullptr;
+            FastQueue<NodeId> ownQueue_;
+            FastQueue<NodeId> *workspace_ = nullptr;
+
+            FastQueue<NodeId> &queue() { return workspace_ != nullptr ? *workspace_ : ownQueue_; }
+            const FastQueue<NodeId> &queue() const { return workspace_ != nullptr ? *workspace_ : ownQueue_; }
 
         public:
-            iterator(const DynamicComponentTree *tree, NodeId rootNodeId, bool isEnd) : tree_(tree) {
+            iterator(const BasicDynamicComponentTree *tree, NodeId rootNodeId, FastQueue<NodeId> *workspace, bool isEnd)
+                : tree_(tree), workspace_(isEnd ? nullptr : workspace) {
                 if (!isEnd && tree_ != nullptr && rootNodeId != InvalidNode) {
-                    queue_.push(rootNodeId);
+                    queue().clear();
+                    queue().push(rootNodeId);
                 }
             }
 
             NodeId operator*() const {
-                return queue_.front();
+                return queue().front();
             }
 
             iterator &operator++() {
-                if (!queue_.empty()) {
-                    const NodeId nodeId = queue_.pop();
-                    for (NodeId childId : tree_->getChildren(nodeId)) {
-                        queue_.push(childId);
+                FastQueue<NodeId> &frontier = queue();
+                if (!frontier.empty()) {
+                    const NodeId nodeId = frontier.pop();
+                    for (NodeId childId = tree_->nodes_[nodeId].firstChild; childId != InvalidNode; childId = tree_->nodes_[childId].nextSibling) {
+                        frontier.push(childId);
                     }
                 }
                 return *this;
             }
 
             bool operator!=(const iterator &other) const {
-                return queue_.empty() != other.queue_.empty();
+                return queue().empty() != other.queue().empty();
             }
         };
 
         /**
          * @brief Builds the BFS range rooted at `rootNodeId`.
+         * @param workspace Optional caller-owned frontier; when given, it is
+         * cleared on `begin()` and its capacity is reused across traversals.
          */
-        BreadthFirstNodeRange(const DynamicComponentTree *tree, NodeId rootNodeId) : tree_(tree), rootNodeId_(rootNodeId) {}
+        BreadthFirstNodeRange(const BasicDynamicComponentTree *tree, NodeId rootNodeId, FastQueue<NodeId> *workspace = nullptr)
+            : tree_(tree), rootNodeId_(rootNodeId), workspace_(workspace) {}
 
-        iterator begin() const { return iterator(tree_, rootNodeId_, false); }
-        iterator end() const { return iterator(tree_, InvalidNode, true); }
+        iterator begin() const { return iterator(tree_, rootNodeId_, workspace_, false); }
+        iterator end() const { return iterator(tree_, InvalidNode, nullptr, true); }
     };
 
     /**
@@ -1202,4 +2817,41 @@ public:
     BreadthFirstNodeRange getIteratorBreadthFirstTraversal(NodeId rootNodeId) const {
         return BreadthFirstNodeRange(this, rootNodeId);
     }
+
+    /**
+     * @brief Breadth-first traversal from `rootNodeId` that keeps its frontier in `workspace`.
+     *
+     * Hot loops should hold one workspace and pass it to every traversal: once
+     * its capacity covers the largest frontier, traversals stop allocating.
+     * Only one traversal may use a given workspace at a time.
+     */
+    BreadthFirstNodeRange getIteratorBreadthFirstTraversal(NodeId rootNodeId, FastQueue<NodeId> &workspace) const {
+        return BreadthFirstNodeRange(this, rootNodeId, &workspace);
+    }
+
+    /**
+     * @brief Writes the nodes of the subtree of `rootNodeId` in breadth-first order.
+     * @param order Output buffer, reused as the traversal queue.
+     *
+     * Every node appears after its parent, so walking `order` backwards visits
+     * children before parents. Full-tree passes use this instead of recursion,
+     * whose depth grows with the number of gray levels on gradient images.
+     */
+    void collectBreadthFirstOrder(NodeId rootNodeId, std::vector<NodeId> &order) const {
+        order.clear();
+        if (rootNodeId == InvalidNode) {
+            return;
+        }
+        order.push_back(rootNodeId);
+        for (std::size_t head = 0; head < order.size(); ++head) {
+            for (NodeId childId = nodes_[order[head]].firstChild; childId != InvalidNode; childId = nodes_[childId].nextSibling) {
+                order.push_back(childId);
+            }
+        }
+    }
 };
+
+/**
+ * @brief Dynamic component tree with 32-bit stored indices, used throughout the pipeline.
+ */
+using DynamicComponentTree = BasicDynamicComponentTree<int32_t>;
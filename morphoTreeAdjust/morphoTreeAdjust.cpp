@@ -5,12 +5,16 @@
 #include "include/DynamicComponentTree.hpp"
 #include "include/DualMinMaxTreeIncrementalFilter.hpp"
 
+#include <algorithm>
+#include <fstream>
 #include <memory>
+#include <mutex>
 #include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include <pybind11/numpy.h>
@@ -21,36 +25,124 @@ namespace py = pybind11;
 
 namespace {
 
-ImageUInt8Ptr image_from_numpy(const py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &input) {
-    const py::buffer_info info = input.request();
+std::ofstream open_snapshot_for_writing(const std::string &path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open snapshot file for writing: " + path);
+    }
+    return out;
+}
+
+std::ifstream open_snapshot_for_reading(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open snapshot file: " + path);
+    }
+    return in;
+}
+
+template<typename PixelType>
+ImagePtr<PixelType> image_from_numpy(const py::array &input) {
+    auto typed = py::array_t<PixelType, py::array::c_style | py::array::forcecast>::ensure(input);
+    if (!typed) {
+        throw std::runtime_error("Expected a 2D NumPy array convertible to unsigned integers.");
+    }
+    const py::buffer_info info = typed.request();
     if (info.ndim != 2) {
-        throw std::runtime_error("Expected a 2D uint8 NumPy array.");
+        throw std::runtime_error("Expected a 2D uint8 or uint16 NumPy array.");
     }
 
+    // Borrow the C-contiguous buffer instead of copying it. The view keeps the
+    // array alive and drops its reference under the GIL, since the last owner
+    // may be released on a thread that does not hold it. Read-only arrays are
+    // copied: images are mutable, and such buffers may be shared or mapped.
     const int numRows = static_cast<int>(info.shape[0]);
     const int numCols = static_cast<int>(info.shape[1]);
-    auto image = ImageUInt8::create(numRows, numCols);
-    std::copy_n(static_cast<const uint8_t *>(info.ptr), static_cast<size_t>(numRows * numCols), image->rawData());
-    return image;
+    if (!typed.writeable()) {
+        auto image = Image<PixelType>::create(numRows, numCols);
+        std::copy_n(static_cast<const PixelType *>(info.ptr), image->getSize(), image->rawData());
+        return image;
+    }
+    std::shared_ptr<void> owner(new py::array(std::move(typed)), [](void *ptr) {
+        py::gil_scoped_acquire acquire;
+        delete static_cast<py::array *>(ptr);
+    });
+    return Image<PixelType>::view(numRows, numCols, static_cast<PixelType *>(info.ptr), std::move(owner));
 }
 
-py::array_t<uint8_t> numpy_from_image(const ImageUInt8Ptr &image) {
+template<typename PixelType>
+py::array_t<PixelType> numpy_from_image(const ImagePtr<PixelType> &image) {
     if (image == nullptr) {
-        return py::array_t<uint8_t>();
+        return py::array_t<PixelType>();
     }
 
-    py::capsule owner(new ImageUInt8Ptr(image), [](void *ptr) {
-        delete static_cast<ImageUInt8Ptr *>(ptr);
+    py::capsule owner(new ImagePtr<PixelType>(image), [](void *ptr) {
+        delete static_cast<ImagePtr<PixelType> *>(ptr);
     });
 
-    return py::array_t<uint8_t>(
+    return py::array_t<PixelType>(
         {image->getNumRows(), image->getNumCols()},
-        {static_cast<py::ssize_t>(sizeof(uint8_t) * image->getNumCols()), static_cast<py::ssize_t>(sizeof(uint8_t))},
+        {static_cast<py::ssize_t>(sizeof(PixelType) * image->getNumCols()), static_cast<py::ssize_t>(sizeof(PixelType))},
         image->rawData(),
         owner
     );
 }
 
+/**
+ * @brief Returns `true` for arrays that must take the 16-bit path.
+ * @details `uint16` arrays are kept at full depth; every other dtype is
+ * force-cast to `uint8`, as before 16-bit support.
+ */
+bool is_uint16_array(const py::array &input) {
+    return input.dtype().is(py::dtype::of<uint16_t>());
+}
+
+template<typename Column>
+py::array_t<typename Column::value_type> numpy_copy_of(const Column &values) {
+    py::array_t<typename Column::value_type> array(static_cast<py::ssize_t>(values.size()));
+    values.copyTo(array.mutable_data());
+    return array;
+}
+
+/**
+ * @brief Hands `values` to NumPy without copying; the array owns the vector.
+ */
+template<typename T>
+py::array_t<T> numpy_adopt(std::vector<T> &&values) {
+    auto *owned = new std::vector<T>(std::move(values));
+    py::capsule owner(owned, [](void *ptr) {
+        delete static_cast<std::vector<T> *>(ptr);
+    });
+    return py::array_t<T>(static_cast<py::ssize_t>(owned->size()), owned->data(), owner);
+}
+
+py::array_t<bool> node_liveness_of(const DynamicComponentTree &tree) {
+    const auto parents = tree.getNodeParents();
+    py::array_t<bool> alive(static_cast<py::ssize_t>(parents.size()));
+    std::transform(parents.begin(), parents.end(), alive.mutable_data(), [](NodeId parentId) {
+        return parentId != InvalidNode;
+    });
+    return alive;
+}
+
+/**
+ * @brief Converts `input` to an 8- or 16-bit image and passes it to `fn`.
+ */
+template<typename Fn>
+auto with_image_from_numpy(const py::array &input, Fn &&fn) {
+    if (is_uint16_array(input)) {
+        return fn(image_from_numpy<uint16_t>(input));
+    }
+    return fn(image_from_numpy<uint8_t>(input));
+}
+
+py::array reconstruction_to_numpy(const DynamicComponentTree &tree) {
+    if (tree.getImageBitDepth() > 8) {
+        return numpy_from_image(tree.reconstructionImage<uint16_t>());
+    }
+    return numpy_from_image(tree.reconstructionImage<uint8_t>());
+}
+
 Attribute parse_attribute_string(const std::string &attribute) {
     std::string normalized = attribute;
     for (char &c : normalized) {
@@ -116,21 +208,119 @@ std::vector<NodeId> subtree_nodes_of(const DynamicComponentTree &tree, NodeId ro
 std::vector<NodeId> breadth_first_nodes_of(const DynamicComponentTree &tree) {
     std::vector<NodeId> nodes;
     nodes.reserve(static_cast<size_t>(tree.getNumNodes()));
-    for (NodeId nodeId : tree.getIteratorBreadthFirstTraversal()) {
-        nodes.push_back(nodeId);
-    }
+    tree.collectBreadthFirstOrder(tree.getRoot(), nodes);
     return nodes;
 }
 
+/*
+ * Threading model of the bindings: calls that run native work on whole trees
+ * release the GIL, so different instances progress in parallel from Python
+ * threads. Images are converted to and from NumPy while the GIL is held;
+ * writeable inputs already in the target dtype are borrowed rather than
+ * copied, so they must not be written from another thread during the call.
+ * Each wrapper owns a mutex, locked only after the GIL is released, that
+ * serializes concurrent calls on the same instance. Every tree handed to
+ * Python also carries a mutex in the deleter of its shared pointer: its own
+ * for trees built here, and the mutex of the owning runner for trees exposed
+ * by a `ComponentTreeCasf`. Tree methods and the dual filter lock it, so a
+ * tree is never read from Python while native work edits it.
+ */
+
+using DynamicComponentTreePtr = std::shared_ptr<DynamicComponentTree>;
+
+/**
+ * @brief Deleter of every tree shared with Python; carries the mutex that guards the tree.
+ * @details The mutex lives in the control block of the shared pointer, so it
+ * is found from any copy of the pointer and dies with the last of them. A
+ * tree owned by another object holds that object in `owner` and is not
+ * deleted here.
+ */
+struct TreeHolder {
+    std::shared_ptr<std::mutex> mutex;
+    std::shared_ptr<const void> owner;
+
+    void operator()(DynamicComponentTree *tree) const {
+        if (owner == nullptr) {
+            delete tree;
+        }
+    }
+};
+
+/**
+ * @brief Hands a tree built by the bindings to Python together with its own mutex.
+ */
+DynamicComponentTreePtr share_tree(std::unique_ptr<DynamicComponentTree> tree) {
+    return DynamicComponentTreePtr(tree.release(), TreeHolder{std::make_shared<std::mutex>(), nullptr});
+}
+
+/**
+ * @brief Mutex guarding `tree`, read from the deleter of its shared pointer.
+ */
+std::shared_ptr<std::mutex> tree_mutex_of(const DynamicComponentTreePtr &tree) {
+    const TreeHolder *holder = std::get_deleter<TreeHolder>(tree);
+    if (holder == nullptr) {
+        throw std::runtime_error("DynamicComponentTree was not created by the Python bindings.");
+    }
+    return holder->mutex;
+}
+
+/**
+ * @brief Holds the mutex of a tree for a call made with the GIL held.
+ * @details The lock is tried first; when native work holds it, the GIL is
+ * released while waiting, since that work may need the GIL to finish.
+ */
+class TreeLock {
+private:
+    std::shared_ptr<std::mutex> mutex_;
+    std::unique_lock<std::mutex> lock_;
+
+public:
+    explicit TreeLock(const DynamicComponentTreePtr &tree)
+        : mutex_(tree_mutex_of(tree)), lock_(*mutex_, std::try_to_lock) {
+        if (!lock_.owns_lock()) {
+            py::gil_scoped_release release;
+            lock_.lock();
+        }
+    }
+};
+
+template<typename R, typename... Args, bool NoExcept>
+auto tree_locked(R (DynamicComponentTree::*method)(Args...) noexcept(NoExcept)) {
+    return [method](const DynamicComponentTreePtr &self, Args... args) -> R {
+        const TreeLock lock(self);
+        return ((*self).*method)(std::forward<Args>(args)...);
+    };
+}
+
+template<typename R, typename... Args, bool NoExcept>
+auto tree_locked(R (DynamicComponentTree::*method)(Args...) const noexcept(NoExcept)) {
+    return [method](const DynamicComponentTreePtr &self, Args... args) -> R {
+        const TreeLock lock(self);
+        return ((*self).*method)(std::forward<Args>(args)...);
+    };
+}
+
+template<typename R, typename... Args>
+auto tree_locked(R (*function)(const DynamicComponentTree &, Args...)) {
+    return [function](const DynamicComponentTreePtr &self, Args... args) -> R {
+        const TreeLock lock(self);
+        return function(*self, std::forward<Args>(args)...);
+    };
+}
+
 class PyDualMinMaxTreeIncrementalFilter {
 private:
+    mutable std::mutex mutex_;
     std::shared_ptr<DynamicComponentTree> mintree_;
     std::shared_ptr<DynamicComponentTree> maxtree_;
+    std::shared_ptr<std::mutex> minTreeMutex_;
+    std::shared_ptr<std::mutex> maxTreeMutex_;
     DynamicAreaComputer minAreaComputer_;
     DynamicAreaComputer maxAreaComputer_;
     std::vector<float> minArea_;
     std::vector<float> maxArea_;
-    DualMinMaxTreeIncrementalFilter<AltitudeType> adjust_;
+    // The pixel type follows the bit depth of the trees.
+    std::variant<std::unique_ptr<DualMinMaxTreeIncrementalFilter<uint8_t>>, std::unique_ptr<DualMinMaxTreeIncrementalFilter<uint16_t>>> adjust_;
 
     static DynamicComponentTree *requireTree(const std::shared_ptr<DynamicComponentTree> &tree, const char *name) {
         if (tree == nullptr) {
@@ -139,6 +329,11 @@ private:
         return tree.get();
     }
 
+    static std::shared_ptr<std::mutex> requireTreeMutex(const std::shared_ptr<DynamicComponentTree> &tree, const char *name) {
+        requireTree(tree, name);
+        return tree_mutex_of(tree);
+    }
+
     static AdjacencyRelation &requireAdjacency(const std::shared_ptr<DynamicComponentTree> &mintree,
                                                const std::shared_ptr<DynamicComponentTree> &maxtree) {
         DynamicComponentTree *minTreePtr = requireTree(mintree, "min-tree");
@@ -149,6 +344,44 @@ private:
         return *minTreePtr->getAdjacencyRelation();
     }
 
+    static decltype(adjust_) makeAdjust(const std::shared_ptr<DynamicComponentTree> &mintree,
+                                        const std::shared_ptr<DynamicComponentTree> &maxtree) {
+        AdjacencyRelation &adj = requireAdjacency(mintree, maxtree);
+        if (mintree->getImageBitDepth() != maxtree->getImageBitDepth()) {
+            throw std::runtime_error("DualMinMaxTreeIncrementalFilter requires trees of the same bit depth.");
+        }
+        if (maxtree->getImageBitDepth() > 8) {
+            return std::make_unique<DualMinMaxTreeIncrementalFilter<uint16_t>>(mintree.get(), maxtree.get(), adj);
+        }
+        return std::make_unique<DualMinMaxTreeIncrementalFilter<uint8_t>>(mintree.get(), maxtree.get(), adj);
+    }
+
+    struct TreeLocks {
+        std::unique_lock<std::mutex> filter;
+        std::unique_lock<std::mutex> mintree;
+        std::unique_lock<std::mutex> maxtree;
+    };
+
+    /**
+     * @brief Locks this filter and the mutexes of both trees; call without the GIL.
+     */
+    TreeLocks lockWithTrees() const {
+        TreeLocks locks{std::unique_lock<std::mutex>(mutex_, std::defer_lock),
+                        std::unique_lock<std::mutex>(*minTreeMutex_, std::defer_lock),
+                        std::unique_lock<std::mutex>(*maxTreeMutex_, std::defer_lock)};
+        if (minTreeMutex_ == maxTreeMutex_) {
+            std::lock(locks.filter, locks.mintree);
+        } else {
+            std::lock(locks.filter, locks.mintree, locks.maxtree);
+        }
+        return locks;
+    }
+
+    template<typename Fn>
+    decltype(auto) withAdjust(Fn &&fn) const {
+        return std::visit([&](const auto &adjust) -> decltype(auto) { return fn(*adjust); }, adjust_);
+    }
+
     static std::vector<float> liveNodeAreaSnapshot(const DynamicComponentTree &tree, const std::vector<float> &area) {
         std::vector<float> snapshot = area;
         snapshot.resize(static_cast<size_t>(tree.getNumInternalNodeSlots()), 0.0f);
@@ -165,20 +398,26 @@ private:
         maxArea_.assign(static_cast<size_t>(maxtree_->getNumInternalNodeSlots()), 0.0f);
         minAreaComputer_.compute(std::span<float>(minArea_));
         maxAreaComputer_.compute(std::span<float>(maxArea_));
-        adjust_.setAttributeComputer(minAreaComputer_, maxAreaComputer_, std::span<float>(minArea_), std::span<float>(maxArea_));
+        withAdjust([&](auto &adjust) { adjust.setAttributeComputer(minAreaComputer_, maxAreaComputer_, std::span<float>(minArea_), std::span<float>(maxArea_)); });
     }
 
 public:
     PyDualMinMaxTreeIncrementalFilter(std::shared_ptr<DynamicComponentTree> mintree, std::shared_ptr<DynamicComponentTree> maxtree)
         : mintree_(std::move(mintree)),
           maxtree_(std::move(maxtree)),
-          minAreaComputer_(requireTree(mintree_, "min-tree")),
-          maxAreaComputer_(requireTree(maxtree_, "max-tree")),
-          adjust_(mintree_.get(), maxtree_.get(), requireAdjacency(mintree_, maxtree_)) {
+          minTreeMutex_(requireTreeMutex(mintree_, "min-tree")),
+          maxTreeMutex_(requireTreeMutex(maxtree_, "max-tree")),
+          minAreaComputer_(mintree_.get()),
+          maxAreaComputer_(maxtree_.get()) {
+        py::gil_scoped_release release;
+        const auto locks = lockWithTrees();
+        adjust_ = makeAdjust(mintree_, maxtree_);
         refreshAreaBuffers();
     }
 
     void refreshAttributes() {
+        py::gil_scoped_release release;
+        const auto locks = lockWithTrees();
         refreshAreaBuffers();
     }
 
@@ -186,52 +425,289 @@ public:
         if (tree.get() != mintree_.get() && tree.get() != maxtree_.get()) {
             throw std::runtime_error("DualMinMaxTreeIncrementalFilter.updateTree requires one of the filter trees.");
         }
-        adjust_.updateTree(tree.get(), subtreeRoot);
+        py::gil_scoped_release release;
+        const auto locks = lockWithTrees();
+        withAdjust([&](auto &adjust) { adjust.updateTree(tree.get(), subtreeRoot); });
     }
 
     void pruneMaxTreeAndUpdateMinTree(std::vector<NodeId> nodesToPrune) {
-        adjust_.pruneMaxTreeAndUpdateMinTree(nodesToPrune);
+        py::gil_scoped_release release;
+        const auto locks = lockWithTrees();
+        withAdjust([&](auto &adjust) { adjust.pruneMaxTreeAndUpdateMinTree(nodesToPrune); });
     }
 
     void pruneMinTreeAndUpdateMaxTree(std::vector<NodeId> nodesToPrune) {
-        adjust_.pruneMinTreeAndUpdateMaxTree(nodesToPrune);
+        py::gil_scoped_release release;
+        const auto locks = lockWithTrees();
+        withAdjust([&](auto &adjust) { adjust.pruneMinTreeAndUpdateMaxTree(nodesToPrune); });
+    }
+
+    std::vector<float> getMinArea() const {
+        py::gil_scoped_release release;
+        const auto locks = lockWithTrees();
+        return liveNodeAreaSnapshot(*mintree_, minArea_);
+    }
+
+    std::vector<float> getMaxArea() const {
+        py::gil_scoped_release release;
+        const auto locks = lockWithTrees();
+        return liveNodeAreaSnapshot(*maxtree_, maxArea_);
     }
 
-    std::vector<float> getMinArea() const { return liveNodeAreaSnapshot(*mintree_, minArea_); }
-    std::vector<float> getMaxArea() const { return liveNodeAreaSnapshot(*maxtree_, maxArea_); }
     std::shared_ptr<DynamicComponentTree> getMinTree() const { return mintree_; }
     std::shared_ptr<DynamicComponentTree> getMaxTree() const { return maxtree_; }
-    std::string getOutputLog() const { return adjust_.getOutputLog(); }
+
+    py::array_t<float> getMinAreaArray() const {
+        return numpy_adopt(getMinArea());
+    }
+
+    py::array_t<float> getMaxAreaArray() const {
+        return numpy_adopt(getMaxArea());
+    }
+
+    std::string getOutputLog() const {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        return withAdjust([](const auto &adjust) { return adjust.getOutputLog(); });
+    }
 };
 
 class PyComponentTreeCasf : public std::enable_shared_from_this<PyComponentTreeCasf> {
 private:
-    std::unique_ptr<ComponentTreeCasf<AltitudeType>> casf_;
+    // The pixel type is fixed by the dtype of the image given at construction.
+    std::variant<std::unique_ptr<ComponentTreeCasf<uint8_t>>, std::unique_ptr<ComponentTreeCasf<uint16_t>>> casf_;
+    // Also the mutex of both trees once they are exposed to Python.
+    mutable std::mutex mutex_;
+
+    template<typename Adjacency>
+    static decltype(casf_) makeCasf(const py::array &input, const std::string &attribute, const Adjacency &adj) {
+        const Attribute parsedAttribute = parse_attribute_string(attribute);
+        return with_image_from_numpy(input, [&]<typename PixelType>(ImagePtr<PixelType> image) -> decltype(casf_) {
+            py::gil_scoped_release release;
+            return std::make_unique<ComponentTreeCasf<PixelType>>(image, adj, parsedAttribute);
+        });
+    }
 
 public:
-    PyComponentTreeCasf(const py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &input,
+    PyComponentTreeCasf(const py::array &input,
                         const std::string &attribute,
                         double radiusAdj)
-        : casf_(std::make_unique<ComponentTreeCasf<AltitudeType>>(image_from_numpy(input), radiusAdj, parse_attribute_string(attribute))) {}
+        : casf_(makeCasf(input, attribute, radiusAdj)) {}
 
-    PyComponentTreeCasf(const py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &input,
+    PyComponentTreeCasf(const py::array &input,
                         const std::string &attribute,
                         const std::shared_ptr<AdjacencyRelation> &adj)
-        : casf_(std::make_unique<ComponentTreeCasf<AltitudeType>>(image_from_numpy(input), adj, parse_attribute_string(attribute))) {}
+        : casf_(makeCasf(input, attribute, adj)) {}
+
+    explicit PyComponentTreeCasf(decltype(casf_) casf)
+        : casf_(std::move(casf)) {}
+
+    py::array filter(const std::vector<int> &thresholds, const std::string &mode = "updating") {
+        return std::visit([&]<typename PixelType>(std::unique_ptr<ComponentTreeCasf<PixelType>> &casf) -> py::array {
+            ImagePtr<PixelType> filtered;
+            {
+                py::gil_scoped_release release;
+                std::lock_guard<std::mutex> lock(mutex_);
+                filtered = casf->filter(thresholds, mode);
+            }
+            return numpy_from_image(filtered);
+        }, casf_);
+    }
+
+    /**
+     * @brief Runs the schedule once and stacks the image after each threshold.
+     * @return Array of shape `(len(thresholds), rows, cols)`; each slice is a
+     * copy of the runner's incrementally maintained output.
+     */
+    py::array filterProfile(const std::vector<int> &thresholds, const std::string &mode = "updating") {
+        return std::visit([&]<typename PixelType>(std::unique_ptr<ComponentTreeCasf<PixelType>> &casf) -> py::array {
+            const auto parsedMode = ComponentTreeCasf<PixelType>::parseMode(mode);
+            const int numRows = casf->getMaxTree().getNumRowsOfImage();
+            const int numCols = casf->getMaxTree().getNumColsOfImage();
+            py::array_t<PixelType> profile({static_cast<py::ssize_t>(thresholds.size()),
+                                            static_cast<py::ssize_t>(numRows),
+                                            static_cast<py::ssize_t>(numCols)});
+            PixelType *slices = profile.mutable_data();
+            {
+                py::gil_scoped_release release;
+                std::lock_guard<std::mutex> lock(mutex_);
+                casf->filter(thresholds, parsedMode, [&](std::size_t step, int) {
+                    const auto &filtered = casf->getFilteredImage();
+                    std::copy_n(filtered->rawData(), filtered->getSize(), slices + step * static_cast<std::size_t>(filtered->getSize()));
+                });
+            }
+            return profile;
+        }, casf_);
+    }
 
-    py::array_t<uint8_t> filter(const std::vector<int> &thresholds, const std::string &mode = "updating") {
-        return numpy_from_image(casf_->filter(thresholds, mode));
+    void setCompactionRatio(double ratio) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::visit([&](auto &casf) { casf->setCompactionRatio(ratio); }, casf_);
+    }
+
+    void setLazyProperPartOwnership(bool enabled) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::visit([&](auto &casf) { casf->setLazyProperPartOwnership(enabled); }, casf_);
+    }
+
+    void setAdaptiveExplorationPeriod(std::size_t period) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::visit([&](auto &casf) { casf->setAdaptiveExplorationPeriod(period); }, casf_);
+    }
+
+    std::size_t getNumAdaptiveNaiveSteps() {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::visit([](const auto &casf) { return casf->getNumAdaptiveNaiveSteps(); }, casf_);
+    }
+
+    std::size_t getNumCompactions() {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::visit([](const auto &casf) { return casf->getNumCompactions(); }, casf_);
+    }
+
+    void saveSnapshot(const std::string &path) {
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto out = open_snapshot_for_writing(path);
+        std::visit([&](const auto &casf) { casf->writeSnapshot(out); }, casf_);
+    }
+
+    /**
+     * @brief Loads a runner snapshot with the pixel type recorded in the file.
+     */
+    static std::shared_ptr<PyComponentTreeCasf> loadSnapshot(const std::string &path) {
+        py::gil_scoped_release release;
+        auto in = open_snapshot_for_reading(path);
+        if (ComponentTreeCasf<uint16_t>::readSnapshotBitDepth(in) == 16) {
+            return std::make_shared<PyComponentTreeCasf>(decltype(casf_)(ComponentTreeCasf<uint16_t>::loadSnapshot(in)));
+        }
+        return std::make_shared<PyComponentTreeCasf>(decltype(casf_)(ComponentTreeCasf<uint8_t>::loadSnapshot(in)));
+    }
+
+    std::shared_ptr<PyComponentTreeCasf> fork() {
+        return std::visit([&]<typename PixelType>(std::unique_ptr<ComponentTreeCasf<PixelType>> &casf) {
+            std::unique_ptr<ComponentTreeCasf<PixelType>> forked;
+            {
+                py::gil_scoped_release release;
+                std::lock_guard<std::mutex> lock(mutex_);
+                forked = casf->fork();
+            }
+            return std::make_shared<PyComponentTreeCasf>(decltype(casf_)(std::move(forked)));
+        }, casf_);
+    }
+
+    py::list filterBranches(const std::vector<std::vector<int>> &schedules, const std::string &mode = "updating", int numThreads = 0) {
+        return std::visit([&]<typename PixelType>(std::unique_ptr<ComponentTreeCasf<PixelType>> &casf) {
+            const auto parsedMode = ComponentTreeCasf<PixelType>::parseMode(mode);
+            std::vector<ImagePtr<PixelType>> filtered;
+            {
+                py::gil_scoped_release release;
+                std::lock_guard<std::mutex> lock(mutex_);
+                filtered = casf->filterBranches(schedules, parsedMode, numThreads);
+            }
+            py::list outputs;
+            for (const auto &image : filtered) {
+                outputs.append(numpy_from_image(image));
+            }
+            return outputs;
+        }, casf_);
+    }
+
+    void reset(const py::array &input) {
+        if (is_uint16_array(input) != std::holds_alternative<std::unique_ptr<ComponentTreeCasf<uint16_t>>>(casf_)) {
+            throw std::runtime_error("ComponentTreeCasf.reset requires an image with the dtype used at construction.");
+        }
+        std::visit([&]<typename PixelType>(std::unique_ptr<ComponentTreeCasf<PixelType>> &casf) {
+            auto image = image_from_numpy<PixelType>(input);
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex_);
+            casf->reset(image);
+        }, casf_);
+    }
+
+    /**
+     * @brief Shares `tree` with Python, guarded by the mutex of this runner.
+     * @details The runner holds its mutex while it filters, so tree methods
+     * called from Python wait for the call in progress to finish.
+     */
+    std::shared_ptr<DynamicComponentTree> exposeTree(const DynamicComponentTree &tree) const {
+        const auto self = shared_from_this();
+        return std::shared_ptr<DynamicComponentTree>(const_cast<DynamicComponentTree *>(&tree), TreeHolder{std::shared_ptr<std::mutex>(self, &mutex_), self});
     }
 
     std::shared_ptr<DynamicComponentTree> getMinTree() const {
-        return std::shared_ptr<DynamicComponentTree>(this->shared_from_this(), const_cast<DynamicComponentTree *>(&casf_->getMinTree()));
+        return std::visit([this](const auto &casf) { return exposeTree(casf->getMinTree()); }, casf_);
     }
 
     std::shared_ptr<DynamicComponentTree> getMaxTree() const {
-        return std::shared_ptr<DynamicComponentTree>(this->shared_from_this(), const_cast<DynamicComponentTree *>(&casf_->getMaxTree()));
+        return std::visit([this](const auto &casf) { return exposeTree(casf->getMaxTree()); }, casf_);
     }
 };
 
+/**
+ * @brief Filters the inputs at `indices` as one batch of `PixelType` images.
+ * @details Writes each output to the same index of `outputs`.
+ */
+template<typename PixelType>
+void casf_filter_batch_typed(const std::vector<py::array> &inputs,
+                             const std::vector<std::size_t> &indices,
+                             const std::vector<int> &thresholds,
+                             Attribute attribute,
+                             double radiusAdj,
+                             const std::string &mode,
+                             int numThreads,
+                             std::vector<py::array> &outputs) {
+    if (indices.empty()) {
+        return;
+    }
+    std::vector<ImagePtr<PixelType>> images;
+    images.reserve(indices.size());
+    for (std::size_t index : indices) {
+        images.push_back(image_from_numpy<PixelType>(inputs[index]));
+    }
+    const auto parsedMode = ComponentTreeCasf<PixelType>::parseMode(mode);
+    std::vector<ImagePtr<PixelType>> filtered;
+    {
+        py::gil_scoped_release release;
+        filtered = ComponentTreeCasf<PixelType>::filterBatch(images, thresholds, radiusAdj, attribute, parsedMode, numThreads);
+    }
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        outputs[indices[i]] = numpy_from_image(filtered[i]);
+    }
+}
+
+/**
+ * @brief Batch CASF entry point; each output keeps the depth of its input.
+ * @details `uint16` inputs and the others run as two batches, one per pixel
+ * type, and the results are returned in input order.
+ */
+py::list casf_filter_batch(const std::vector<py::array> &inputs,
+                           const std::vector<int> &thresholds,
+                           const std::string &attribute,
+                           double radiusAdj,
+                           const std::string &mode,
+                           int numThreads) {
+    const Attribute parsedAttribute = parse_attribute_string(attribute);
+    std::vector<std::size_t> indices8;
+    std::vector<std::size_t> indices16;
+    for (std::size_t index = 0; index < inputs.size(); ++index) {
+        (is_uint16_array(inputs[index]) ? indices16 : indices8).push_back(index);
+    }
+    std::vector<py::array> outputs(inputs.size());
+    casf_filter_batch_typed<uint8_t>(inputs, indices8, thresholds, parsedAttribute, radiusAdj, mode, numThreads, outputs);
+    casf_filter_batch_typed<uint16_t>(inputs, indices16, thresholds, parsedAttribute, radiusAdj, mode, numThreads, outputs);
+    py::list result;
+    for (const auto &output : outputs) {
+        result.append(output);
+    }
+    return result;
+}
+
 void init_adjacency_relation(py::module_ &m) {
     py::class_<AdjacencyRelation, std::shared_ptr<AdjacencyRelation>>(m, "AdjacencyRelation")
         .def(py::init<int, int, double>())
@@ -259,71 +735,147 @@ void init_adjacency_relation(py::module_ &m) {
 void init_dynamic_component_tree(py::module_ &m) {
     py::class_<DynamicComponentTree, std::shared_ptr<DynamicComponentTree>> tree(m, "DynamicComponentTree");
 
-    tree.def(py::init([](const py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &input,
+    tree.def(py::init([](const py::array &input,
                          bool isMaxtree,
-                         double radiusAdj) {
-            auto img = image_from_numpy(input);
-            auto adj = std::make_shared<AdjacencyRelation>(img->getNumRows(), img->getNumCols(), radiusAdj);
-            return std::make_shared<DynamicComponentTree>(img, isMaxtree, adj);
+                         double radiusAdj,
+                         int numThreads) {
+            return with_image_from_numpy(input, [&](auto img) {
+                py::gil_scoped_release release;
+                auto adj = std::make_shared<AdjacencyRelation>(img->getNumRows(), img->getNumCols(), radiusAdj);
+                return share_tree(std::make_unique<DynamicComponentTree>(img, isMaxtree, adj, numThreads));
+            });
         }),
         py::arg("image"),
         py::arg("isMaxtree"),
-        py::arg("radiusAdj") = 1.5)
-        .def(py::init([](const py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &input,
+        py::arg("radiusAdj") = 1.5,
+        py::arg("numThreads") = 1)
+        .def(py::init([](const py::array &input,
                          bool isMaxtree,
-                         const std::shared_ptr<AdjacencyRelation> &adj) {
-            auto image = image_from_numpy(input);
-            return std::make_shared<DynamicComponentTree>(image, isMaxtree, adj);
+                         const std::shared_ptr<AdjacencyRelation> &adj,
+                         int numThreads) {
+            return with_image_from_numpy(input, [&](auto image) {
+                py::gil_scoped_release release;
+                return share_tree(std::make_unique<DynamicComponentTree>(image, isMaxtree, adj, numThreads));
+            });
         }),
         py::arg("image"),
         py::arg("isMaxtree"),
-        py::arg("adj"))
-        .def("reconstructionImage", [](const DynamicComponentTree &self) {
-            return numpy_from_image(self.reconstructionImage());
-        })
-        .def("getNodesThreshold", [](DynamicComponentTree &self, int threshold) {
-            return DynamicComponentTree::getNodesThreshold(&self, threshold);
+        py::arg("adj"),
+        py::arg("numThreads") = 1)
+        .def_static("createMinMaxTrees", [](const py::array &input,
+                                            double radiusAdj,
+                                            bool concurrent) {
+            return with_image_from_numpy(input, [&](auto image) {
+                std::pair<std::unique_ptr<DynamicComponentTree>, std::unique_ptr<DynamicComponentTree>> trees;
+                {
+                    py::gil_scoped_release release;
+                    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), radiusAdj);
+                    trees = DynamicComponentTree::createMinMaxTrees(image, adj, concurrent);
+                }
+                auto &[maxtree, mintree] = trees;
+                return py::make_tuple(share_tree(std::move(maxtree)), share_tree(std::move(mintree)));
+            });
+        },
+        py::arg("image"),
+        py::arg("radiusAdj") = 1.5,
+        py::arg("concurrent") = false)
+        .def("reconstructionImage", tree_locked(&reconstruction_to_numpy))
+        .def("getNodesThreshold", [](const DynamicComponentTreePtr &self, int threshold) {
+            const TreeLock lock(self);
+            return DynamicComponentTree::getNodesThreshold(self.get(), threshold);
         })
-        .def("computeArea", [](DynamicComponentTree &self) {
-            DynamicAreaComputer areaComputer(&self);
+        .def("computeArea", [](const DynamicComponentTreePtr &self) {
+            const TreeLock lock(self);
+            DynamicAreaComputer areaComputer(self.get());
             return areaComputer.compute();
         })
-        .def("getPixelsOfCC", &DynamicComponentTree::getPixelsOfCC)
-        .def("getChildren", [](const DynamicComponentTree &self, NodeId nodeId) {
-            return children_of(self, nodeId);
+        .def("getPixelsOfCC", tree_locked(&DynamicComponentTree::getPixelsOfCC))
+        .def("getChildren", [](const DynamicComponentTreePtr &self, NodeId nodeId) {
+            const TreeLock lock(self);
+            return children_of(*self, nodeId);
+        })
+        .def("getProperParts", [](const DynamicComponentTreePtr &self, NodeId nodeId) {
+            const TreeLock lock(self);
+            return proper_parts_of(*self, nodeId);
+        })
+        .def("getNodeSubtree", [](const DynamicComponentTreePtr &self, NodeId nodeId) {
+            const TreeLock lock(self);
+            return subtree_nodes_of(*self, nodeId);
         })
-        .def("getProperParts", [](const DynamicComponentTree &self, NodeId nodeId) {
-            return proper_parts_of(self, nodeId);
+        .def("breadthFirstTraversal", [](const DynamicComponentTreePtr &self) {
+            const TreeLock lock(self);
+            return breadth_first_nodes_of(*self);
         })
-        .def("getNodeSubtree", [](const DynamicComponentTree &self, NodeId nodeId) {
-            return subtree_nodes_of(self, nodeId);
+        .def("moveProperPart", tree_locked(&DynamicComponentTree::moveProperPart))
+        .def("moveProperParts", tree_locked(&DynamicComponentTree::moveProperParts))
+        .def("moveChildren", tree_locked(&DynamicComponentTree::moveChildren))
+        .def("attachNode", tree_locked(&DynamicComponentTree::attachNode))
+        .def("detachNode", tree_locked(&DynamicComponentTree::detachNode))
+        .def("removeChild", tree_locked(&DynamicComponentTree::removeChild))
+        .def("setCheckpoint", tree_locked(&DynamicComponentTree::setCheckpoint))
+        .def("rollbackToCheckpoint", tree_locked(&DynamicComponentTree::rollbackToCheckpoint))
+        .def("clearCheckpoint", tree_locked(&DynamicComponentTree::clearCheckpoint))
+        .def_property_readonly("hasCheckpoint", tree_locked(&DynamicComponentTree::hasCheckpoint))
+        .def_property_readonly("nodes", [](const DynamicComponentTreePtr &self) {
+            const TreeLock lock(self);
+            return alive_nodes(*self);
         })
-        .def("breadthFirstTraversal", [](const DynamicComponentTree &self) {
-            return breadth_first_nodes_of(self);
+        .def_property_readonly("numNodes", tree_locked(&DynamicComponentTree::getNumNodes))
+        .def_property_readonly("root", tree_locked(&DynamicComponentTree::getRoot))
+        .def_property_readonly("isMaxtree", tree_locked(&DynamicComponentTree::isMaxtree))
+        .def_property_readonly("numRows", tree_locked(&DynamicComponentTree::getNumRowsOfImage))
+        .def_property_readonly("numCols", tree_locked(&DynamicComponentTree::getNumColsOfImage))
+        .def("getMemoryUsage", tree_locked(&DynamicComponentTree::getMemoryUsage))
+        .def("saveSnapshot", [](const DynamicComponentTreePtr &self, const std::string &path) {
+            const TreeLock lock(self);
+            py::gil_scoped_release release;
+            auto out = open_snapshot_for_writing(path);
+            self->writeSnapshot(out);
+        }, py::arg("path"))
+        .def_static("loadSnapshot", [](const std::string &path) {
+            py::gil_scoped_release release;
+            auto in = open_snapshot_for_reading(path);
+            auto loaded = std::make_unique<DynamicComponentTree>();
+            loaded->readSnapshot(in);
+            return share_tree(std::move(loaded));
+        }, py::arg("path"))
+        .def_property_readonly("numFreeNodeSlots", tree_locked(&DynamicComponentTree::getNumFreeNodeSlots))
+        .def("getNodeParents", [](const DynamicComponentTreePtr &self) {
+            const TreeLock lock(self);
+            return numpy_copy_of(self->getNodeParents());
         })
-        .def("moveProperPart", &DynamicComponentTree::moveProperPart)
-        .def("moveProperParts", &DynamicComponentTree::moveProperParts)
-        .def("moveChildren", &DynamicComponentTree::moveChildren)
-        .def("attachNode", &DynamicComponentTree::attachNode)
-        .def("detachNode", &DynamicComponentTree::detachNode)
-        .def("removeChild", &DynamicComponentTree::removeChild)
-        .def_property_readonly("nodes", [](const DynamicComponentTree &self) {
-            return alive_nodes(self);
+        .def("getAltitudes", [](const DynamicComponentTreePtr &self) {
+            const TreeLock lock(self);
+            return numpy_copy_of(self->getAltitudes());
+        })
+        .def("getNumProperPartsByNode", [](const DynamicComponentTreePtr &self) {
+            const TreeLock lock(self);
+            return numpy_copy_of(self->getNumProperPartsByNode());
+        })
+        .def("getSmallestComponents", [](const DynamicComponentTreePtr &self) {
+            const TreeLock lock(self);
+            if (self->isLazyProperPartOwnership()) {
+                py::array_t<NodeId> owners(static_cast<py::ssize_t>(self->getNumTotalProperParts()));
+                NodeId *data = owners.mutable_data();
+                for (PixelId pixelId = 0; pixelId < self->getNumTotalProperParts(); ++pixelId) {
+                    data[pixelId] = self->getSmallestComponent(pixelId);
+                }
+                return owners;
+            }
+            return numpy_copy_of(self->getSmallestComponents());
         })
-        .def_property_readonly("numNodes", &DynamicComponentTree::getNumNodes)
-        .def_property_readonly("root", &DynamicComponentTree::getRoot)
-        .def_property_readonly("isMaxtree", &DynamicComponentTree::isMaxtree)
-        .def_property_readonly("numRows", &DynamicComponentTree::getNumRowsOfImage)
-        .def_property_readonly("numCols", &DynamicComponentTree::getNumColsOfImage)
-        .def("getAltitude", &DynamicComponentTree::getAltitude)
-        .def("getNodeParent", &DynamicComponentTree::getNodeParent)
-        .def("getNumChildren", &DynamicComponentTree::getNumChildren)
-        .def("getNumProperParts", &DynamicComponentTree::getNumProperParts)
-        .def("getSmallestComponent", &DynamicComponentTree::getSmallestComponent)
-        .def("isAlive", &DynamicComponentTree::isAlive)
-        .def("isNode", &DynamicComponentTree::isNode)
-        .def("isLeaf", &DynamicComponentTree::isLeaf)
-        .def("hasChild", &DynamicComponentTree::hasChild);
+        .def("setLazyProperPartOwnership", tree_locked(&DynamicComponentTree::setLazyProperPartOwnership), py::arg("enabled"))
+        .def_property_readonly("isLazyProperPartOwnership", tree_locked(&DynamicComponentTree::isLazyProperPartOwnership))
+        .def("getNodeLiveness", tree_locked(&node_liveness_of))
+        .def("getAltitude", tree_locked(&DynamicComponentTree::getAltitude))
+        .def("getNodeParent", tree_locked(&DynamicComponentTree::getNodeParent))
+        .def("getNumChildren", tree_locked(&DynamicComponentTree::getNumChildren))
+        .def("getNumProperParts", tree_locked(&DynamicComponentTree::getNumProperParts))
+        .def("getSmallestComponent", tree_locked(py::overload_cast<PixelId>(&DynamicComponentTree::getSmallestComponent)))
+        .def("isAlive", tree_locked(&DynamicComponentTree::isAlive))
+        .def("isNode", tree_locked(&DynamicComponentTree::isNode))
+        .def("isLeaf", tree_locked(&DynamicComponentTree::isLeaf))
+        .def("hasChild", tree_locked(&DynamicComponentTree::hasChild));
 
 }
 
@@ -340,12 +892,14 @@ void init_dual_min_max_tree_incremental_filter(py::module_ &m) {
         .def_property_readonly("maxTree", &PyDualMinMaxTreeIncrementalFilter::getMaxTree)
         .def_property_readonly("minArea", &PyDualMinMaxTreeIncrementalFilter::getMinArea)
         .def_property_readonly("maxArea", &PyDualMinMaxTreeIncrementalFilter::getMaxArea)
+        .def("getMinAreaArray", &PyDualMinMaxTreeIncrementalFilter::getMinAreaArray)
+        .def("getMaxAreaArray", &PyDualMinMaxTreeIncrementalFilter::getMaxAreaArray)
         .def("log", &PyDualMinMaxTreeIncrementalFilter::getOutputLog);
 }
 
 void init_component_tree_casf(py::module_ &m) {
     py::class_<PyComponentTreeCasf, std::shared_ptr<PyComponentTreeCasf>>(m, "ComponentTreeCasf")
-        .def(py::init([](const py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &input,
+        .def(py::init([](const py::array &input,
                          const std::string &attribute,
                          double radiusAdj) {
                 return std::make_shared<PyComponentTreeCasf>(input, attribute, radiusAdj);
@@ -353,7 +907,7 @@ void init_component_tree_casf(py::module_ &m) {
              py::arg("image"),
              py::arg("attribute") = "area",
              py::arg("radiusAdj") = 1.5)
-        .def(py::init([](const py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &input,
+        .def(py::init([](const py::array &input,
                          const std::string &attribute,
                          const std::shared_ptr<AdjacencyRelation> &adj) {
                 return std::make_shared<PyComponentTreeCasf>(input, attribute, adj);
@@ -362,6 +916,27 @@ void init_component_tree_casf(py::module_ &m) {
              py::arg("attribute") = "area",
              py::arg("adj"))
         .def("filter", &PyComponentTreeCasf::filter, py::arg("thresholds"), py::arg("mode") = "updating")
+        .def("filterProfile", &PyComponentTreeCasf::filterProfile, py::arg("thresholds"), py::arg("mode") = "updating")
+        .def("reset", &PyComponentTreeCasf::reset, py::arg("input"))
+        .def("fork", &PyComponentTreeCasf::fork)
+        .def("saveSnapshot", &PyComponentTreeCasf::saveSnapshot, py::arg("path"))
+        .def_static("loadSnapshot", &PyComponentTreeCasf::loadSnapshot, py::arg("path"))
+        .def("setCompactionRatio", &PyComponentTreeCasf::setCompactionRatio, py::arg("ratio"))
+        .def("setLazyProperPartOwnership", &PyComponentTreeCasf::setLazyProperPartOwnership, py::arg("enabled"))
+        .def_property_readonly("numCompactions", &PyComponentTreeCasf::getNumCompactions)
+        .def("setAdaptiveExplorationPeriod", &PyComponentTreeCasf::setAdaptiveExplorationPeriod, py::arg("period"))
+        .def_property_readonly("numAdaptiveNaiveSteps", &PyComponentTreeCasf::getNumAdaptiveNaiveSteps)
+        .def("filterBranches", &PyComponentTreeCasf::filterBranches,
+             py::arg("schedules"),
+             py::arg("mode") = "updating",
+             py::arg("numThreads") = 0)
+        .def_static("filterBatch", &casf_filter_batch,
+                    py::arg("images"),
+                    py::arg("thresholds"),
+                    py::arg("attribute") = "area",
+                    py::arg("radiusAdj") = 1.5,
+                    py::arg("mode") = "updating",
+                    py::arg("numThreads") = 0)
         .def("getMinTree", &PyComponentTreeCasf::getMinTree)
         .def("getMaxTree", &PyComponentTreeCasf::getMaxTree)
         .def_property_readonly("minTree", &PyComponentTreeCasf::getMinTree)
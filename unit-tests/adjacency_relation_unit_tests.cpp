@@ -2,6 +2,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "../morphoTreeAdjust/include/AdjacencyRelation.hpp"
@@ -24,6 +25,15 @@ std::vector<int> collect_range(AdjacencyRelation &adjacency) {
     return values;
 }
 
+template<typename RangeT>
+std::vector<int> collect_const_range(const RangeT &range) {
+    std::vector<int> values;
+    for (int value : range) {
+        values.push_back(value);
+    }
+    return values;
+}
+
 std::vector<int> expected_rectangular_neighbors(int numCols, int row, int col, int halfHeight, int halfWidth, bool forwardOnly) {
     std::vector<int> values;
     for (int dy = -halfHeight; dy <= halfHeight; ++dy) {
@@ -101,6 +111,136 @@ void test_generic_constructor_rejects_non_symmetric_offsets() {
     require(threw, "adjacency should reject offset sets without central symmetry");
 }
 
+void test_const_ranges_match_stateful_iteration() {
+    auto adjacency = AdjacencyRelation::rectangular(7, 9, 2, 1);
+    for (int p = 0; p < 7 * 9; ++p) {
+        require(collect_const_range(adjacency.getNeighborRange(p)) == collect_range(adjacency.getNeighborPixels(p)),
+                "const neighbor range should visit the same pixels as getNeighborPixels");
+        require(collect_const_range(adjacency.getNeighborRangeForward(p)) == collect_range(adjacency.getNeighborPixelsForward(p)),
+                "const forward range should visit the same pixels as getNeighborPixelsForward");
+        require(collect_const_range(adjacency.getAdjRange(p)) == collect_range(adjacency.getAdjPixels(p)),
+                "const adjacency range should visit the same pixels as getAdjPixels");
+    }
+
+    // Nested ranges over one relation must not interfere with each other.
+    const AdjacencyRelation &shared = adjacency;
+    int numPairs = 0;
+    for (int q : shared.getNeighborRange(4 * 9 + 4)) {
+        for (int r : shared.getNeighborRange(q)) {
+            require(shared.isAdjacent(q, r), "nested range should only yield neighbors of its own pixel");
+            ++numPairs;
+        }
+    }
+    require(numPairs > 0, "nested iteration should visit second-order neighbors");
+}
+
+void test_const_ranges_are_safe_to_share_between_threads() {
+    const AdjacencyRelation adjacency(31, 29, 1.5);
+    std::vector<long long> sums(4, 0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int repeat = 0; repeat < 20; ++repeat) {
+                for (int p = 0; p < 31 * 29; ++p) {
+                    for (int q : adjacency.getNeighborRange(p)) {
+                        sums[(size_t) t] += q - p;
+                    }
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    AdjacencyRelation serial(31, 29, 1.5);
+    long long expected = 0;
+    for (int repeat = 0; repeat < 20; ++repeat) {
+        for (int p = 0; p < 31 * 29; ++p) {
+            for (int q : serial.getNeighborPixels(p)) {
+                expected += q - p;
+            }
+        }
+    }
+    for (long long sum : sums) {
+        require(sum == expected, "concurrent readers of one relation should all observe the serial neighborhoods");
+    }
+}
+
+void test_interior_fast_path_matches_checked_scan() {
+    // Stencils wider than the image leave no interior pixel at all.
+    const std::vector<std::pair<int, int>> shapes = {{1, 1}, {2, 9}, {6, 6}, {11, 4}, {13, 17}};
+    for (const auto &[numRows, numCols] : shapes) {
+        std::vector<AdjacencyRelation> relations = {
+            AdjacencyRelation(numRows, numCols, 1.0),
+            AdjacencyRelation(numRows, numCols, 1.5),
+            AdjacencyRelation(numRows, numCols, 2.5),
+            AdjacencyRelation::rectangular(numRows, numCols, 1, 3),
+        };
+        for (auto &adjacency : relations) {
+            for (int p = 0; p < numRows * numCols; ++p) {
+                const auto expected = collect_range(adjacency.getNeighborPixels(p));
+                std::vector<int> visited;
+                adjacency.forEachNeighbor(p, [&](int q) { visited.push_back(q); });
+                require(visited == expected, "forEachNeighbor should visit the checked neighbors in stencil order");
+                require(collect_const_range(adjacency.getNeighborRange(p)) == expected,
+                        "interior neighbor range should match the checked scan");
+                require(collect_const_range(adjacency.getNeighborRangeForward(p)) == collect_range(adjacency.getNeighborPixelsForward(p)),
+                        "interior forward range should match the checked scan");
+                if (adjacency.isInterior(p)) {
+                    require((int) expected.size() == adjacency.getSize() - 1, "interior pixels should have every neighbor in bounds");
+                }
+            }
+        }
+    }
+}
+
+template<typename Stencil>
+void require_stencil_matches_relation(AdjacencyRelation &adjacency) {
+    for (int p = 0; p < adjacency.getNumRows() * adjacency.getNumCols(); ++p) {
+        std::vector<int> visited;
+        Stencil::forEachNeighbor(adjacency, p, [&](int q) { visited.push_back(q); });
+        require(visited == collect_range(adjacency.getNeighborPixels(p)),
+                "compile-time stencil should visit the runtime neighbors in stencil order");
+    }
+}
+
+void test_compile_time_stencils_match_runtime_relation() {
+    const std::vector<std::pair<int, int>> shapes = {{1, 1}, {1, 6}, {5, 1}, {2, 2}, {7, 9}};
+    for (const auto &[numRows, numCols] : shapes) {
+        AdjacencyRelation four(numRows, numCols, 1.0);
+        AdjacencyRelation eight(numRows, numCols, 1.5);
+        auto rectangle = AdjacencyRelation::rectangular(numRows, numCols, 1, 1);
+        AdjacencyRelation wide(numRows, numCols, 2.0);
+
+        require(four.getConnectivity() == AdjacencyRelation::Connectivity::Four, "radius 1.0 should be detected as 4-connectivity");
+        require(eight.getConnectivity() == AdjacencyRelation::Connectivity::Eight, "radius 1.5 should be detected as 8-connectivity");
+        require(rectangle.getConnectivity() == AdjacencyRelation::Connectivity::Eight, "1x1 rectangle should be detected as 8-connectivity");
+        require(wide.getConnectivity() == AdjacencyRelation::Connectivity::Generic, "radius 2.0 should keep the generic stencil");
+
+        require_stencil_matches_relation<Adjacency4>(four);
+        require_stencil_matches_relation<Adjacency8>(eight);
+        require_stencil_matches_relation<GenericAdjacency>(wide);
+
+        for (auto *adjacency : {&four, &eight, &wide}) {
+            adjacency->withStencil([&](auto stencil) {
+                require_stencil_matches_relation<decltype(stencil)>(*adjacency);
+            });
+        }
+    }
+
+    AdjacencyRelation four(6, 6, 1.0);
+    AdjacencyRelation eight(6, 6, 1.5);
+    for (int dy = -2; dy <= 2; ++dy) {
+        for (int dx = -2; dx <= 2; ++dx) {
+            const int p = 2 * 6 + 2;
+            const int q = (2 + dy) * 6 + (2 + dx);
+            require(four.isAdjacent(p, q) == Adjacency4::isAdjacent(dy, dx), "4-adjacency test should be arithmetic and match the stencil");
+            require(eight.isAdjacent(p, q) == Adjacency8::isAdjacent(dy, dx), "8-adjacency test should be arithmetic and match the stencil");
+        }
+    }
+}
+
 } // namespace
 
 int main() {
@@ -109,6 +249,10 @@ int main() {
         test_rectangular_factory_builds_expected_offsets_and_forward_half();
         test_generic_constructor_accepts_custom_symmetric_offsets();
         test_generic_constructor_rejects_non_symmetric_offsets();
+        test_const_ranges_match_stateful_iteration();
+        test_const_ranges_are_safe_to_share_between_threads();
+        test_interior_fast_path_matches_checked_scan();
+        test_compile_time_stencils_match_runtime_relation();
     } catch (const std::exception &ex) {
         std::cerr << "[adjacency_relation_unit_tests] " << ex.what() << std::endl;
         return 1;
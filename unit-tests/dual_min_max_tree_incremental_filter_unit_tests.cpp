@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -417,6 +418,49 @@ void testUpdateTreeRemainsStructurallyValidOnAllSharedRoots() {
     }
 }
 
+void testLevelBucketsGroupNodesByLevelAcrossSteps() {
+    // The pooled buckets must return the levels in order, keep the insertion
+    // order inside each level, and forget everything on clear.
+    LevelBuckets<uint16_t> buckets;
+    const std::vector<std::pair<uint16_t, NodeId>> pushes = {
+        {65535, 1}, {7, 2}, {4096, 3}, {7, 4}, {0, 5}, {65535, 6}, {64, 7}, {63, 8}, {7, 9}};
+    for (int step = 0; step < 2; ++step) {
+        for (const auto &[level, nodeId] : pushes) {
+            buckets.push(static_cast<uint16_t>(level + step), nodeId);
+        }
+        buckets.seal();
+
+        std::vector<uint16_t> expectedLevels;
+        for (const auto &[level, nodeId] : pushes) {
+            expectedLevels.push_back(static_cast<uint16_t>(level + step));
+        }
+        std::sort(expectedLevels.begin(), expectedLevels.end());
+        expectedLevels.erase(std::unique(expectedLevels.begin(), expectedLevels.end()), expectedLevels.end());
+        require(buckets.levels() == expectedLevels, "level buckets must list the active levels in increasing order");
+
+        std::size_t maxBucketSize = 0;
+        for (std::size_t rank = 0; rank < expectedLevels.size(); ++rank) {
+            std::vector<NodeId> expectedNodes;
+            for (const auto &[level, nodeId] : pushes) {
+                if (static_cast<uint16_t>(level + step) == expectedLevels[rank]) {
+                    expectedNodes.push_back(nodeId);
+                }
+            }
+            const auto nodes = buckets.nodesAtRank(rank);
+            require(std::vector<NodeId>(nodes.begin(), nodes.end()) == expectedNodes,
+                    "level buckets must keep the insertion order inside a level");
+            require(buckets.nodesAt(expectedLevels[rank]).size() == expectedNodes.size(), "level lookup must agree with the rank lookup");
+            maxBucketSize = std::max(maxBucketSize, expectedNodes.size());
+        }
+        require(buckets.maxBucketSize() == maxBucketSize, "level buckets must report the largest bucket");
+        require(buckets.nodesAt(static_cast<uint16_t>(8 + step)).empty(), "inactive levels must have empty buckets");
+        buckets.clear();
+    }
+
+    buckets.seal();
+    require(buckets.levels().empty(), "cleared level buckets must not keep any level");
+}
+
 } // namespace
 
 int main() {
@@ -427,6 +471,7 @@ int main() {
         testSequentialMintreePrunesMatchDualReconstructionOnLargeFixture();
         testUpdateTreeKeepsFinalTreeConnectedAndAreaConsistent();
         testUpdateTreeRemainsStructurallyValidOnAllSharedRoots();
+        testLevelBucketsGroupNodesByLevelAcrossSteps();
     } catch (const std::exception &e) {
         std::cerr << "dual_min_max_tree_incremental_filter_unit_tests: " << e.what() << "\n";
         return 1;
@@ -1,4 +1,5 @@
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -232,6 +233,90 @@ void test_naive_and_hybrid_modes_match_baseline() {
     require(hybridImage->isEqual(baseline), "ComponentTreeCasf hybrid mode must match the naive rebuild baseline");
 }
 
+void test_adaptive_mode_matches_baseline() {
+    // Whatever strategy the cost model picks at each step, the result must
+    // match the naive baseline, and the trees must stay usable afterwards.
+    for (Attribute attribute : {AREA, BOX_WIDTH}) {
+        for (int size : {48, 96}) {
+            auto input = make_structured_benchmark_image(size, size);
+            auto adj = std::make_shared<AdjacencyRelation>(input->getNumRows(), input->getNumCols(), 1.0);
+            const auto thresholds = attribute == AREA ? make_area_thresholds(size * size, 8) : std::vector<int>{1, 2, 4, 8, 16, size};
+
+            ComponentTreeCasf<AltitudeType> runner(input, 1.0, attribute);
+            std::size_t numNaiveSteps = 0;
+            const auto filtered = runner.filter(thresholds, ComponentTreeCasf<AltitudeType>::Mode::Adaptive, [&](std::size_t, int) {
+                numNaiveSteps += runner.getLastAdaptiveMode() == ComponentTreeCasf<AltitudeType>::Mode::Naive ? 1 : 0;
+            });
+            require(filtered->isEqual(run_naive_sequence(input, adj, thresholds, attribute)),
+                    "ComponentTreeCasf adaptive mode must match the naive rebuild baseline");
+            require(runner.getNumAdaptiveNaiveSteps() == numNaiveSteps, "adaptive mode must count exactly the steps it rebuilt");
+
+            runner.reset(input);
+            const auto again = runner.filter(thresholds, ComponentTreeCasf<AltitudeType>::Mode::Adaptive);
+            require(again->isEqual(filtered), "adaptive mode must be deterministic in its output");
+        }
+    }
+}
+
+void test_adaptive_mode_follows_cost_estimator() {
+    using Casf = ComponentTreeCasf<AltitudeType>;
+    auto input = make_structured_benchmark_image(48, 48);
+    auto adj = std::make_shared<AdjacencyRelation>(input->getNumRows(), input->getNumCols(), 1.0);
+    const auto thresholds = make_area_thresholds(48 * 48, 8);
+    const auto baseline = run_naive_sequence(input, adj, thresholds, AREA);
+
+    auto run = [&](Casf::AdaptiveCostEstimator estimator, std::size_t explorationPeriod) {
+        Casf runner(input, 1.0, AREA);
+        runner.setAdaptiveCostEstimator(std::move(estimator));
+        runner.setAdaptiveExplorationPeriod(explorationPeriod);
+        std::vector<Casf::Mode> modes;
+        const auto filtered = runner.filter(thresholds, Casf::Mode::Adaptive, [&](std::size_t, int) {
+            modes.push_back(runner.getLastAdaptiveMode());
+        });
+        require(filtered->isEqual(baseline), "adaptive mode must match the naive baseline under any cost estimator");
+        std::size_t numNaive = 0;
+        for (Casf::Mode mode : modes) {
+            numNaive += mode == Casf::Mode::Naive ? 1 : 0;
+        }
+        require(runner.getNumAdaptiveNaiveSteps() == numNaive, "adaptive mode must count the steps it rebuilt");
+        return modes;
+    };
+    auto fixedCosts = [](double updateCost, double naiveCost) {
+        return [=](const Casf::AdaptiveStepCounts &) { return Casf::AdaptiveCostEstimate{updateCost, naiveCost}; };
+    };
+
+    for (Casf::Mode mode : run(fixedCosts(1.0, 2.0), 0)) {
+        require(mode == Casf::Mode::Updating, "a cheaper update must always be chosen without exploration");
+    }
+    for (Casf::Mode mode : run(fixedCosts(2.0, 1.0), 0)) {
+        require(mode == Casf::Mode::Naive, "a cheaper rebuild must always be chosen without exploration");
+    }
+
+    // Rebuild exactly when the pruned region exceeds the image, counted on both trees.
+    std::vector<bool> expectNaive;
+    const auto bySize = run([&](const Casf::AdaptiveStepCounts &counts) {
+        require(counts.numPixels == 48 * 48 && counts.numNodes > 0, "cost estimator must receive the step counts");
+        expectNaive.push_back(counts.prunedPixels > (double) counts.numPixels);
+        return Casf::AdaptiveCostEstimate{counts.prunedPixels, (double) counts.numPixels};
+    }, 0);
+    require(bySize.size() == expectNaive.size(), "cost estimator must be called once per step");
+    bool sawNaive = false;
+    bool sawUpdating = false;
+    for (std::size_t step = 0; step < bySize.size(); ++step) {
+        require((bySize[step] == Casf::Mode::Naive) == expectNaive[step], "adaptive mode must run the strategy priced cheaper");
+        sawNaive = sawNaive || expectNaive[step];
+        sawUpdating = sawUpdating || !expectNaive[step];
+    }
+    require(sawNaive && sawUpdating, "the size-based schedule must exercise both strategies");
+
+    // Exploration runs the losing strategy once after each run of three steps.
+    const auto explored = run(fixedCosts(1.0, 2.0), 3);
+    for (std::size_t step = 0; step < explored.size(); ++step) {
+        const Casf::Mode expected = step % 4 == 3 ? Casf::Mode::Naive : Casf::Mode::Updating;
+        require(explored[step] == expected, "exploration must force the losing strategy after the period");
+    }
+}
+
 void test_tree_accessors_expose_internal_trees() {
     auto input = make_demo_image();
     const std::vector<int> thresholds = {1, 14};
@@ -245,6 +330,253 @@ void test_tree_accessors_expose_internal_trees() {
             "ComponentTreeCasf min-tree accessor must expose the internal tree state");
 }
 
+void test_reset_reuses_runner_across_same_shaped_images() {
+    const std::vector<int> thresholds = {1, 14, 15, 100};
+    for (Attribute attribute : {AREA, BOX_WIDTH}) {
+        for (auto mode : {ComponentTreeCasf<AltitudeType>::Mode::Updating, ComponentTreeCasf<AltitudeType>::Mode::Hybrid}) {
+            auto first = make_structured_benchmark_image(24, 24);
+            ComponentTreeCasf<AltitudeType> runner(first, 1.5, attribute);
+            for (int frame = 0; frame < 3; ++frame) {
+                auto input = make_structured_benchmark_image(24, 24);
+                for (int p = 0; p < input->getSize(); ++p) {
+                    (*input)[p] = static_cast<uint8_t>((*input)[p] + 41 * frame);
+                }
+                if (frame > 0) {
+                    runner.reset(input);
+                }
+
+                ComponentTreeCasf<AltitudeType> fresh(input, 1.5, attribute);
+                require(runner.filter(thresholds, mode)->isEqual(fresh.filter(thresholds, mode)),
+                        "a reset CASF runner must match a freshly constructed one");
+            }
+        }
+    }
+
+    ComponentTreeCasf<AltitudeType> runner(make_demo_image(), 1.0, AREA);
+    bool threw = false;
+    try {
+        runner.reset(ImageUInt8::create(5, 7, 0));
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    require(threw, "reset must reject an image with a different shape");
+}
+
+void test_uint16_casf_matches_scaled_8bit_casf() {
+    // Scaling by 257 preserves the level order, so every mode of the 16-bit
+    // filter must return the scaled 8-bit result.
+    const auto thresholds = make_area_thresholds(48 * 48, 6);
+    auto input8 = make_structured_benchmark_image(48, 48);
+    auto input16 = ImageUInt16::create(48, 48);
+    for (int p = 0; p < input8->getSize(); ++p) {
+        (*input16)[p] = static_cast<uint16_t>((*input8)[p] * 257);
+    }
+
+    for (auto mode : {ComponentTreeCasf<AltitudeType>::Mode::Updating,
+                      ComponentTreeCasf<AltitudeType>::Mode::Naive,
+                      ComponentTreeCasf<AltitudeType>::Mode::Hybrid}) {
+        ComponentTreeCasf<AltitudeType> runner8(input8, 1.5, AREA);
+        ComponentTreeCasf<uint16_t> runner16(input16, 1.5, AREA);
+        const auto filtered8 = runner8.filter(thresholds, mode);
+        const auto filtered16 = runner16.filter(thresholds, static_cast<ComponentTreeCasf<uint16_t>::Mode>(mode));
+        for (int p = 0; p < filtered8->getSize(); ++p) {
+            require((*filtered16)[p] == (*filtered8)[p] * 257,
+                    "16-bit CASF must match the 8-bit CASF on an order-preserving rescaled image");
+        }
+    }
+
+    // Levels that do not fit in 8 bits must still agree between the
+    // incremental and the rebuild paths.
+    auto wide = ImageUInt16::create(40, 40);
+    for (int r = 0; r < 40; ++r) {
+        for (int c = 0; c < 40; ++c) {
+            (*wide)[r * 40 + c] = static_cast<uint16_t>((977 * r + 613 * c + 37 * ((r * c) % 53)) % 4096);
+        }
+    }
+    ComponentTreeCasf<uint16_t> updating(wide, 1.5, AREA);
+    ComponentTreeCasf<uint16_t> naive(wide, 1.5, AREA);
+    require(updating.filter(make_area_thresholds(1600, 8))->isEqual(naive.filter(make_area_thresholds(1600, 8), "naive")),
+            "16-bit updating CASF must match the 16-bit naive CASF");
+}
+
+void test_full_attribute_pass_handles_deep_chains() {
+    // A 16-bit ramp yields a chain with one node per pixel, far deeper than a
+    // recursive pass can safely descend. Areas and boxes follow from the ramp.
+    const int numCols = 60000;
+    auto ramp = ImageUInt16::create(1, numCols);
+    for (int c = 0; c < numCols; ++c) {
+        (*ramp)[c] = static_cast<uint16_t>(c);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(1, numCols, 1.0);
+    DynamicComponentTree maxTree(ramp, true, adj);
+    require(maxTree.getNumNodes() == numCols, "a strictly increasing ramp must produce one node per pixel");
+
+    std::vector<NodeId> order;
+    maxTree.collectBreadthFirstOrder(maxTree.getRoot(), order);
+    require((int) order.size() == numCols && order.front() == maxTree.getRoot(),
+            "breadth-first order must start at the root and cover the tree");
+
+    const auto area = DynamicAreaComputer(&maxTree).compute();
+    const auto width = DynamicBoundingBoxComputer(&maxTree, BOX_WIDTH).compute();
+    for (int c = 0; c < numCols; ++c) {
+        const NodeId nodeId = maxTree.getSmallestComponent(c);
+        require(area[(size_t) nodeId] == (float) (numCols - c), "iterative area must equal the ramp suffix length");
+        require(width[(size_t) nodeId] == (float) (numCols - c), "iterative box width must equal the ramp suffix length");
+    }
+
+    const auto pruned = DynamicComponentTree::getNodesThreshold(&maxTree, 10);
+    require(pruned.size() == 1 && pruned.front() == maxTree.getSmallestComponent(numCols - 10),
+            "area threshold must stop at the first node whose area falls below the threshold");
+}
+
+void test_filter_batch_matches_individual_runners() {
+    // Mixed shapes force workers to both reset and replace their runner, and
+    // the results must come back in input order for any worker count.
+    std::vector<ImageUInt8Ptr> images;
+    for (int i = 0; i < 11; ++i) {
+        const int size = (i % 3 == 0) ? 20 : 28;
+        auto image = make_structured_benchmark_image(size, size + (i % 2));
+        for (int p = 0; p < image->getSize(); ++p) {
+            (*image)[p] = static_cast<uint8_t>((*image)[p] + 29 * i);
+        }
+        images.push_back(image);
+    }
+    const std::vector<int> thresholds = {1, 14, 15, 100};
+
+    std::vector<ImageUInt8Ptr> expected;
+    for (const auto &image : images) {
+        ComponentTreeCasf<AltitudeType> runner(image, 1.5, AREA);
+        expected.push_back(runner.filter(thresholds));
+    }
+
+    for (int numThreads : {1, 3, 0}) {
+        const auto filtered = ComponentTreeCasf<AltitudeType>::filterBatch(images, thresholds, 1.5, AREA,
+                                                                           ComponentTreeCasf<AltitudeType>::Mode::Updating, numThreads);
+        require(filtered.size() == images.size(), "batch CASF must return one image per input");
+        for (std::size_t i = 0; i < images.size(); ++i) {
+            require(filtered[i]->isEqual(expected[i]), "batch CASF must match an individual runner on every image");
+        }
+    }
+
+    images[5] = nullptr;
+    bool threw = false;
+    try {
+        ComponentTreeCasf<AltitudeType>::filterBatch(images, thresholds, 1.5, AREA, ComponentTreeCasf<AltitudeType>::Mode::Updating, 4);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    require(threw, "batch CASF must propagate worker errors");
+}
+
+void test_filter_profile_matches_prefix_runs() {
+    using Casf = ComponentTreeCasf<AltitudeType>;
+    auto image = make_structured_benchmark_image(24, 27);
+    const std::vector<int> thresholds = {1, 4, 15, 40, 100};
+    for (Casf::Mode mode : {Casf::Mode::Updating, Casf::Mode::Naive, Casf::Mode::Hybrid}) {
+        Casf runner(image, 1.5, AREA);
+        const auto profile = runner.filterProfile(thresholds, mode);
+        require(profile.size() == thresholds.size(), "profile must hold one image per threshold");
+        for (std::size_t step = 0; step < thresholds.size(); ++step) {
+            const std::vector<int> prefix(thresholds.begin(), thresholds.begin() + (std::ptrdiff_t) step + 1);
+            Casf fresh(image, 1.5, AREA);
+            require(profile[step]->isEqual(fresh.filter(prefix, mode)), "profile step must match a fresh run of the schedule prefix");
+        }
+
+        Casf visited(image, 1.5, AREA);
+        std::vector<int> seen;
+        auto last = visited.filter(thresholds, mode, [&](std::size_t step, int threshold) {
+            require(step == seen.size(), "visitor steps must be consecutive");
+            seen.push_back(threshold);
+        });
+        require(seen == thresholds && last->isEqual(profile.back()), "visitor must see every threshold and end at the final image");
+    }
+}
+
+void test_fork_continues_schedules_from_shared_prefix() {
+    using Casf = ComponentTreeCasf<AltitudeType>;
+    auto image = make_structured_benchmark_image(24, 27);
+    const std::vector<int> prefix = {1, 4};
+    const std::vector<std::vector<int>> suffixes = {{15, 40}, {9, 100}, {}};
+    for (Attribute attribute : {AREA, BOX_WIDTH}) {
+        Casf shared(image, 1.5, attribute);
+        const auto afterPrefix = shared.filter(prefix);
+        const auto branches = shared.filterBranches(suffixes, Casf::Mode::Updating, 2);
+        require(shared.getFilteredImage()->isEqual(afterPrefix), "filterBranches must leave the source runner untouched");
+        for (std::size_t i = 0; i < suffixes.size(); ++i) {
+            std::vector<int> schedule = prefix;
+            schedule.insert(schedule.end(), suffixes[i].begin(), suffixes[i].end());
+            Casf fresh(image, 1.5, attribute);
+            const auto expected = fresh.filter(schedule);
+            require(branches[i]->isEqual(expected), "branch must match a fresh run of prefix plus suffix");
+
+            auto forked = shared.fork();
+            require(forked->filter(suffixes[i], Casf::Mode::Hybrid)->isEqual(expected), "fork must continue from the shared prefix");
+        }
+        require(shared.filter({15, 40})->isEqual(branches[0]), "source runner must remain usable after forking");
+    }
+}
+
+void test_compaction_between_thresholds_matches_baseline() {
+    for (Attribute attribute : {AREA, BOX_WIDTH}) {
+        auto input = make_structured_benchmark_image(48, 48);
+        auto adj = std::make_shared<AdjacencyRelation>(input->getNumRows(), input->getNumCols(), 1.0);
+        const auto thresholds = attribute == AREA ? make_area_thresholds(48 * 48, 8) : std::vector<int>{1, 2, 4, 8, 16, 48};
+
+        ComponentTreeCasf<AltitudeType> runner(input, 1.0, attribute);
+        runner.setCompactionRatio(0.05);
+        const auto filtered = runner.filter(thresholds);
+        require(runner.getNumCompactions() > 0, "a low compaction ratio must trigger compaction");
+        require(filtered->isEqual(run_naive_sequence(input, adj, thresholds, attribute)),
+                "filtering with compaction must match the naive rebuild baseline");
+        require(runner.getMaxTree().getNumFreeNodeSlots() <= 0.05 * runner.getMaxTree().getNumInternalNodeSlots(),
+                "compaction must leave the max-tree below the ratio");
+    }
+}
+
+void test_snapshot_restores_runner_mid_schedule() {
+    using Casf = ComponentTreeCasf<AltitudeType>;
+    auto image = make_structured_benchmark_image(24, 27);
+    for (Attribute attribute : {AREA, BOX_WIDTH}) {
+        Casf runner(image, 1.5, attribute);
+        runner.filter({1, 4});
+        std::stringstream snapshot;
+        runner.writeSnapshot(snapshot);
+
+        auto loaded = Casf::loadSnapshot(snapshot);
+        require(loaded->getFilteredImage()->isEqual(runner.getFilteredImage()), "a loaded runner must hold the saved filtered image");
+        require(loaded->filter({15, 40})->isEqual(runner.filter({15, 40})), "a loaded runner must continue the schedule like the saved one");
+
+        snapshot.clear();
+        snapshot.seekg(0);
+        require(Casf::readSnapshotBitDepth(snapshot) == 8, "the snapshot must record the pixel depth");
+        bool threw = false;
+        try {
+            ComponentTreeCasf<uint16_t>::loadSnapshot(snapshot);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        require(threw, "a snapshot must be rejected by a runner of another pixel type");
+    }
+}
+
+void test_lazy_ownership_matches_baseline() {
+    for (Attribute attribute : {AREA, BOX_WIDTH}) {
+        auto input = make_structured_benchmark_image(48, 48);
+        auto adj = std::make_shared<AdjacencyRelation>(input->getNumRows(), input->getNumCols(), 1.0);
+        const auto thresholds = attribute == AREA ? make_area_thresholds(48 * 48, 8) : std::vector<int>{1, 2, 4, 8, 16, 48};
+        const auto expected = run_naive_sequence(input, adj, thresholds, attribute);
+
+        ComponentTreeCasf<AltitudeType> runner(input, 1.0, attribute);
+        runner.setLazyProperPartOwnership(true);
+        require(runner.filter(thresholds)->isEqual(expected), "lazy ownership must match the naive rebuild baseline");
+
+        ComponentTreeCasf<AltitudeType> compacting(input, 1.0, attribute);
+        compacting.setLazyProperPartOwnership(true);
+        compacting.setCompactionRatio(0.05);
+        require(compacting.filter(thresholds, "hybrid")->isEqual(expected), "lazy ownership must survive compaction and rebuilds");
+    }
+}
+
 } // namespace
 
 int main() {
@@ -255,7 +587,18 @@ int main() {
         test_casf_is_deterministic_and_empty_sequence_is_noop();
         test_area_stress_matches_naive_sequence_on_structured_images();
         test_naive_and_hybrid_modes_match_baseline();
+        test_adaptive_mode_matches_baseline();
+        test_adaptive_mode_follows_cost_estimator();
         test_tree_accessors_expose_internal_trees();
+        test_reset_reuses_runner_across_same_shaped_images();
+        test_uint16_casf_matches_scaled_8bit_casf();
+        test_full_attribute_pass_handles_deep_chains();
+        test_filter_batch_matches_individual_runners();
+        test_filter_profile_matches_prefix_runs();
+        test_fork_continues_schedules_from_shared_prefix();
+        test_compaction_between_thresholds_matches_baseline();
+        test_snapshot_restores_runner_mid_schedule();
+        test_lazy_ownership_matches_baseline();
     } catch (const std::exception &e) {
         std::cerr << "dynamic_component_tree_casf_unit_tests: FAIL\n" << e.what() << "\n";
         return 1;
@@ -1,6 +1,9 @@
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <memory>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -64,7 +67,8 @@ std::vector<int> collect_range(const RangeT &range) {
     return values;
 }
 
-std::vector<int> collect_proper_parts(const tree_t &tree, int nodeId) {
+template<typename TreeT>
+std::vector<int> collect_proper_parts(const TreeT &tree, int nodeId) {
     return collect_range(tree.getProperParts(nodeId));
 }
 
@@ -426,6 +430,900 @@ void test_remove_child_with_release_node_removes_empty_leaf_slot() {
     require_tree_consistency(tree);
 }
 
+template<typename LhsTree, typename RhsTree>
+void require_same_representation(const LhsTree &lhs, const RhsTree &rhs) {
+    require(lhs.getNumInternalNodeSlots() == rhs.getNumInternalNodeSlots(), "builds must materialize the same node slots");
+    require(lhs.getNumNodes() == rhs.getNumNodes(), "builds must produce the same number of live nodes");
+    require(lhs.getRoot() == rhs.getRoot(), "builds must choose the same root id");
+    for (int nodeId = 0; nodeId < lhs.getNumInternalNodeSlots(); ++nodeId) {
+        require(lhs.getNodeParent(nodeId) == rhs.getNodeParent(nodeId), "builds must produce the same parent array");
+        require(lhs.getAltitude(nodeId) == rhs.getAltitude(nodeId), "builds must produce the same altitudes");
+        require(vector_equal(collect_range(lhs.getChildren(nodeId)), collect_range(rhs.getChildren(nodeId))),
+                "builds must produce the same child lists");
+        require(vector_equal(collect_proper_parts(lhs, nodeId), collect_proper_parts(rhs, nodeId)),
+                "builds must produce the same proper-part lists");
+    }
+    for (int pixelId = 0; pixelId < lhs.getNumTotalProperParts(); ++pixelId) {
+        require(lhs.getSmallestComponent(pixelId) == rhs.getSmallestComponent(pixelId), "builds must produce the same owners");
+    }
+}
+
+void test_tiled_parallel_build_matches_serial_build() {
+    // The tiled union-find must reproduce the serial representation exactly,
+    // including node ids, for both polarities and several stencil reaches.
+    std::mt19937 rng(7);
+    const std::vector<std::pair<int, int>> shapes = {{12, 12}, {37, 23}, {5, 41}, {64, 9}};
+    for (const auto &[numRows, numCols] : shapes) {
+        for (int numLevels : {3, 17, 256}) {
+            auto image = ImageUInt8::create(numRows, numCols);
+            std::uniform_int_distribution<int> levelDist(0, numLevels - 1);
+            for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+                (*image)[pixelId] = (uint8_t) levelDist(rng);
+            }
+            for (double radius : {1.0, 1.5, 2.0}) {
+                auto adj = std::make_shared<AdjacencyRelation>(numRows, numCols, radius);
+                for (bool isMaxtree : {true, false}) {
+                    const tree_t serial(image, isMaxtree, adj);
+                    for (int numThreads : {2, 3, 5, numRows}) {
+                        const tree_t tiled(image, isMaxtree, adj, numThreads);
+                        require_tree_consistency(tiled);
+                        require_same_representation(serial, tiled);
+                    }
+                }
+            }
+        }
+    }
+
+    const tree_t demoSerial = make_component_tree_from_demo(true);
+    auto demoImage = make_demo_image();
+    auto demoAdj = std::make_shared<AdjacencyRelation>(demoImage->getNumRows(), demoImage->getNumCols(), 1.0);
+    require_same_representation(demoSerial, tree_t(demoImage, true, demoAdj, 4));
+}
+
+void test_min_max_pair_build_matches_independent_builds() {
+    // The paired build shares one sort and scratch buffers but must produce the
+    // same trees as two independent builds, with or without the second thread.
+    std::mt19937 rng(11);
+    for (int numLevels : {2, 9, 256}) {
+        auto image = ImageUInt8::create(19, 27);
+        std::uniform_int_distribution<int> levelDist(0, numLevels - 1);
+        for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+            (*image)[pixelId] = (uint8_t) (255 - levelDist(rng));
+        }
+        auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+        const tree_t maxtree(image, true, adj);
+        const tree_t mintree(image, false, adj);
+        for (bool concurrent : {false, true}) {
+            auto [pairMaxtree, pairMintree] = tree_t::createMinMaxTrees(image, adj, concurrent);
+            require(pairMaxtree->isMaxtree() && !pairMintree->isMaxtree(), "pair build must return (maxtree, mintree)");
+            require_tree_consistency(*pairMaxtree);
+            require_tree_consistency(*pairMintree);
+            require_same_representation(maxtree, *pairMaxtree);
+            require_same_representation(mintree, *pairMintree);
+        }
+    }
+}
+
+void test_rebuild_with_workspace_reuses_scratch_and_matches_fresh_build() {
+    // Rebuilding a mutated tree in place must discard every trace of the old
+    // state, and the workspace must keep its buffers for same-shaped images.
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> levelDist(0, 31);
+    auto adj = std::make_shared<AdjacencyRelation>(16, 21, 1.5);
+    tree_t::BuildWorkspace workspace;
+    tree_t tree;
+    const int *zParData = nullptr;
+    for (int frame = 0; frame < 4; ++frame) {
+        auto image = ImageUInt8::create(16, 21);
+        for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+            (*image)[pixelId] = (uint8_t) levelDist(rng);
+        }
+        const bool isMaxtree = (frame % 2) == 0;
+        tree.build(image, isMaxtree, adj, workspace);
+        if (frame == 0) {
+            zParData = workspace.zPar.data();
+        } else {
+            require(workspace.zPar.data() == zParData, "same-shaped rebuilds must reuse the workspace buffers");
+        }
+
+        const tree_t fresh(image, isMaxtree, adj);
+        require_tree_consistency(tree);
+        require_same_representation(fresh, tree);
+
+        auto reconstructed = ImageUInt8::create(16, 21, 255);
+        tree.reconstructionImage(*reconstructed);
+        require(reconstructed->isEqual(image), "in-place reconstruction must reproduce the input image");
+
+        for (NodeId childId : collect_range(tree.getChildren(tree.getRoot()))) {
+            tree.pruneNode(childId);
+        }
+    }
+}
+
+void test_uint16_builds_match_8bit_builds_and_reconstruct() {
+    // A 16-bit image holding 8-bit values must yield the 8-bit trees, and wide
+    // images must agree across the serial, tiled, and paired builds.
+    std::mt19937 rng(31);
+    for (int numLevels : {4, 256}) {
+        auto image8 = ImageUInt8::create(17, 23);
+        auto image16 = ImageUInt16::create(17, 23);
+        std::uniform_int_distribution<int> levelDist(0, numLevels - 1);
+        for (int pixelId = 0; pixelId < image8->getSize(); ++pixelId) {
+            (*image8)[pixelId] = (uint8_t) levelDist(rng);
+            (*image16)[pixelId] = (*image8)[pixelId];
+        }
+        auto adj = std::make_shared<AdjacencyRelation>(17, 23, 1.5);
+        for (bool isMaxtree : {true, false}) {
+            require_same_representation(tree_t(image8, isMaxtree, adj), tree_t(image16, isMaxtree, adj));
+        }
+    }
+
+    // Levels spread over the full range, only across the high byte, and over
+    // a narrow band above 255 exercise every radix pass and the pass skipping.
+    const std::vector<std::pair<int, int>> ranges = {{0, 65535}, {0, 15}, {1000, 1003}};
+    for (const auto &[minLevel, maxLevel] : ranges) {
+        auto image = ImageUInt16::create(21, 19);
+        std::uniform_int_distribution<int> levelDist(minLevel, maxLevel);
+        for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+            const int level = levelDist(rng);
+            (*image)[pixelId] = (uint16_t) (maxLevel == 15 ? level << 12 : level);
+        }
+        auto adj = std::make_shared<AdjacencyRelation>(21, 19, 1.5);
+        for (bool isMaxtree : {true, false}) {
+            const tree_t serial(image, isMaxtree, adj);
+            require(serial.getImageBitDepth() == 16, "a 16-bit build must record the image bit depth");
+            require_tree_consistency(serial);
+            require_same_representation(serial, tree_t(image, isMaxtree, adj, 4));
+
+            const std::vector<PixelId> order = serial.countingSort(image);
+            for (std::size_t i = 1; i < order.size(); ++i) {
+                const int prev = isMaxtree ? (*image)[order[i - 1]] : 65535 - (*image)[order[i - 1]];
+                const int curr = isMaxtree ? (*image)[order[i]] : 65535 - (*image)[order[i]];
+                require(prev < curr || (prev == curr && order[i - 1] < order[i]), "wide sort must be stable by (level, pixel)");
+            }
+
+            auto reconstructed = serial.reconstructionImage<uint16_t>();
+            require(reconstructed->isEqual(image), "16-bit reconstruction must reproduce the input image");
+        }
+        auto [maxtree, mintree] = tree_t::createMinMaxTrees(image, adj, true);
+        require_same_representation(tree_t(image, true, adj), *maxtree);
+        require_same_representation(tree_t(image, false, adj), *mintree);
+    }
+}
+
+void test_image_view_borrows_buffer_and_builds_like_owned_image() {
+    auto owned = make_demo_image();
+    std::vector<uint8_t> pixels(owned->rawData(), owned->rawData() + owned->getSize());
+    auto view = ImageUInt8::view(owned->getNumRows(), owned->getNumCols(), pixels.data());
+    require(view->rawData() == pixels.data(), "an image view must not copy the borrowed buffer");
+    require(view->isEqual(owned), "an image view must expose the borrowed pixels");
+
+    auto adj = std::make_shared<AdjacencyRelation>(owned->getNumRows(), owned->getNumCols(), 1.5);
+    for (bool isMaxtree : {true, false}) {
+        const tree_t fromView(view, isMaxtree, adj);
+        require_same_representation(tree_t(owned, isMaxtree, adj), fromView);
+        require(fromView.reconstructionImage()->isEqual(owned), "a tree built from a view must reconstruct the input");
+    }
+
+    auto shared = std::make_shared<std::vector<uint8_t>>(pixels);
+    auto keptAlive = ImageUInt8::view(owned->getNumRows(), owned->getNumCols(), shared->data(), shared);
+    std::weak_ptr<std::vector<uint8_t>> watch = shared;
+    shared.reset();
+    require(!watch.expired() && keptAlive->isEqual(owned), "an image view must keep its owner alive");
+    keptAlive.reset();
+    require(watch.expired(), "releasing the view must release its owner");
+}
+
+void test_bulk_views_match_per_node_accessors() {
+    auto image = make_demo_image();
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    tree_t tree(image, true, adj);
+    NodeId prunedId = InvalidNode;
+    for (NodeId nodeId : tree.getChildren(tree.getRoot())) {
+        if (!tree.isLeaf(nodeId)) {
+            prunedId = nodeId;
+            break;
+        }
+    }
+    require(prunedId != InvalidNode, "demo root must have an internal child");
+    tree.pruneNode(prunedId);
+
+    const auto parents = tree.getNodeParents();
+    const auto altitudes = tree.getAltitudes();
+    const auto numProperParts = tree.getNumProperPartsByNode();
+    require((int) parents.size() == tree.getNumInternalNodeSlots(), "parent view must cover every node slot");
+    require(altitudes.size() == parents.size() && numProperParts.size() == parents.size(), "node views must share one size");
+    int numAlive = 0;
+    for (NodeId nodeId = 0; nodeId < tree.getNumInternalNodeSlots(); ++nodeId) {
+        require((parents[nodeId] != InvalidNode) == tree.isAlive(nodeId), "parent view must encode liveness");
+        numAlive += tree.isAlive(nodeId) ? 1 : 0;
+        if (tree.isAlive(nodeId)) {
+            require(parents[nodeId] == tree.getNodeParent(nodeId), "parent view must match getNodeParent");
+            require(altitudes[nodeId] == tree.getAltitude(nodeId), "altitude view must match getAltitude");
+            require(numProperParts[nodeId] == tree.getNumProperParts(nodeId), "proper-part view must match getNumProperParts");
+        }
+    }
+    require(numAlive == tree.getNumNodes(), "parent view must expose exactly the live nodes");
+
+    const auto owners = tree.getSmallestComponents();
+    require((int) owners.size() == image->getSize(), "owner view must cover every pixel");
+    for (PixelId pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        require(owners[pixelId] == tree.getSmallestComponent(pixelId), "owner view must match getSmallestComponent");
+    }
+}
+
+void test_incremental_reconstruction_tracks_only_changed_pixels() {
+    auto image = make_demo_image();
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    tree_t tree(image, true, adj);
+    tree.setTrackPixelChanges(true);
+    require(tree.hasFullImageChange(), "enabling the change log must request a full rewrite");
+
+    auto live = ImageUInt8::create(image->getNumRows(), image->getNumCols(), 0);
+    tree.updateReconstructionImage(*live);
+    require(live->isEqual(image) && !tree.hasFullImageChange() && tree.getChangedPixels().empty(),
+            "the first update must rewrite the whole image and clear the log");
+
+    // Prune leaves one at a time; every update must match a full rescan while
+    // touching only the pixels that actually moved to a different level.
+    while (tree.getNumNodes() > 1) {
+        NodeId leafId = tree.getRoot();
+        while (!tree.isLeaf(leafId)) {
+            leafId = *tree.getChildren(leafId).begin();
+        }
+        const NodeId parentId = tree.getNodeParent(leafId);
+        const int expectedChanges = tree.getAltitude(leafId) != tree.getAltitude(parentId) ? tree.getNumProperParts(leafId) : 0;
+        tree.pruneNode(leafId);
+        require((int) tree.getChangedPixels().size() == expectedChanges, "the log must hold exactly the pixels that changed level");
+        tree.updateReconstructionImage(*live);
+        require(live->isEqual(tree.reconstructionImage()), "incremental reconstruction must match a full rescan");
+    }
+
+    tree.build(image, true, adj);
+    require(tree.hasFullImageChange(), "a rebuild must request a full rewrite");
+    tree.updateReconstructionImage(*live);
+    require(live->isEqual(image), "the update after a rebuild must restore the input image");
+}
+
+void test_checkpoint_rollback_restores_edited_tree() {
+    auto image = make_demo_image();
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    const tree_t reference(image, true, adj);
+    tree_t tree(image, true, adj);
+
+    bool threw = false;
+    try {
+        tree.rollbackToCheckpoint();
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    require(threw, "rollback without a checkpoint must throw");
+
+    tree.setCheckpoint();
+    tree.setTrackPixelChanges(true);
+    auto live = ImageUInt8::create(image->getNumRows(), image->getNumCols());
+    tree.updateReconstructionImage(*live);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        // Mix every kind of edit: subtree prune, merge, single-pixel move,
+        // and a release followed by a reuse of the freed slot.
+        NodeId leafId = tree.getRoot();
+        while (!tree.isLeaf(leafId)) {
+            leafId = *tree.getChildren(leafId).begin();
+        }
+        tree.pruneNode(tree.getNodeParent(leafId) == tree.getRoot() ? leafId : tree.getNodeParent(leafId));
+        NodeId childId = *tree.getChildren(tree.getRoot()).begin();
+        tree.mergeNodeIntoParent(childId);
+        childId = *tree.getChildren(tree.getRoot()).begin();
+        const PixelId pixelId = *tree.getProperParts(tree.getRoot()).begin();
+        tree.moveProperPart(childId, tree.getRoot(), pixelId);
+        const NodeId reusedId = tree.allocateNode();
+        require(reusedId != InvalidNode, "pruning must free slots for reuse");
+        tree.releaseNode(reusedId);
+        require(tree.getJournalSize() > 0, "edits after a checkpoint must be journaled");
+
+        tree.rollbackToCheckpoint();
+        require_same_representation(reference, tree);
+        require(tree.hasCheckpoint() && tree.getJournalSize() == 0, "rollback must keep the checkpoint with an empty journal");
+        require(tree.allocateNode() == InvalidNode, "rollback must restore the free-id pool");
+        tree.rollbackToCheckpoint();
+        tree.updateReconstructionImage(*live);
+        require(live->isEqual(image), "the change log must cover the pixels restored by rollback");
+    }
+
+    tree.pruneNode(*tree.getChildren(tree.getRoot()).begin());
+    tree.clearCheckpoint();
+    require(!tree.hasCheckpoint() && tree.getNumNodes() < reference.getNumNodes(), "clearing the checkpoint must keep the current state");
+}
+
+void test_copies_share_columns_until_written() {
+    std::mt19937 rng(2019);
+    std::uniform_int_distribution<int> levelDist(0, 255);
+    auto image = ImageUInt8::create(128, 160);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint8_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    tree_t tree(image, true, adj);
+    const tree_t reference(image, true, adj);
+    const std::size_t chunkBytes = ChunkedColumn<int>::ChunkSize * sizeof(int);
+    const std::size_t recordChunkBytes = ChunkedColumn<tree_t::NodeRecord>::ChunkSize * sizeof(tree_t::NodeRecord);
+
+    {
+        tree_t branch(tree);
+        require(branch.getExclusiveMemoryUsage() == 0 && tree.getExclusiveMemoryUsage() == 0, "a copy must share every chunk");
+
+        // A single-pixel move touches a handful of cells, so the branch must
+        // copy a handful of chunks instead of whole columns.
+        const NodeId rootId = branch.getRoot();
+        const NodeId childId = *branch.getChildren(rootId).begin();
+        branch.moveProperPart(childId, rootId, *branch.getProperParts(rootId).begin());
+        require(branch.getExclusiveMemoryUsage() > 0, "a write must detach its chunk");
+        require(branch.getExclusiveMemoryUsage() <= 2 * recordChunkBytes + 8 * chunkBytes, "a write must only detach the chunks it touches");
+        require(tree.getExclusiveMemoryUsage() == branch.getExclusiveMemoryUsage(), "the source must keep the detached chunks to itself");
+        require_tree_consistency(branch);
+        require_same_representation(reference, tree);
+        require(!branch.reconstructionImage()->isEqual(image), "the branch must see its own write");
+    }
+
+    // Once the branch is gone the source owns every chunk again and writes in place.
+    const std::size_t exclusive = tree.getExclusiveMemoryUsage();
+    tree.pruneNode(*tree.getChildren(tree.getRoot()).begin());
+    require(tree.getExclusiveMemoryUsage() == exclusive && tree.getNumNodes() < reference.getNumNodes(), "an unshared tree must write in place");
+    require_tree_consistency(tree);
+}
+
+void test_narrow_index_tree_matches_full_width_tree() {
+    using narrow_tree_t = BasicDynamicComponentTree<int16_t>;
+    static_assert(sizeof(tree_t::NodeRecord) == 32 && sizeof(narrow_tree_t::NodeRecord) == 16,
+                  "a node record must take 8 indices");
+    std::mt19937 rng(2020);
+    std::uniform_int_distribution<int> levelDist(0, 255);
+    auto image = ImageUInt8::create(120, 160);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint8_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    tree_t wide(image, true, adj);
+    narrow_tree_t narrow(image, true, adj);
+    require_same_representation(wide, narrow);
+
+    // The documented target: 14 indices per pixel, plus one chunk per column
+    // of rounding and the chunk tables.
+    const std::size_t numPixels = (std::size_t) image->getSize();
+    const auto target = [numPixels](std::size_t indexBytes) {
+        const std::size_t rounding = ChunkedColumn<int>::ChunkSize * (8 + 2 + 3) * indexBytes;
+        return 14 * indexBytes * numPixels + rounding + 4096;
+    };
+    require(wide.getMemoryUsage() <= target(sizeof(int32_t)), "a 32-bit tree must stay within its bytes-per-pixel target");
+    require(narrow.getMemoryUsage() <= target(sizeof(int16_t)), "a 16-bit tree must stay within its bytes-per-pixel target");
+    require(2 * narrow.getMemoryUsage() <= wide.getMemoryUsage() + 4096, "16-bit indices must halve the columns");
+
+    // Edits, rollback and compaction must agree with the 32-bit tree.
+    const auto edit = [](auto &tree) {
+        NodeId nodeId = tree.getRoot();
+        while (!tree.isLeaf(nodeId)) {
+            nodeId = *tree.getChildren(nodeId).begin();
+        }
+        const NodeId parentId = tree.getNodeParent(nodeId);
+        tree.pruneNode(nodeId);
+        if (parentId != tree.getRoot()) {
+            tree.mergeNodeIntoParent(parentId);
+        }
+    };
+    narrow.setCheckpoint();
+    edit(narrow);
+    narrow.rollbackToCheckpoint();
+    narrow.clearCheckpoint();
+    require_same_representation(wide, narrow);
+    for (int step = 0; step < 3; ++step) {
+        edit(wide);
+        edit(narrow);
+    }
+    require_same_representation(wide, narrow);
+    require(wide.compact() == narrow.compact(), "both widths must compact to the same ids");
+    require_same_representation(wide, narrow);
+
+    // Snapshots keep 32-bit ids on disk, so they load into either width.
+    std::stringstream fromNarrow;
+    narrow.writeSnapshot(fromNarrow);
+    tree_t wideLoaded;
+    wideLoaded.readSnapshot(fromNarrow);
+    require_same_representation(narrow, wideLoaded);
+    std::stringstream fromWide;
+    wide.writeSnapshot(fromWide);
+    narrow_tree_t narrowLoaded;
+    narrowLoaded.readSnapshot(fromWide);
+    require_same_representation(wide, narrowLoaded);
+    require(narrowLoaded.reconstructionImage()->isEqual(wide.reconstructionImage()), "a 16-bit tree must reconstruct a loaded 32-bit snapshot");
+
+    bool threw = false;
+    try {
+        narrow.setLazyProperPartOwnership(true);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    require(threw && !narrow.isLazyProperPartOwnership(), "lazy ownership must require 32-bit indices");
+
+    auto large = ImageUInt8::create(200, 200, 0);
+    auto largeAdj = std::make_shared<AdjacencyRelation>(large->getNumRows(), large->getNumCols(), 1.5);
+    threw = false;
+    try {
+        narrow_tree_t tooLarge(large, true, largeAdj);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    require(threw, "a 16-bit tree must reject images with more pixels than its index can address");
+    std::stringstream largeSnapshot;
+    tree_t(large, true, largeAdj).writeSnapshot(largeSnapshot);
+    threw = false;
+    try {
+        narrow.readSnapshot(largeSnapshot);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    require(threw, "a 16-bit tree must reject snapshots of images too large for its index");
+    require_same_representation(wide, narrow);
+}
+
+void test_memory_usage_follows_optional_structures() {
+    std::mt19937 rng(20260);
+    std::uniform_int_distribution<int> levelDist(0, 65535);
+    auto image = ImageUInt16::create(33, 29);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint16_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    for (bool isMaxtree : {true, false}) {
+        tree_t tree(image, isMaxtree, adj);
+        const std::size_t numPixels = (std::size_t) image->getSize();
+        const std::size_t baseline = tree.getMemoryUsage();
+        const auto altitudes = tree.getAltitudes();
+        require(*std::max_element(altitudes.begin(), altitudes.end()) == *std::max_element(image->rawData(), image->rawData() + numPixels),
+                "narrow altitudes must keep the full 16-bit range");
+
+        // The optional structures must show up in the report while they hold
+        // memory, and lazy ownership must give its tables back when disabled.
+        tree.setTrackPixelChanges(true);
+        const std::size_t withChangeLog = tree.getMemoryUsage();
+        require(withChangeLog >= baseline + 4 * numPixels, "the change log must be reported");
+        tree.setLazyProperPartOwnership(true);
+        const std::size_t withLazyOwnership = tree.getMemoryUsage();
+        require(withLazyOwnership > withChangeLog, "the lazy-ownership tables must be reported");
+        tree.setLazyProperPartOwnership(false);
+        require(tree.getMemoryUsage() == withChangeLog, "disabling lazy ownership must release its tables");
+        tree.setCheckpoint();
+        tree.pruneNode(*tree.getChildren(tree.getRoot()).begin());
+        require(tree.getMemoryUsage() > withChangeLog, "the undo journal must be reported");
+    }
+}
+
+void test_compact_renumbers_live_nodes_breadth_first() {
+    auto image = make_demo_image();
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    tree_t tree(image, true, adj);
+    tree.setTrackPixelChanges(true);
+    auto live = ImageUInt8::create(image->getNumRows(), image->getNumCols());
+    tree.updateReconstructionImage(*live);
+    for (int i = 0; i < 3 && tree.getNumNodes() > 1; ++i) {
+        NodeId leafId = tree.getRoot();
+        while (!tree.isLeaf(leafId)) {
+            leafId = *tree.getChildren(leafId).begin();
+        }
+        tree.pruneNode(leafId);
+    }
+    const auto expected = tree.reconstructionImage();
+    const int numSlots = tree.getNumInternalNodeSlots();
+    const int numNodes = tree.getNumNodes();
+    require(tree.getNumFreeNodeSlots() == numSlots - numNodes, "pruned slots must wait in the free pool");
+
+    std::vector<NodeId> oldParents(tree.getNodeParents().begin(), tree.getNodeParents().end());
+    std::vector<int> oldAltitudes(tree.getAltitudes().begin(), tree.getAltitudes().end());
+    std::vector<int> oldNumProperParts(tree.getNumProperPartsByNode().begin(), tree.getNumProperPartsByNode().end());
+    const NodeId oldRoot = tree.getRoot();
+    tree.setCheckpoint();
+    const std::vector<NodeId> newIdOf = tree.compact();
+
+    require((int) newIdOf.size() == numSlots, "the remap must cover the old id space");
+    require(tree.getNumInternalNodeSlots() == numNodes && tree.getNumFreeNodeSlots() == 0, "compaction must drop every free slot");
+    require(tree.getRoot() == 0 && newIdOf[oldRoot] == 0, "the root must become node 0");
+    require(!tree.hasCheckpoint(), "compaction must discard the checkpoint");
+    require_tree_consistency(tree);
+    for (NodeId oldId = 0; oldId < numSlots; ++oldId) {
+        const NodeId newId = newIdOf[oldId];
+        require((newId != InvalidNode) == (oldParents[oldId] != InvalidNode), "exactly the live nodes must be renumbered");
+        if (newId == InvalidNode) {
+            continue;
+        }
+        require(tree.getAltitude(newId) == oldAltitudes[oldId] && tree.getNumProperParts(newId) == oldNumProperParts[oldId],
+                "a renumbered node must keep its level and proper parts");
+        if (oldId != oldRoot) {
+            require(tree.getNodeParent(newId) == newIdOf[oldParents[oldId]], "renumbering must preserve parents");
+            require(tree.getNodeParent(newId) < newId, "breadth-first ids must place parents before children");
+        }
+    }
+    require(tree.reconstructionImage()->isEqual(expected), "compaction must not change the represented image");
+    tree.updateReconstructionImage(*live);
+    require(live->isEqual(expected), "the change log must survive compaction");
+
+    tree_t::applyNodeRemap(newIdOf, oldNumProperParts);
+    const auto numProperParts = tree.getNumProperPartsByNode();
+    require(std::equal(numProperParts.begin(), numProperParts.end(), oldNumProperParts.begin(), oldNumProperParts.end()),
+            "applyNodeRemap must move buffer entries to the new ids");
+
+    tree.pruneNode(*tree.getChildren(tree.getRoot()).begin());
+    require_tree_consistency(tree);
+}
+
+void test_relayout_orders_proper_parts_by_pixel_id() {
+    auto image = make_demo_image();
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    tree_t tree(image, false, adj);
+    while (tree.getNumNodes() > 2) {
+        tree.mergeNodeIntoParent(*tree.getChildren(tree.getRoot()).begin());
+    }
+    std::vector<NodeId> owners(tree.getSmallestComponents().begin(), tree.getSmallestComponents().end());
+    std::vector<int> numProperParts(tree.getNumProperPartsByNode().begin(), tree.getNumProperPartsByNode().end());
+    const auto expected = tree.reconstructionImage();
+
+    tree.relayoutProperParts();
+    require_tree_consistency(tree);
+    require(std::equal(owners.begin(), owners.end(), tree.getSmallestComponents().begin()), "relayout must keep every owner");
+    require(std::equal(numProperParts.begin(), numProperParts.end(), tree.getNumProperPartsByNode().begin()), "relayout must keep the counts");
+    require(tree.reconstructionImage()->isEqual(expected), "relayout must not change the represented image");
+    for (NodeId nodeId = 0; nodeId < tree.getNumInternalNodeSlots(); ++nodeId) {
+        if (!tree.isAlive(nodeId)) {
+            continue;
+        }
+        PixelId previous = InvalidNode;
+        int count = 0;
+        for (PixelId pixelId : tree.getProperParts(nodeId)) {
+            require(pixelId > previous, "relayout must list proper parts in increasing pixel order");
+            previous = pixelId;
+            count++;
+        }
+        require(count == tree.getNumProperParts(nodeId), "relayout must keep every proper part listed");
+    }
+
+    tree.pruneNode(*tree.getChildren(tree.getRoot()).begin());
+    require_tree_consistency(tree);
+    require(tree.getNumNodes() == 1, "a relaid-out tree must stay editable");
+}
+
+void test_snapshot_round_trip_restores_edited_tree() {
+    auto image = make_demo_image();
+    const std::vector<AdjacencyRelation::Offset> cross = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-2, 0}, {2, 0}};
+    for (auto adj : {std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5),
+                     std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), cross)}) {
+        tree_t tree(image, false, adj);
+        tree.pruneNode(*tree.getChildren(tree.getRoot()).begin());
+        std::stringstream snapshot;
+        tree.writeSnapshot(snapshot);
+
+        tree_t loaded;
+        loaded.readSnapshot(snapshot);
+        require_same_representation(tree, loaded);
+        require(loaded.getNumFreeNodeSlots() == tree.getNumFreeNodeSlots(), "a snapshot must restore the free-id pool");
+        require(loaded.getAdjacencyRelation()->getRadius() == adj->getRadius() && loaded.getAdjacencyRelation()->getSize() == adj->getSize(),
+                "a snapshot must restore the adjacency stencil");
+        require(loaded.reconstructionImage()->isEqual(tree.reconstructionImage()), "a loaded tree must reconstruct the saved image");
+        const NodeId reusedId = loaded.allocateNode();
+        require(reusedId != InvalidNode && reusedId == tree.allocateNode(), "a loaded tree must reuse slots in the saved order");
+        loaded.releaseNode(reusedId);
+        require_tree_consistency(loaded);
+
+        const std::string bytes = snapshot.str();
+        std::stringstream truncated(bytes.substr(0, bytes.size() / 2));
+        tree_t untouched(image, true, adj);
+        bool threw = false;
+        try {
+            untouched.readSnapshot(truncated, adj);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        require(threw, "a truncated snapshot must be rejected");
+        require_same_representation(tree_t(image, true, adj), untouched);
+
+        std::stringstream foreign("not a snapshot at all");
+        threw = false;
+        try {
+            untouched.readSnapshot(foreign);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        require(threw, "a stream without the snapshot tag must be rejected");
+    }
+}
+
+void test_tampered_snapshot_is_rejected() {
+    // A snapshot with valid column lengths but forged ids or counts must be
+    // rejected before the ids are used, leaving the target tree untouched.
+    std::mt19937 rng(23);
+    auto image = ImageUInt8::create(9, 11);
+    std::uniform_int_distribution<int> levelDist(0, 5);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint8_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.5);
+    tree_t tree(image, true, adj);
+    NodeId leafId = tree.getRoot();
+    while (!tree.isLeaf(leafId)) {
+        leafId = *tree.getChildren(leafId).begin();
+    }
+    tree.pruneNode(leafId);
+    std::stringstream snapshot;
+    tree.writeSnapshot(snapshot);
+    const std::string bytes = snapshot.str();
+
+    // Byte layout written by writeSnapshot: a 16-byte header, 40 bytes of
+    // scalar fields, the stencil, then every column as a 64-bit count
+    // followed by its values.
+    const std::size_t numSlots = (std::size_t) tree.getNumInternalNodeSlots();
+    const std::size_t numPixels = (std::size_t) image->getSize();
+    const std::size_t numSlotsField = 16 + 24;
+    const std::size_t numOffsetValuesField = 16 + 40;
+    const std::vector<std::size_t> columnBytes = {
+        2 * numSlots, 4 * (std::size_t) tree.getNumFreeNodeSlots(),
+        4 * numSlots, 4 * numSlots, 4 * numSlots, 4 * numSlots, 4 * numSlots, 4 * numSlots, 4 * numSlots, 4 * numSlots, 4 * numSlots,
+        4 * numPixels, 4 * numPixels, 4 * numPixels};
+    enum Column { Altitude, FreeIds, Parent, FirstChild, LastChild, NextSibling, PrevSibling, NumChildren, ProperHead, ProperTail, NumProperParts, Owner, NextPixel, PrevPixel };
+    const auto valueOffset = [&](Column column, std::size_t index) {
+        std::size_t offset = numOffsetValuesField + 8 + 4 * 2 * (std::size_t) adj->getSize();
+        for (int i = 0; i < column; ++i) {
+            offset += 8 + columnBytes[i];
+        }
+        return offset + 8 + 4 * index;
+    };
+    const auto tampered = [&](std::size_t offset, auto value) {
+        std::string copy = bytes;
+        std::memcpy(copy.data() + offset, &value, sizeof(value));
+        return copy;
+    };
+    const auto edited = [&](std::initializer_list<std::pair<std::size_t, int32_t>> edits) {
+        std::string copy = bytes;
+        for (const auto &[offset, value] : edits) {
+            std::memcpy(copy.data() + offset, &value, sizeof(value));
+        }
+        return copy;
+    };
+
+    const NodeId rootId = tree.getRoot();
+    require(tree.getNumFreeNodeSlots() > 0 && tree.getNumChildren(rootId) > 0, "the fixture must release a slot and keep a child of the root");
+    const NodeId childId = *tree.getChildren(rootId).begin();
+    std::vector<PixelId> rootPixels;
+    for (PixelId pixelId : tree.getProperParts(rootId)) {
+        rootPixels.push_back(pixelId);
+    }
+    require(rootPixels.size() >= 2, "the fixture root must own at least two proper parts");
+    // Unlinks the last proper part of the root with every list still
+    // self-consistent, so only the pixel-coverage checks can notice.
+    const PixelId orphanId = rootPixels.back();
+    const PixelId newTailId = rootPixels[rootPixels.size() - 2];
+    const std::pair<std::size_t, int32_t> dropCount = {valueOffset(NumProperParts, (std::size_t) rootId), (int32_t) rootPixels.size() - 1};
+    const std::pair<std::size_t, int32_t> moveTail = {valueOffset(ProperTail, (std::size_t) rootId), (int32_t) newTailId};
+    const std::pair<std::size_t, int32_t> cutLink = {valueOffset(NextPixel, (std::size_t) newTailId), (int32_t) InvalidNode};
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"a node count larger than the image", tampered(numSlotsField, (uint64_t) 1 << 40)},
+        {"a stencil larger than the image", tampered(numOffsetValuesField, (uint64_t) 1 << 40)},
+        {"a parent out of range", tampered(valueOffset(Parent, (std::size_t) childId), (int32_t) 1000000)},
+        {"a sibling link out of range", tampered(valueOffset(NextSibling, (std::size_t) childId), (int32_t) -7)},
+        {"a sibling cycle", tampered(valueOffset(NextSibling, (std::size_t) childId), (int32_t) childId)},
+        {"a free id naming a live node", tampered(valueOffset(FreeIds, 0), (int32_t) rootId)},
+        {"a pixel owner out of range", tampered(valueOffset(Owner, 0), (int32_t) numSlots)},
+        {"a proper-part link out of range", tampered(valueOffset(NextPixel, 0), (int32_t) numPixels)},
+        {"a proper-part count that disagrees with its list", tampered(valueOffset(NumProperParts, (std::size_t) rootId), (int32_t) numPixels)},
+        {"an orphan pixel", edited({dropCount, moveTail, cutLink})},
+        {"a pixel owner equal to InvalidNode", edited({dropCount, moveTail, cutLink, {valueOffset(Owner, (std::size_t) orphanId), (int32_t) InvalidNode}})},
+    };
+    for (const auto &[problem, forged] : cases) {
+        tree_t untouched(image, false, adj);
+        std::stringstream in(forged);
+        bool threw = false;
+        try {
+            untouched.readSnapshot(in);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        require(threw, "a snapshot with " + problem + " must be rejected");
+        require_same_representation(tree_t(image, false, adj), untouched);
+    }
+
+    std::stringstream intact(bytes);
+    tree_t loaded;
+    loaded.readSnapshot(intact);
+    require_same_representation(tree, loaded);
+}
+
+void test_lazy_ownership_matches_eager_ownership() {
+    std::mt19937 rng(24);
+    auto image = ImageUInt8::create(19, 21);
+    std::uniform_int_distribution<int> levelDist(0, 7);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint8_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.0);
+    for (bool isMaxtree : {true, false}) {
+        tree_t eager(image, isMaxtree, adj);
+        tree_t lazy(image, isMaxtree, adj);
+        lazy.setLazyProperPartOwnership(true);
+        bool threw = false;
+        try {
+            (void) lazy.getSmallestComponents();
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        require(threw, "the owner column view must be refused under lazy ownership");
+
+        // Ping-pong moves between two nodes create a block per move and
+        // force the block forest to be flattened several times.
+        const NodeId nodeA = *eager.getChildren(eager.getRoot()).begin();
+        const NodeId nodeB = eager.getRoot();
+        for (int i = 0; i < 3 * image->getSize(); ++i) {
+            for (tree_t *tree : {&eager, &lazy}) {
+                tree->moveProperPart(nodeA, nodeB, *tree->getProperParts(nodeB).begin());
+                tree->moveProperParts(nodeB, nodeA);
+            }
+        }
+        require_same_representation(eager, lazy);
+
+        lazy.setCheckpoint();
+        const auto beforeEdits = lazy.reconstructionImage();
+        while (eager.getNumNodes() > 1) {
+            const NodeId childId = *eager.getChildren(eager.getRoot()).begin();
+            if (eager.isLeaf(childId)) {
+                eager.pruneNode(childId);
+                lazy.pruneNode(childId);
+            } else {
+                eager.mergeNodeIntoParent(childId);
+                lazy.mergeNodeIntoParent(childId);
+            }
+            require_tree_consistency(lazy);
+            require_same_representation(eager, lazy);
+            require(lazy.reconstructionImage()->isEqual(eager.reconstructionImage()), "lazy reconstruction must match eager reconstruction");
+        }
+        lazy.rollbackToCheckpoint();
+        require_tree_consistency(lazy);
+        require(lazy.reconstructionImage()->isEqual(beforeEdits), "rollback must restore lazy ownership");
+
+        std::stringstream snapshot;
+        lazy.writeSnapshot(snapshot);
+        tree_t loaded;
+        loaded.readSnapshot(snapshot);
+        require_same_representation(lazy, loaded);
+        lazy.setLazyProperPartOwnership(false);
+        require_same_representation(loaded, lazy);
+        require(std::equal(lazy.getSmallestComponents().begin(), lazy.getSmallestComponents().end(), loaded.getSmallestComponents().begin()),
+                "returning to eager ownership must store node ids again");
+    }
+}
+
+void test_lazy_owner_lookups_compress_paths_safely() {
+    // Non-const lookups halve the block paths they walk. The shortcuts must
+    // never change an owner, and must not be taken under a checkpoint, where
+    // a rollback could strand them.
+    std::mt19937 rng(26);
+    auto image = ImageUInt8::create(15, 18);
+    std::uniform_int_distribution<int> levelDist(0, 5);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint8_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.0);
+    tree_t eager(image, true, adj);
+    tree_t lazy(image, true, adj);
+    lazy.setLazyProperPartOwnership(true);
+
+    auto requireSameOwners = [&](const std::string &message) {
+        for (PixelId pixelId = 0; pixelId < lazy.getNumTotalProperParts(); ++pixelId) {
+            require(lazy.getSmallestComponent(pixelId) == eager.getSmallestComponent(pixelId), message);
+        }
+    };
+    // Alternating merges of three nodes chain blocks of equal rank.
+    const NodeId rootId = eager.getRoot();
+    const NodeId nodeA = *eager.getChildren(rootId).begin();
+    for (int i = 0; i < 40; ++i) {
+        for (tree_t *tree : {&eager, &lazy}) {
+            tree->moveProperPart(nodeA, rootId, *tree->getProperParts(rootId).begin());
+            tree->moveProperParts(rootId, nodeA);
+        }
+        requireSameOwners("compressing lookups must resolve the same owners");
+    }
+    requireSameOwners("repeated lookups must resolve the same owners after compression");
+
+    const auto beforeEdits = eager.reconstructionImage<uint8_t>();
+    lazy.setCheckpoint();
+    for (int i = 0; i < 10; ++i) {
+        lazy.moveProperPart(nodeA, rootId, *lazy.getProperParts(rootId).begin());
+        lazy.moveProperParts(rootId, nodeA);
+        for (PixelId pixelId = 0; pixelId < lazy.getNumTotalProperParts(); ++pixelId) {
+            (void) lazy.getSmallestComponent(pixelId);
+        }
+    }
+    lazy.rollbackToCheckpoint();
+    lazy.clearCheckpoint();
+    requireSameOwners("lookups under a checkpoint must not survive its rollback");
+    require(lazy.reconstructionImage<uint8_t>()->isEqual(beforeEdits), "rollback must restore the lazy reconstruction");
+
+    // Every pixel is written, whatever the target held before.
+    auto reused = ImageUInt8::create(image->getNumRows(), image->getNumCols(), 255);
+    lazy.reconstructionImage(*reused);
+    require(reused->isEqual(beforeEdits), "lazy reconstruction must overwrite every pixel of the target");
+}
+
+void test_lazy_rollback_releases_owner_blocks() {
+    // The block forest is not flattened under a checkpoint, so a search that
+    // repeatedly edits and rolls back must get the appended blocks back.
+    std::mt19937 rng(27);
+    auto image = ImageUInt8::create(12, 13);
+    std::uniform_int_distribution<int> levelDist(0, 5);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint8_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.0);
+    tree_t lazy(image, true, adj);
+    lazy.setLazyProperPartOwnership(true);
+    const tree_t reference(image, true, adj);
+    const NodeId rootId = lazy.getRoot();
+    const NodeId nodeA = *lazy.getChildren(rootId).begin();
+
+    lazy.setCheckpoint();
+    std::size_t memoryAfterFirstRollback = 0;
+    for (int round = 0; round < 50; ++round) {
+        for (int i = 0; i < 20; ++i) {
+            lazy.moveProperPart(nodeA, rootId, *lazy.getProperParts(rootId).begin());
+            lazy.moveProperParts(rootId, nodeA);
+        }
+        lazy.rollbackToCheckpoint();
+        if (round == 0) {
+            memoryAfterFirstRollback = lazy.getMemoryUsage();
+        }
+        require(lazy.getMemoryUsage() == memoryAfterFirstRollback, "rolled-back owner blocks must be reused by the next round");
+    }
+    require_tree_consistency(lazy);
+    require_same_representation(reference, lazy);
+}
+
+void collect_preorder_recursively(const tree_t &tree, NodeId nodeId, std::vector<NodeId> &order) {
+    order.push_back(nodeId);
+    for (NodeId childId : tree.getChildren(nodeId)) {
+        collect_preorder_recursively(tree, childId, order);
+    }
+}
+
+void test_traversals_match_reference_orders_for_every_subtree() {
+    // The stackless DFS and the workspace-backed BFS must agree with the
+    // reference orders for every subtree, not only for the root.
+    std::mt19937 rng(25);
+    auto image = ImageUInt8::create(13, 17);
+    std::uniform_int_distribution<int> levelDist(0, 9);
+    for (int pixelId = 0; pixelId < image->getSize(); ++pixelId) {
+        (*image)[pixelId] = (uint8_t) levelDist(rng);
+    }
+    auto adj = std::make_shared<AdjacencyRelation>(image->getNumRows(), image->getNumCols(), 1.0);
+    tree_t tree(image, true, adj);
+    for (int i = 0; i < 5; ++i) {
+        tree.mergeNodeIntoParent(*tree.getChildren(tree.getRoot()).begin());
+    }
+    require_tree_consistency(tree);
+
+    FastQueue<NodeId> workspace;
+    std::vector<NodeId> expectedDepthFirst;
+    std::vector<NodeId> expectedBreadthFirst;
+    for (NodeId nodeId = 0; nodeId < tree.getNumInternalNodeSlots(); ++nodeId) {
+        if (!tree.isAlive(nodeId)) {
+            continue;
+        }
+        expectedDepthFirst.clear();
+        collect_preorder_recursively(tree, nodeId, expectedDepthFirst);
+        require(collect_range(tree.getNodeSubtree(nodeId)) == expectedDepthFirst, "stackless DFS must visit the subtree in pre-order");
+        require(tree.countDescendants(nodeId) == (int) expectedDepthFirst.size() - 1, "descendant count must match the subtree size");
+
+        tree.collectBreadthFirstOrder(nodeId, expectedBreadthFirst);
+        require(collect_range(tree.getIteratorBreadthFirstTraversal(nodeId, workspace)) == expectedBreadthFirst,
+                "workspace BFS must match the collected breadth-first order");
+        require(collect_range(tree.getIteratorBreadthFirstTraversal(nodeId)) == expectedBreadthFirst,
+                "owning BFS must match the collected breadth-first order");
+    }
+}
+
 } // namespace
 
 int main() {
@@ -438,6 +1336,25 @@ int main() {
         test_subtree_traversal_tracks_mutated_topology();
         test_root_and_node_slot_reuse();
         test_remove_child_with_release_node_removes_empty_leaf_slot();
+        test_tiled_parallel_build_matches_serial_build();
+        test_min_max_pair_build_matches_independent_builds();
+        test_rebuild_with_workspace_reuses_scratch_and_matches_fresh_build();
+        test_uint16_builds_match_8bit_builds_and_reconstruct();
+        test_image_view_borrows_buffer_and_builds_like_owned_image();
+        test_bulk_views_match_per_node_accessors();
+        test_incremental_reconstruction_tracks_only_changed_pixels();
+        test_checkpoint_rollback_restores_edited_tree();
+        test_memory_usage_follows_optional_structures();
+        test_copies_share_columns_until_written();
+        test_narrow_index_tree_matches_full_width_tree();
+        test_compact_renumbers_live_nodes_breadth_first();
+        test_relayout_orders_proper_parts_by_pixel_id();
+        test_snapshot_round_trip_restores_edited_tree();
+        test_tampered_snapshot_is_rejected();
+        test_lazy_ownership_matches_eager_ownership();
+        test_lazy_owner_lookups_compress_paths_safely();
+        test_lazy_rollback_releases_owner_blocks();
+        test_traversals_match_reference_orders_for_every_subtree();
     } catch (const std::exception &e) {
         std::cerr << "dynamic_component_tree_unit_tests: FAIL\n" << e.what() << "\n";
         return 1;
@@ -0,0 +1,118 @@
+"""Smoke test of the installed Python bindings.
+
+Run against an installed wheel, not the source tree:
+    python unit-tests/python/bindings_smoke_test.py
+"""
+
+import os
+import tempfile
+import threading
+
+import numpy as np
+
+import morphoTreeAdjust as mta
+
+
+def make_image(seed, shape=(24, 31), dtype=np.uint8, levels=9):
+    rng = np.random.default_rng(seed)
+    return rng.integers(0, levels, size=shape).astype(dtype)
+
+
+def test_tree_round_trip():
+    image = make_image(1)
+    tree = mta.DynamicComponentTree(image, True, 1.5)
+    assert np.array_equal(tree.reconstructionImage(), image)
+    assert tree.numRows == image.shape[0] and tree.numCols == image.shape[1]
+    assert len(tree.nodes) == tree.numNodes
+    assert tree.getSmallestComponents().shape == (image.size,)
+
+    leaf = next(node for node in tree.breadthFirstTraversal() if tree.isLeaf(node) and node != tree.root)
+    tree.setCheckpoint()
+    tree.moveProperParts(tree.getNodeParent(leaf), leaf)
+    tree.rollbackToCheckpoint()
+    tree.clearCheckpoint()
+    assert np.array_equal(tree.reconstructionImage(), image)
+
+    with tempfile.TemporaryDirectory() as directory:
+        path = os.path.join(directory, "tree.mta")
+        tree.saveSnapshot(path)
+        loaded = mta.DynamicComponentTree.loadSnapshot(path)
+    assert np.array_equal(loaded.reconstructionImage(), image)
+
+
+def test_read_only_input_is_copied():
+    image = make_image(2)
+    image.setflags(write=False)
+    tree = mta.DynamicComponentTree(image, False)
+    assert np.array_equal(tree.reconstructionImage(), image)
+
+
+def test_dual_filter_prunes_both_trees():
+    image = make_image(3)
+    maxtree, mintree = mta.DynamicComponentTree.createMinMaxTrees(image, 1.5)
+    adjust = mta.DualMinMaxTreeIncrementalFilter(mintree, maxtree)
+    adjust.pruneMaxTreeAndUpdateMinTree(maxtree.getNodesThreshold(20))
+    assert np.array_equal(adjust.maxTree.reconstructionImage(), adjust.minTree.reconstructionImage())
+
+
+def test_casf_modes_agree():
+    for dtype in (np.uint8, np.uint16):
+        image = make_image(4, dtype=dtype, levels=300 if dtype == np.uint16 else 9)
+        thresholds = [4, 16, 64]
+        updating = mta.ComponentTreeCasf(image).filter(thresholds, "updating")
+        naive = mta.ComponentTreeCasf(image).filter(thresholds, "naive")
+        assert updating.dtype == dtype
+        assert np.array_equal(updating, naive)
+
+
+def test_casf_trees_and_forks():
+    image = make_image(5)
+    runner = mta.ComponentTreeCasf(image)
+    fork = runner.fork()
+    expected = runner.filter([8, 32])
+    assert np.array_equal(fork.filter([8, 32]), expected)
+    assert np.array_equal(runner.maxTree.reconstructionImage(), expected)
+    tree = runner.getMinTree()
+    del runner
+    assert np.array_equal(tree.reconstructionImage(), expected)
+
+
+def test_filter_batch_keeps_each_dtype():
+    images = [make_image(6), make_image(7, dtype=np.uint16, levels=300)]
+    outputs = mta.ComponentTreeCasf.filterBatch(images, [4, 16], numThreads=2)
+    assert [output.dtype for output in outputs] == [np.uint8, np.uint16]
+
+
+def test_tree_reads_wait_for_runner():
+    image = make_image(8, shape=(96, 96))
+    runner = mta.ComponentTreeCasf(image)
+    tree = runner.maxTree
+    errors = []
+
+    def filter_runner():
+        try:
+            runner.filter(list(range(2, 400, 7)))
+        except Exception as error:  # pragma: no cover
+            errors.append(error)
+
+    def read_tree():
+        try:
+            for _ in range(200):
+                assert len(tree.nodes) >= 1
+        except Exception as error:  # pragma: no cover
+            errors.append(error)
+
+    threads = [threading.Thread(target=filter_runner), threading.Thread(target=read_tree)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert not errors, errors
+
+
+if __name__ == "__main__":
+    tests = [value for name, value in sorted(globals().items()) if name.startswith("test_")]
+    for test in tests:
+        test()
+        print(f"{test.__name__}: PASS")
+    print("bindings smoke test: OK")